@@ -34,7 +34,7 @@ class IFSFuse3Provider {
             throw new Error('Already running');
         }
 
-        console.log(`[IFSFuse3Provider] Starting FUSE3 mount at ${mountPoint || this.virtualRoot}`);
+        this.log(`Starting FUSE3 mount at ${mountPoint || this.virtualRoot}`);
         const actualMountPoint = mountPoint || this.virtualRoot;
 
         // Create FUSE operations
@@ -54,20 +54,19 @@ class IFSFuse3Provider {
         });
 
         // Mount the filesystem
-        console.log('[IFSFuse3Provider] Calling fuse.mount()...');
+        this.log('Calling fuse.mount()...');
         await new Promise((resolve, reject) => {
             this.fuse.mount((err) => {
                 if (err) {
-                    console.log('[IFSFuse3Provider] Mount failed:', err);
+                    this.log('Mount failed:', err);
                     reject(err);
                 } else {
                     this.running = true;
-                    console.log('[IFSFuse3Provider] Mount successful!');
+                    this.log('Mount successful');
                     resolve();
                 }
             });
         });
-        console.log('[IFSFuse3Provider] Mount promise resolved');
     }
 
     /**
@@ -103,14 +102,11 @@ class IFSFuse3Provider {
      * FUSE getattr operation - get file/directory attributes
      */
     _getattr(filePath, callback) {
-        console.log('[JS] _getattr called:', filePath);
         this.log('getattr:', filePath);
 
         (async () => {
             try {
-                console.log('[JS] _getattr: calling fileSystem.stat()');
                 const stats = await this.fileSystem.stat(filePath);
-                console.log('[JS] _getattr: stat returned:', stats);
 
                 // IFileSystem returns mode directly (e.g., 0o40755 for directories)
                 // Use the mode from IFileSystem as-is
@@ -124,17 +120,13 @@ class IFSFuse3Provider {
                     ctime: stats.ctime || new Date()
                 };
 
-                console.log('[JS] _getattr: calling callback with success');
                 this.log('getattr success:', filePath, fuseStats);
                 callback(null, fuseStats);
-                console.log('[JS] _getattr: callback completed');
             } catch (error) {
-                console.log('[JS] _getattr: error:', error.message);
                 this.log('getattr error:', filePath, error.message);
                 callback(ENOENT);
             }
         })();
-        console.log('[JS] _getattr returned (async work pending)');
     }
 
     /**
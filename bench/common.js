@@ -0,0 +1,92 @@
+/**
+ * Shared plumbing for the end-to-end benchmarks: mounting a provider in a
+ * temporary directory and driving it with the native load generator.
+ */
+
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { execFile } from 'child_process';
+import { fileURLToPath } from 'url';
+import Fuse from '../index.js';
+
+const ROOT = path.join(path.dirname(fileURLToPath(import.meta.url)), '..');
+export const LOADGEN = path.join(ROOT, 'build', 'Release', 'fuse3_loadgen');
+
+export function mount(handlers, options = {}) {
+  const mountPoint = fs.mkdtempSync(path.join(os.tmpdir(), 'fuse3-bench-'));
+  const fuse = new Fuse(mountPoint, handlers, options);
+  return new Promise((resolve, reject) => {
+    fuse.mount((err) => (err ? reject(err) : resolve({ fuse, mountPoint })));
+  });
+}
+
+export function unmount({ fuse, mountPoint }) {
+  return new Promise((resolve) => {
+    fuse.unmount(() => {
+      fs.rmdirSync(mountPoint);
+      resolve();
+    });
+  });
+}
+
+/**
+ * Run fuse3_loadgen with the given arguments and return its JSON report.
+ * Asynchronous on purpose: the event loop has to keep serving the mount.
+ */
+export function loadgen(args) {
+  if (!fs.existsSync(LOADGEN)) {
+    throw new Error(`${LOADGEN} not found; build it with npm run build`);
+  }
+  return new Promise((resolve, reject) => {
+    execFile(LOADGEN, args, (err, stdout, stderr) => {
+      if (err && !stdout) {
+        reject(new Error(`fuse3_loadgen ${args.join(' ')}: ${stderr || err.message}`));
+      } else {
+        resolve(JSON.parse(stdout));
+      }
+    });
+  });
+}
+
+/**
+ * The mount's own view of a run: request counts and where the time went
+ */
+export function mountStats(fuse, ops) {
+  const stats = fuse.getStats();
+  const result = {};
+  for (const op of ops) {
+    const entry = stats.ops[op];
+    if (!entry) {
+      continue;
+    }
+    result[op] = {
+      count: entry.count,
+      // JS round trips, several for a writeback commit of many chunks
+      jsCalls: entry.jsCalls,
+      // Requests that went on to JS rather than being answered natively
+      jsRequests: entry.stages.js?.count ?? 0,
+      errors: entry.errors,
+      p50Us: entry.p50Us,
+      p99Us: entry.p99Us,
+      queueP99Us: entry.stages.queue?.p99Us ?? 0,
+      jsP99Us: entry.stages.js?.p99Us ?? 0
+    };
+  }
+  const { p99Us, episodes, staleAttrs } = stats.eventLoopLag;
+  return { ops: result, cache: stats.cache, eventLoopLag: { p99Us, episodes, staleAttrs } };
+}
+
+/**
+ * Jain's fairness index over per-caller or per-mount throughput: 1 when
+ * every one got the same share, 1/n when one got everything
+ */
+export function fairness(values) {
+  const sum = values.reduce((a, b) => a + b, 0);
+  const squares = values.reduce((a, b) => a + b * b, 0);
+  return squares > 0 ? (sum * sum) / (values.length * squares) : 1;
+}
+
+export function list(value) {
+  return value.split(',').filter(Boolean);
+}
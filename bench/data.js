@@ -0,0 +1,107 @@
+#!/usr/bin/env node
+
+/**
+ * Data-path benchmark: mounts synthetic content and measures sequential
+ * large-file reads, random block reads, many small files and mmap reads with
+ * the native load generator, for each openCache policy and thread count.
+ * Prints a JSON report.
+ *
+ *   node bench/data.js [--threads 1,4,16] [--duration 5]
+ *                      [--workloads seqread,randread,smallfiles,mmap]
+ *                      [--policies direct,page,keep]
+ *                      [--large-files 8] [--large-size 268435456]
+ *                      [--small-files 1000] [--small-size 10240]
+ *                      [--options '{...}'] [--out file]
+ */
+
+import fs from 'fs';
+import { parseArgs } from 'util';
+import { PerformanceObserver } from 'perf_hooks';
+import { SyntheticTree, combineTrees } from './synthetic-tree.js';
+import { mount, unmount, loadgen, mountStats, list } from './common.js';
+
+const { values: args } = parseArgs({
+  options: {
+    threads: { type: 'string', default: '1,4,16' },
+    duration: { type: 'string', default: '5' },
+    workloads: { type: 'string', default: 'seqread,randread,smallfiles,mmap' },
+    policies: { type: 'string', default: 'direct,page,keep' },
+    'large-files': { type: 'string', default: '8' },
+    'large-size': { type: 'string', default: String(256 << 20) },
+    'small-files': { type: 'string', default: '1000' },
+    'small-size': { type: 'string', default: String(10 << 10) },
+    options: { type: 'string', default: '{}' },
+    out: { type: 'string' }
+  }
+});
+
+const trees = {
+  large: new SyntheticTree({ depth: 0, files: Number(args['large-files']), fileSize: Number(args['large-size']) }),
+  small: new SyntheticTree({ depth: 0, files: Number(args['small-files']), fileSize: Number(args['small-size']) })
+};
+const workloadTree = { seqread: 'large', randread: 'large', mmap: 'large', smallfiles: 'small' };
+
+// Garbage collections while a run was going: the cost of the Buffers each read allocates
+const gc = { count: 0, ms: 0 };
+new PerformanceObserver((entries) => {
+  for (const entry of entries.getEntries()) {
+    gc.count++;
+    gc.ms += entry.duration;
+  }
+}).observe({ entryTypes: ['gc'] });
+
+const runs = [];
+for (const policy of list(args.policies)) {
+  const options = { ...JSON.parse(args.options), openCache: policy };
+  const mounted = await mount(combineTrees(trees), options);
+  try {
+    for (const workload of list(args.workloads)) {
+      const name = workloadTree[workload];
+      if (!name) {
+        throw new Error(`unknown workload ${workload}`);
+      }
+      const tree = trees[name];
+      for (const threads of list(args.threads)) {
+        console.error(`${policy}: ${workload} x ${threads} ...`);
+        mounted.fuse.resetStats();
+        gc.count = 0;
+        gc.ms = 0;
+        const cpuBefore = process.cpuUsage();
+
+        const result = await loadgen(['-w', workload, '-t', threads, '-d', args.duration,
+          '-D', '0', '-F', '1', '-f', String(tree.files), `${mounted.mountPoint}/${name}`]);
+
+        const cpu = process.cpuUsage(cpuBefore);
+        const mountCpuSeconds = (cpu.user + cpu.system) / 1e6;
+        const stats = mountStats(mounted.fuse, ['open', 'read', 'release']);
+        const jsReads = stats.ops.read?.jsCalls ?? 0;
+        runs.push({
+          policy,
+          ...result,
+          iops: result.opsPerSec,
+          mountCpuSeconds,
+          cpuSecondsPerGB: result.bytes ? (mountCpuSeconds + result.cpuSeconds) / (result.bytes / 1e9) : null,
+          jsReadsPerOp: result.ops ? jsReads / result.ops : 0,
+          gc: { count: gc.count, ms: gc.ms, perThousandJsReads: jsReads ? (gc.count * 1000) / jsReads : 0 },
+          mount: stats
+        });
+      }
+    }
+  } finally {
+    await unmount(mounted);
+  }
+}
+
+const report = {
+  benchmark: 'data',
+  files: {
+    large: { count: trees.large.files, size: trees.large.fileSize },
+    small: { count: trees.small.files, size: trees.small.fileSize }
+  },
+  runs
+};
+const json = JSON.stringify(report, null, 2);
+if (args.out) {
+  fs.writeFileSync(args.out, json);
+}
+console.log(json);
@@ -0,0 +1,86 @@
+#!/usr/bin/env node
+
+/**
+ * Dispatch microbenchmark: native threads call the FUSE operations in-process
+ * against trivial JS handlers, so no /dev/fuse or mount is needed. Measures
+ * round trips through the thread-safe function queue per operation.
+ *
+ *   node bench/dispatch.js [--threads 1,4,16] [--duration 2000]
+ *                          [--ops getattr,read] [--size 4096] [--json]
+ */
+
+import { parseArgs } from 'util';
+import Fuse from '../index.js';
+
+const { values: args } = parseArgs({
+  options: {
+    threads: { type: 'string', default: '1,2,4,8' },
+    duration: { type: 'string', default: '2000' },
+    ops: { type: 'string', default: 'getattr,access,readdir,open,read,write,statfs' },
+    size: { type: 'string', default: '4096' },
+    json: { type: 'boolean', default: false }
+  }
+});
+
+const now = Date.now();
+const handlers = {
+  getattr: (path, cb) => cb(null, { mode: 0o100644, size: 1 << 20, mtime: now, atime: now, ctime: now }),
+  access: (path, mode, cb) => cb(null),
+  readdir: (path, cb) => cb(null, ['a', 'b', 'c']),
+  open: (path, flags, cb) => cb(null, 3),
+  read: (path, fd, buffer, length, offset, cb) => cb(null, length),
+  write: (path, fd, buffer, length, offset, cb) => cb(null, length),
+  release: (path, fd, cb) => cb(null)
+};
+
+const fuse = new Fuse('/nonexistent/fuse3-bench', handlers);
+const threadCounts = args.threads.split(',').map(Number);
+const durationMs = Number(args.duration);
+const size = Number(args.size);
+const runs = [];
+
+for (const op of args.ops.split(',')) {
+  for (const threads of threadCounts) {
+    fuse.resetStats();
+    const result = await fuse.benchDispatch({ threads, durationMs, ops: [op], size });
+    const entry = result.ops[op];
+    // Where the time went, from the mount's own stage histograms
+    const stats = fuse.getStats().ops[op];
+    const stages = stats?.stages || {};
+    const run = {
+      op,
+      threads,
+      opsPerSec: entry.opsPerSec,
+      errors: entry.errors,
+      p50Us: entry.p50Us,
+      p99Us: entry.p99Us,
+      p999Us: entry.p999Us,
+      queueP99Us: stages.queue?.p99Us ?? 0,
+      jsP99Us: stages.js?.p99Us ?? 0
+    };
+    // Builds with -Dfuse3_alloc_stats=1 also count native allocations per request
+    if (Fuse.allocationStatsEnabled && stats) {
+      run.allocsPerOp = stats.allocations.count / stats.count;
+      run.bytesPerOp = stats.allocations.bytes / stats.count;
+      run.jsValuesPerOp = stats.allocations.jsValues / stats.count;
+      run.jsBytesPerOp = stats.allocations.jsBytes / stats.count;
+    }
+    runs.push(run);
+  }
+}
+
+if (args.json) {
+  console.log(JSON.stringify({ durationMs, size, runs }, null, 2));
+} else {
+  const columns = ['op', 'threads', 'opsPerSec', 'errors', 'p50Us', 'p99Us', 'p999Us', 'queueP99Us', 'jsP99Us'];
+  if (Fuse.allocationStatsEnabled) {
+    columns.push('allocsPerOp', 'bytesPerOp', 'jsValuesPerOp', 'jsBytesPerOp');
+  }
+  console.log(columns.map((c) => c.padStart(11)).join(''));
+  for (const run of runs) {
+    console.log(columns.map((c) => {
+      const value = run[c];
+      return (typeof value === 'number' && !Number.isInteger(value) ? value.toFixed(1) : String(value)).padStart(11);
+    }).join(''));
+  }
+}
@@ -0,0 +1,123 @@
+#!/usr/bin/env node
+
+/**
+ * Fault benchmark: serves a synthetic tree through MockProvider and runs a
+ * stat storm with the native load generator under each fault scenario, on a
+ * single- and a multi-threaded FUSE loop. Shows what callers see when JS is
+ * slow: latency tails, queueing, fairness between callers, stale attributes
+ * served under lag and how quickly the watchdog notices a hung request.
+ * Prints a JSON report.
+ *
+ *   node bench/faults.js [--scenarios baseline,tail,...] [--loops single,multi]
+ *                        [--threads 16] [--duration 5] [--workload stat]
+ *                        [--depth 2] [--fanout 10] [--files 100] [--out file]
+ */
+
+import fs from 'fs';
+import { parseArgs } from 'util';
+import { EIO } from '../index.js';
+import { SyntheticTree } from './synthetic-tree.js';
+import { MockProvider } from './mock-provider.js';
+import { mount, unmount, loadgen, mountStats, fairness, list } from './common.js';
+
+const SCENARIOS = {
+  baseline: { rules: [] },
+  // 1% of requests take 100 ms; everything else is instant
+  tail: { rules: [{ name: 'slow 1%', probability: 0.01, latencyMs: 100 }] },
+  // Every request waits on a backend with exponential latency
+  jitter: { rules: [{ name: 'exp 1ms', latencyMs: { dist: 'exponential', mean: 1 } }] },
+  // One directory on a slow backend: does it hold up the rest?
+  slowSubtree: { rules: [{ name: '/d0 +50ms', path: '/d0/**', latencyMs: 50 }] },
+  // 1% of handlers do 20 ms of synchronous work on the event loop
+  blocking: { rules: [{ name: 'block 1%', probability: 0.01, blockMs: 20 }] },
+  // The same, with stale attributes served while the loop lags
+  blockingStale: { rules: [{ name: 'block 1%', probability: 0.01, blockMs: 20 }], options: { lagThresholdMs: 10 } },
+  errors: { rules: [{ name: 'EIO 1%', probability: 0.01, error: EIO }] },
+  // A single request is never answered until the run ends
+  hang: { rules: [{ name: 'hang once', op: 'getattr', limit: 1, hang: true }], options: { slowThresholds: { default: 1000 } } }
+};
+
+const LOOPS = {
+  single: {},
+  multi: { multithreaded: true }
+};
+
+const { values: args } = parseArgs({
+  options: {
+    scenarios: { type: 'string', default: Object.keys(SCENARIOS).join(',') },
+    loops: { type: 'string', default: 'single,multi' },
+    threads: { type: 'string', default: '16' },
+    duration: { type: 'string', default: '5' },
+    workload: { type: 'string', default: 'stat' },
+    depth: { type: 'string', default: '2' },
+    fanout: { type: 'string', default: '10' },
+    files: { type: 'string', default: '100' },
+    out: { type: 'string' }
+  }
+});
+
+const tree = new SyntheticTree({ depth: Number(args.depth), fanout: Number(args.fanout), files: Number(args.files) });
+const shape = ['-D', args.depth, '-F', args.fanout, '-f', args.files];
+
+// How evenly the load generator's threads were served
+function threadFairness(threadOps) {
+  return { jain: fairness(threadOps), minOps: Math.min(...threadOps), maxOps: Math.max(...threadOps) };
+}
+
+const runs = [];
+for (const loop of list(args.loops)) {
+  for (const name of list(args.scenarios)) {
+    const scenario = SCENARIOS[name];
+    if (!scenario || !LOOPS[loop]) {
+      throw new Error(`unknown scenario ${name} or loop ${loop}`);
+    }
+    console.error(`${loop}: ${name} ...`);
+
+    const mock = new MockProvider(tree.handlers(), scenario.rules);
+    const options = { ...LOOPS[loop], ...scenario.options };
+    const mounted = await mount(mock.handlers(), options);
+
+    const slow = [];
+    const lag = [];
+    const started = performance.now();
+    mounted.fuse.on('slow', (info) => slow.push({ ...info, atMs: Math.round(performance.now() - started) }));
+    mounted.fuse.on('lag', (info) => lag.push(info));
+
+    // Let hung requests go once the run is over, so the load generator can finish
+    const release = setTimeout(() => mock.releaseHeld(), Number(args.duration) * 1000);
+    try {
+      const result = await loadgen(['-w', args.workload, '-t', args.threads, '-d', args.duration, ...shape,
+        mounted.mountPoint]);
+      runs.push({
+        loop,
+        scenario: name,
+        options,
+        opsPerSec: result.opsPerSec,
+        errors: result.errors,
+        latencyUs: result.latencyUs,
+        fairness: threadFairness(result.threadOps),
+        mount: mountStats(mounted.fuse, ['getattr', 'readdir', 'access']),
+        rules: mock.stats(),
+        slow: slow.map(({ op, stage, elapsedMs, completed, atMs }) => ({ op, stage, elapsedMs, completed, atMs })),
+        lagEpisodes: lag.filter((event) => event.state === 'recovered').length
+      });
+    } finally {
+      clearTimeout(release);
+      mock.releaseHeld();
+      await unmount(mounted);
+    }
+  }
+}
+
+const report = {
+  benchmark: 'faults',
+  workload: args.workload,
+  threads: Number(args.threads),
+  tree: { depth: tree.depth, fanout: tree.fanout, files: tree.files, entries: tree.entryCount },
+  runs
+};
+const json = JSON.stringify(report, null, 2);
+if (args.out) {
+  fs.writeFileSync(args.out, json);
+}
+console.log(json);
@@ -0,0 +1,247 @@
+#!/usr/bin/env node
+
+/**
+ * Event-loop interference benchmark: runs a metadata workload against a
+ * synthetic tree while the main thread is kept busy the way an application
+ * sharing the process would keep it: CPU-bound slices, large JSON parses or
+ * forced full GCs. The mount is hosted either on the main thread or in a
+ * worker thread with its own event loop. Reports the load generator's
+ * latency under each load next to the unloaded run of the same host.
+ *
+ *   node bench/interference.js [--hosts main,worker] [--loads none,cpu,json,gc]
+ *                              [--threads 8] [--duration 5] [--workload stat]
+ *                              [--busy-ms 50] [--json-mb 5] [--heap-mb 200]
+ *                              [--depth 2] [--fanout 10] [--files 100] [--out file]
+ */
+
+import fs from 'fs';
+import v8 from 'v8';
+import vm from 'vm';
+import { parseArgs } from 'util';
+import { Worker, isMainThread, parentPort, workerData } from 'worker_threads';
+import { SyntheticTree } from './synthetic-tree.js';
+import { mount, unmount, loadgen, mountStats, list } from './common.js';
+
+const STAT_OPS = ['getattr', 'readdir', 'access'];
+
+// Worker host: serves the mount from this thread's event loop
+if (!isMainThread) {
+  const mounted = await mount(new SyntheticTree(workerData.tree).handlers(), workerData.options);
+  parentPort.on('message', async (message) => {
+    if (message === 'reset') {
+      mounted.fuse.resetStats();
+      parentPort.postMessage(null);
+    } else if (message === 'stats') {
+      parentPort.postMessage(mountStats(mounted.fuse, STAT_OPS));
+    } else if (message === 'unmount') {
+      await unmount(mounted);
+      parentPort.close();
+    }
+  });
+  parentPort.postMessage(mounted.mountPoint);
+} else {
+  await main();
+}
+
+// Where the mount runs; the same calls whether it is here or in a worker
+async function host(where, tree, options) {
+  if (where === 'main') {
+    const mounted = await mount(tree.handlers(), options);
+    return {
+      mountPoint: mounted.mountPoint,
+      reset: async () => mounted.fuse.resetStats(),
+      stats: async () => mountStats(mounted.fuse, STAT_OPS),
+      close: () => unmount(mounted)
+    };
+  }
+
+  const worker = new Worker(new URL(import.meta.url), {
+    workerData: { tree: { depth: tree.depth, fanout: tree.fanout, files: tree.files }, options }
+  });
+  // One pending reply at a time; whichever event settles it removes the other listener
+  const reply = () => new Promise((resolve, reject) => {
+    const onMessage = (message) => {
+      worker.off('error', onError);
+      resolve(message);
+    };
+    const onError = (err) => {
+      worker.off('message', onMessage);
+      reject(err);
+    };
+    worker.once('message', onMessage);
+    worker.once('error', onError);
+  });
+  const ask = (message) => {
+    const answer = reply();
+    worker.postMessage(message);
+    return answer;
+  };
+  const mountPoint = await reply();
+  return {
+    mountPoint,
+    reset: () => ask('reset'),
+    stats: () => ask('stats'),
+    close: () => {
+      const exited = new Promise((resolve) => worker.once('exit', resolve));
+      worker.postMessage('unmount');
+      return exited;
+    }
+  };
+}
+
+/**
+ * Keep the main thread busy until stop() is called. Each load works in
+ * slices and yields between them, as a busy application would, so the
+ * event loop still turns, just late.
+ */
+function startLoad(kind, args) {
+  let running = true;
+  let slices = 0;
+  const busyMs = Number(args['busy-ms']);
+  let work;
+  let pauseMs;
+
+  switch (kind) {
+    case 'none':
+      return { stop: () => 0 };
+    case 'cpu':
+      // busyMs of computation, then an equal pause
+      work = () => {
+        const until = performance.now() + busyMs;
+        while (performance.now() < until) {
+          // Spin
+        }
+      };
+      pauseMs = busyMs;
+      break;
+    case 'json': {
+      // Parse a document of the given size, back to back
+      const item = { id: 0, name: 'entry', tags: ['a', 'b', 'c'], size: 12345, nested: { ok: true, value: 1.5 } };
+      const count = Math.ceil((Number(args['json-mb']) << 20) / JSON.stringify(item).length);
+      const text = JSON.stringify(Array.from({ length: count }, (_, id) => ({ ...item, id })));
+      work = () => JSON.parse(text);
+      pauseMs = 0;
+      break;
+    }
+    case 'gc': {
+      // A full collection over a large live heap every busyMs
+      v8.setFlagsFromString('--expose-gc');
+      const gc = vm.runInNewContext('gc');
+      const retained = [];
+      for (let i = 0; i < (Number(args['heap-mb']) << 20) / 64; i++) {
+        retained.push({ i, next: null, data: 'x' });
+      }
+      work = () => {
+        gc();
+        return retained.length;  // Keeps the heap alive while the load runs
+      };
+      pauseMs = busyMs;
+      break;
+    }
+    default:
+      throw new Error(`unknown load ${kind}`);
+  }
+
+  const slice = () => {
+    if (!running) {
+      return;
+    }
+    work();
+    slices++;
+    if (pauseMs > 0) {
+      setTimeout(slice, pauseMs);
+    } else {
+      setImmediate(slice);
+    }
+  };
+  setImmediate(slice);
+  return {
+    stop: () => {
+      running = false;
+      return slices;
+    }
+  };
+}
+
+async function main() {
+  const { values: args } = parseArgs({
+    options: {
+      hosts: { type: 'string', default: 'main,worker' },
+      loads: { type: 'string', default: 'none,cpu,json,gc' },
+      threads: { type: 'string', default: '8' },
+      duration: { type: 'string', default: '5' },
+      workload: { type: 'string', default: 'stat' },
+      'busy-ms': { type: 'string', default: '50' },
+      'json-mb': { type: 'string', default: '5' },
+      'heap-mb': { type: 'string', default: '200' },
+      depth: { type: 'string', default: '2' },
+      fanout: { type: 'string', default: '10' },
+      files: { type: 'string', default: '100' },
+      options: { type: 'string', default: '{}' },
+      out: { type: 'string' }
+    }
+  });
+
+  const tree = new SyntheticTree({ depth: Number(args.depth), fanout: Number(args.fanout), files: Number(args.files) });
+  const options = JSON.parse(args.options);
+  const shape = ['-D', args.depth, '-F', args.fanout, '-f', args.files];
+
+  const runs = [];
+  for (const where of list(args.hosts)) {
+    const mounted = await host(where, tree, options);
+    let baseline = null;
+    try {
+      for (const kind of list(args.loads)) {
+        console.error(`${where}: ${kind} ...`);
+        await mounted.reset();
+        const load = startLoad(kind, args);
+        let result;
+        let slices;
+        try {
+          result = await loadgen(['-w', args.workload, '-t', args.threads, '-d', args.duration, ...shape,
+            mounted.mountPoint]);
+        } finally {
+          slices = load.stop();
+        }
+
+        const run = {
+          host: where,
+          load: kind,
+          loadSlices: slices,
+          opsPerSec: result.opsPerSec,
+          errors: result.errors,
+          latencyUs: result.latencyUs,
+          mount: await mounted.stats()
+        };
+        if (kind === 'none') {
+          baseline = run;
+        } else if (baseline) {
+          // How much worse than the same host with an idle main thread
+          run.slowdown = {
+            opsPerSec: baseline.opsPerSec / run.opsPerSec,
+            p50: run.latencyUs.p50 / baseline.latencyUs.p50,
+            p99: run.latencyUs.p99 / baseline.latencyUs.p99,
+            p999: run.latencyUs.p999 / baseline.latencyUs.p999
+          };
+        }
+        runs.push(run);
+      }
+    } finally {
+      await mounted.close();
+    }
+  }
+
+  const report = {
+    benchmark: 'interference',
+    workload: args.workload,
+    threads: Number(args.threads),
+    tree: { depth: tree.depth, fanout: tree.fanout, files: tree.files, entries: tree.entryCount },
+    options,
+    runs
+  };
+  const json = JSON.stringify(report, null, 2);
+  if (args.out) {
+    fs.writeFileSync(args.out, json);
+  }
+  console.log(json);
+}
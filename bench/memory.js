@@ -0,0 +1,119 @@
+#!/usr/bin/env node
+
+/**
+ * Memory benchmark: for each size, a fresh process mounts a synthetic tree
+ * of that many entries and walks all of it with find -ls, so every entry
+ * goes through readdir and getattr. Before and after the walk it records
+ * RSS, the C heap as malloc sees it, the V8 heap and the mount's own native
+ * structures, and derives bytes per entry. Prints a JSON report.
+ *
+ *   node bench/memory.js [--entries 100000,1000000,5000000] [--fanout 10]
+ *                        [--depth 3] [--threads 8] [--options '{...}'] [--out file]
+ *
+ * Each size runs in its own process because RSS and the C heap seldom
+ * shrink once grown.
+ */
+
+import fs from 'fs';
+import v8 from 'v8';
+import { parseArgs } from 'util';
+import { execFile } from 'child_process';
+import { fileURLToPath } from 'url';
+import Fuse from '../index.js';
+import { SyntheticTree } from './synthetic-tree.js';
+import { mount, unmount, loadgen, list } from './common.js';
+
+const { values: args } = parseArgs({
+  options: {
+    entries: { type: 'string', default: '100000,1000000,5000000' },
+    depth: { type: 'string', default: '3' },
+    fanout: { type: 'string', default: '10' },
+    threads: { type: 'string', default: '8' },
+    options: { type: 'string', default: '{}' },
+    child: { type: 'boolean', default: false },
+    out: { type: 'string' }
+  }
+});
+
+function sample(fuse) {
+  const usage = process.memoryUsage();
+  const heap = v8.getHeapStatistics();
+  return {
+    rssBytes: usage.rss,
+    maxRssBytes: process.resourceUsage().maxRSS * 1024,
+    allocator: Fuse.allocatorStats(),
+    v8: { usedHeapBytes: heap.used_heap_size, totalHeapBytes: heap.total_heap_size, externalBytes: usage.external },
+    native: fuse ? fuse.getStats().memory : null
+  };
+}
+
+// Difference per entry between two samples
+function perEntry(before, after, count) {
+  const per = (a, b) => (a !== undefined && b !== undefined ? (b - a) / count : null);
+  return {
+    rss: per(before.rssBytes, after.rssBytes),
+    allocator: per(before.allocator.inUseBytes, after.allocator.inUseBytes),
+    v8: per(before.v8.usedHeapBytes, after.v8.usedHeapBytes),
+    native: per(before.native.totalBytes, after.native.totalBytes)
+  };
+}
+
+// One size, in this process
+async function measure(target) {
+  const depth = Number(args.depth);
+  const fanout = Number(args.fanout);
+  // Enough files per directory to reach the target with this many directories
+  const shape = new SyntheticTree({ depth, fanout, files: 0 });
+  const files = Math.max(1, Math.ceil((target + 1) / shape.directoryCount) - 1);
+  const tree = new SyntheticTree({ depth, fanout, files });
+
+  const idle = sample(null);
+  const mounted = await mount(tree.handlers(), JSON.parse(args.options));
+  try {
+    const before = sample(mounted.fuse);
+    const walk = await loadgen(['-w', 'findls', '-t', args.threads, '-d', '86400',
+      '-D', String(depth), '-F', String(fanout), '-f', String(files), mounted.mountPoint]);
+    const after = sample(mounted.fuse);
+    const stats = mounted.fuse.getStats();
+    return {
+      entries: tree.entryCount,
+      tree: { depth, fanout, files },
+      walk: { seconds: walk.seconds, entriesPerSec: walk.entriesPerSec, errors: walk.errors },
+      requests: { getattr: stats.ops.getattr?.count ?? 0, readdir: stats.ops.readdir?.count ?? 0 },
+      idle,
+      before,
+      after,
+      bytesPerEntry: perEntry(before, after, tree.entryCount)
+    };
+  } finally {
+    await unmount(mounted);
+  }
+}
+
+if (args.child) {
+  console.log(JSON.stringify(await measure(Number(args.entries))));
+} else {
+  const runs = [];
+  for (const target of list(args.entries)) {
+    console.error(`${target} entries ...`);
+    const childArgs = [fileURLToPath(import.meta.url), '--child', '--entries', target, '--depth', args.depth,
+      '--fanout', args.fanout, '--threads', args.threads, '--options', args.options];
+    const stdout = await new Promise((resolve, reject) => {
+      execFile(process.execPath, childArgs, { maxBuffer: 1 << 20 }, (err, out, stderr) => {
+        if (err) {
+          reject(new Error(`${target} entries: ${stderr || err.message}`));
+        } else {
+          resolve(out);
+        }
+      });
+    });
+    runs.push(JSON.parse(stdout));
+  }
+
+  const report = { benchmark: 'memory', options: JSON.parse(args.options), runs };
+  const json = JSON.stringify(report, null, 2);
+  if (args.out) {
+    fs.writeFileSync(args.out, json);
+  }
+  console.log(json);
+}
@@ -0,0 +1,65 @@
+#!/usr/bin/env node
+
+/**
+ * Metadata benchmark: mounts a synthetic tree and runs stat storms, readdir,
+ * ls -l and find over it with the native load generator at each thread
+ * count. Prints a JSON report.
+ *
+ *   node bench/metadata.js [--depth 2] [--fanout 10] [--files 100]
+ *                          [--threads 1,4,16] [--duration 5]
+ *                          [--workloads stat,readdir,lsl,find]
+ *                          [--options '{"multithreaded":true}'] [--out file]
+ *
+ * --options are passed to the mount; multithreaded selects the
+ * multi-threaded FUSE loop.
+ */
+
+import fs from 'fs';
+import { parseArgs } from 'util';
+import { SyntheticTree } from './synthetic-tree.js';
+import { mount, unmount, loadgen, mountStats, list } from './common.js';
+
+const { values: args } = parseArgs({
+  options: {
+    depth: { type: 'string', default: '2' },
+    fanout: { type: 'string', default: '10' },
+    files: { type: 'string', default: '100' },
+    threads: { type: 'string', default: '1,4,16' },
+    duration: { type: 'string', default: '5' },
+    workloads: { type: 'string', default: 'stat,readdir,lsl,find' },
+    options: { type: 'string', default: '{}' },
+    out: { type: 'string' }
+  }
+});
+
+const tree = new SyntheticTree({ depth: Number(args.depth), fanout: Number(args.fanout), files: Number(args.files) });
+const options = JSON.parse(args.options);
+const shape = ['-D', args.depth, '-F', args.fanout, '-f', args.files];
+
+const mounted = await mount(tree.handlers(), options);
+const runs = [];
+try {
+  for (const workload of list(args.workloads)) {
+    for (const threads of list(args.threads)) {
+      console.error(`${workload} x ${threads} ...`);
+      mounted.fuse.resetStats();
+      const result = await loadgen(['-w', workload, '-t', threads, '-d', args.duration, ...shape, mounted.mountPoint]);
+      result.mount = mountStats(mounted.fuse, ['getattr', 'readdir', 'access']);
+      runs.push(result);
+    }
+  }
+} finally {
+  await unmount(mounted);
+}
+
+const report = {
+  benchmark: 'metadata',
+  tree: { depth: tree.depth, fanout: tree.fanout, files: tree.files, entries: tree.entryCount },
+  options,
+  runs
+};
+const json = JSON.stringify(report, null, 2);
+if (args.out) {
+  fs.writeFileSync(args.out, json);
+}
+console.log(json);
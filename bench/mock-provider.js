@@ -0,0 +1,155 @@
+/**
+ * Fault-injecting wrapper around a set of operations, for seeing how the
+ * mount behaves when JS is slow or misbehaves. Each rule picks requests by
+ * operation and path and applies any of:
+ *
+ *   latencyMs   answer later: a number, or { dist: 'uniform', min, max },
+ *               { dist: 'exponential', mean }, { dist: 'lognormal', median, sigma }
+ *   blockMs     busy-wait on the event loop before answering (a sync stall)
+ *   error       answer with this errno instead of calling the operation
+ *   hang        never answer, until releaseHeld()
+ *
+ * A rule applies to a matching request with its probability (default 1) and
+ * at most limit times. Every applying rule takes effect: delays and stalls
+ * add up, and the first error or hang wins. Random choices come from a
+ * seeded generator, so a run can be repeated.
+ */
+
+import { EIO } from '../index.js';
+
+// Glob over paths: ** crosses directories, * does not
+function compilePath(pattern) {
+  if (pattern === undefined || pattern instanceof RegExp) {
+    return pattern;
+  }
+  const source = pattern.replace(/[.+?^${}()|[\]\\]/g, '\\$&').replace(/\*\*|\*/g, (m) => (m === '**' ? '.*' : '[^/]*'));
+  return new RegExp(`^${source}$`);
+}
+
+// mulberry32
+function generator(seed) {
+  let state = seed >>> 0;
+  return () => {
+    state = (state + 0x6d2b79f5) >>> 0;
+    let t = state;
+    t = Math.imul(t ^ (t >>> 15), t | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+export class MockProvider {
+  constructor(operations, rules = [], { seed = 1 } = {}) {
+    this.operations = operations;
+    this.random = generator(seed);
+    this.held = [];
+    this.rules = rules.map((rule) => ({
+      ...rule,
+      ops: rule.op === undefined || rule.op === '*' ? null : new Set([].concat(rule.op)),
+      pattern: compilePath(rule.path),
+      counts: { applied: 0, delayed: 0, blocked: 0, failed: 0, held: 0 }
+    }));
+  }
+
+  sample(latency) {
+    if (typeof latency === 'number') {
+      return latency;
+    }
+    const u = this.random();
+    switch (latency.dist) {
+      case 'uniform':
+        return latency.min + u * (latency.max - latency.min);
+      case 'exponential':
+        return -Math.log(1 - u) * latency.mean;
+      case 'lognormal': {
+        // Box-Muller for the normal variate
+        const z = Math.sqrt(-2 * Math.log(1 - u)) * Math.cos(2 * Math.PI * this.random());
+        return latency.median * Math.exp(latency.sigma * z);
+      }
+      default:
+        throw new Error(`unknown latency distribution ${latency.dist}`);
+    }
+  }
+
+  // What the rules do to one request
+  effect(op, path) {
+    const effect = { delayMs: 0, blockMs: 0, error: 0, hang: false };
+    for (const rule of this.rules) {
+      if ((rule.ops && !rule.ops.has(op)) || (rule.pattern && !rule.pattern.test(path))) {
+        continue;
+      }
+      if (rule.limit !== undefined && rule.counts.applied >= rule.limit) {
+        continue;
+      }
+      if (rule.probability !== undefined && this.random() >= rule.probability) {
+        continue;
+      }
+      rule.counts.applied++;
+      if (rule.latencyMs !== undefined) {
+        effect.delayMs += this.sample(rule.latencyMs);
+        rule.counts.delayed++;
+      }
+      if (rule.blockMs) {
+        effect.blockMs += rule.blockMs;
+        rule.counts.blocked++;
+      }
+      if (!effect.error && !effect.hang) {
+        if (rule.hang) {
+          effect.hang = true;
+          rule.counts.held++;
+        } else if (rule.error) {
+          effect.error = rule.error;
+          rule.counts.failed++;
+        }
+      }
+    }
+    return effect;
+  }
+
+  /**
+   * The wrapped operations for new Fuse()
+   */
+  handlers() {
+    const wrapped = {};
+    for (const [op, handler] of Object.entries(this.operations)) {
+      wrapped[op] = (path, ...args) => {
+        const effect = this.effect(op, path);
+        if (effect.blockMs > 0) {
+          const until = performance.now() + effect.blockMs;
+          while (performance.now() < until) {
+            // Stall the event loop the way a synchronous handler would
+          }
+        }
+
+        const cb = args[args.length - 1];
+        if (effect.hang) {
+          this.held.push(cb);
+          return;
+        }
+        const answer = effect.error ? () => cb(effect.error) : () => handler(path, ...args);
+        if (effect.delayMs > 0) {
+          setTimeout(answer, effect.delayMs);
+        } else {
+          answer();
+        }
+      };
+    }
+    return wrapped;
+  }
+
+  /**
+   * Answer every held request with errno, so the callers and the FUSE
+   * threads waiting on them are let go. Returns how many there were.
+   */
+  releaseHeld(errno = EIO) {
+    const held = this.held.splice(0);
+    for (const cb of held) {
+      cb(errno);
+    }
+    return held.length;
+  }
+
+  stats() {
+    return this.rules.map((rule) => ({ name: rule.name, ...rule.counts }));
+  }
+}
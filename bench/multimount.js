@@ -0,0 +1,121 @@
+#!/usr/bin/env node
+
+/**
+ * Multi-mount benchmark: mounts 1, 8, 64 and 256 synthetic trees in this
+ * process, one Fuse instance each, and drives all of them at once with one
+ * load generator per mount. Reports throughput and latency per mount, how
+ * evenly the mounts were served, the time to mount and unmount them all, and
+ * the process's threads, file descriptors and memory with them mounted.
+ * Prints a JSON report.
+ *
+ *   node bench/multimount.js [--mounts 1,8,64,256] [--threads 1] [--duration 5]
+ *                            [--workload stat] [--depth 2] [--fanout 10] [--files 100]
+ *                            [--options '{...}'] [--out file]
+ *
+ * --threads is per mount.
+ */
+
+import fs from 'fs';
+import { parseArgs } from 'util';
+import Fuse from '../index.js';
+import { SyntheticTree } from './synthetic-tree.js';
+import { mount, unmount, loadgen, mountStats, fairness, list } from './common.js';
+
+const { values: args } = parseArgs({
+  options: {
+    mounts: { type: 'string', default: '1,8,64,256' },
+    threads: { type: 'string', default: '1' },
+    duration: { type: 'string', default: '5' },
+    workload: { type: 'string', default: 'stat' },
+    depth: { type: 'string', default: '2' },
+    fanout: { type: 'string', default: '10' },
+    files: { type: 'string', default: '100' },
+    options: { type: 'string', default: '{}' },
+    out: { type: 'string' }
+  }
+});
+
+const tree = new SyntheticTree({ depth: Number(args.depth), fanout: Number(args.fanout), files: Number(args.files) });
+const options = JSON.parse(args.options);
+const shape = ['-D', args.depth, '-F', args.fanout, '-f', args.files];
+
+// Threads, descriptors and memory of the whole process
+function processSample() {
+  const status = fs.readFileSync('/proc/self/status', 'utf8');
+  return {
+    threads: Number(/^Threads:\s+(\d+)/m.exec(status)[1]),
+    fds: fs.readdirSync('/proc/self/fd').length,
+    rssBytes: process.memoryUsage().rss,
+    allocator: Fuse.allocatorStats()
+  };
+}
+
+function percentile(values, q) {
+  const sorted = [...values].sort((a, b) => a - b);
+  return sorted[Math.min(sorted.length - 1, Math.floor(q * sorted.length))];
+}
+
+const runs = [];
+for (const count of list(args.mounts).map(Number)) {
+  console.error(`${count} mounts ...`);
+  const idle = processSample();
+
+  let start = performance.now();
+  const mounts = [];
+  try {
+    for (let i = 0; i < count; i++) {
+      mounts.push(await mount(tree.handlers(), options));
+    }
+    const mountMs = performance.now() - start;
+    const mounted = processSample();
+
+    const results = await Promise.all(mounts.map((m) =>
+      loadgen(['-w', args.workload, '-t', args.threads, '-d', args.duration, ...shape, m.mountPoint])));
+    const perMount = results.map((result, i) => ({
+      opsPerSec: result.opsPerSec,
+      errors: result.errors,
+      latencyUs: result.latencyUs,
+      mount: mountStats(mounts[i].fuse, ['getattr'])
+    }));
+
+    const rates = perMount.map((m) => m.opsPerSec);
+    const total = rates.reduce((a, b) => a + b, 0);
+    const p99s = perMount.map((m) => m.latencyUs.p99);
+    runs.push({
+      mounts: count,
+      mountMs,
+      totalOpsPerSec: total,
+      perMountOpsPerSec: { min: Math.min(...rates), median: percentile(rates, 0.5), max: Math.max(...rates) },
+      fairness: fairness(rates),
+      p99Us: { min: Math.min(...p99s), median: percentile(p99s, 0.5), max: Math.max(...p99s) },
+      process: { idle, mounted, perMount: {
+        threads: (mounted.threads - idle.threads) / count,
+        fds: (mounted.fds - idle.fds) / count,
+        rssBytes: (mounted.rssBytes - idle.rssBytes) / count
+      } },
+      perMount
+    });
+  } finally {
+    start = performance.now();
+    for (const m of mounts) {
+      await unmount(m);
+    }
+    if (runs.length > 0 && runs[runs.length - 1].mounts === count) {
+      runs[runs.length - 1].unmountMs = performance.now() - start;
+    }
+  }
+}
+
+const report = {
+  benchmark: 'multimount',
+  workload: args.workload,
+  threadsPerMount: Number(args.threads),
+  tree: { depth: tree.depth, fanout: tree.fanout, files: tree.files, entries: tree.entryCount },
+  options,
+  runs
+};
+const json = JSON.stringify(report, null, 2);
+if (args.out) {
+  fs.writeFileSync(args.out, json);
+}
+console.log(json);
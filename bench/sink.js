@@ -0,0 +1,105 @@
+/**
+ * In-memory sink for the write benchmarks. It keeps the namespace and file
+ * sizes, but drops written data, so a 1 GB stream costs no memory.
+ */
+
+import { ENOENT, EEXIST, ENOTEMPTY, ENOTDIR } from '../index.js';
+
+export class MemorySink {
+  constructor() {
+    const now = Date.now();
+    this.entries = new Map([['/', { dir: true, mode: 0o040755, size: 4096, mtime: now }]]);
+    this.bytesWritten = 0;
+  }
+
+  parent(path) {
+    const slash = path.lastIndexOf('/');
+    return slash === 0 ? '/' : path.slice(0, slash);
+  }
+
+  add(path, entry, cb) {
+    if (this.entries.has(path)) {
+      return cb(EEXIST);
+    }
+    const parent = this.entries.get(this.parent(path));
+    if (!parent || !parent.dir) {
+      return cb(parent ? ENOTDIR : ENOENT);
+    }
+    this.entries.set(path, { ...entry, mtime: Date.now() });
+    cb(null);
+  }
+
+  handlers() {
+    const withEntry = (fn) => (path, ...args) => {
+      const entry = this.entries.get(path);
+      const cb = args[args.length - 1];
+      return entry ? fn(entry, path, ...args) : cb(ENOENT);
+    };
+
+    return {
+      getattr: withEntry((entry, path, cb) => {
+        cb(null, { mode: entry.mode, size: entry.size, mtime: entry.mtime, atime: entry.mtime, ctime: entry.mtime });
+      }),
+      readdir: withEntry((entry, path, cb) => {
+        const prefix = path === '/' ? '/' : `${path}/`;
+        const names = [];
+        for (const name of this.entries.keys()) {
+          if (name !== path && name.startsWith(prefix) && !name.includes('/', prefix.length)) {
+            names.push(name.slice(prefix.length));
+          }
+        }
+        cb(null, names);
+      }),
+      access: withEntry((entry, path, mode, cb) => cb(null)),
+      create: (path, mode, cb) => this.add(path, { dir: false, mode: 0o100000 | (mode & 0o7777), size: 0 }, cb),
+      mkdir: (path, mode, cb) => this.add(path, { dir: true, mode: 0o040000 | (mode & 0o7777), size: 4096 }, cb),
+      open: withEntry((entry, path, flags, cb) => cb(null, 1)),
+      write: withEntry((entry, path, fd, buffer, length, offset, cb) => {
+        entry.size = Math.max(entry.size, offset + length);
+        entry.mtime = Date.now();
+        this.bytesWritten += length;
+        cb(null, length);
+      }),
+      truncate: withEntry((entry, path, size, cb) => {
+        entry.size = size;
+        cb(null);
+      }),
+      chmod: withEntry((entry, path, mode, cb) => {
+        entry.mode = (entry.mode & ~0o7777) | (mode & 0o7777);
+        cb(null);
+      }),
+      utimens: withEntry((entry, path, atime, mtime, cb) => {
+        if (mtime !== null) {
+          entry.mtime = mtime * 1000;
+        }
+        cb(null);
+      }),
+      rename: withEntry((entry, from, to, cb) => {
+        const target = this.entries.get(to);
+        if (target && target.dir) {
+          return cb(EEXIST);
+        }
+        this.entries.delete(from);
+        this.entries.set(to, entry);
+        cb(null);
+      }),
+      unlink: withEntry((entry, path, cb) => {
+        this.entries.delete(path);
+        cb(null);
+      }),
+      rmdir: withEntry((entry, path, cb) => {
+        const prefix = `${path}/`;
+        for (const name of this.entries.keys()) {
+          if (name.startsWith(prefix)) {
+            return cb(ENOTEMPTY);
+          }
+        }
+        this.entries.delete(path);
+        cb(null);
+      }),
+      flush: (path, fd, cb) => cb(null),
+      fsync: (path, datasync, fd, cb) => cb(null),
+      release: (path, fd, cb) => cb(null)
+    };
+  }
+}
@@ -0,0 +1,146 @@
+/**
+ * Synthetic tree for the benchmarks. Everything is computed from the shape,
+ * so a tree of a million entries costs no memory. The naming must match
+ * tools/fuse3_loadgen.cc: a directory at level L < depth holds subdirectories
+ * d0..d<fanout-1>, and every directory holds files f0..f<files-1>.
+ */
+
+import { ENOENT } from '../index.js';
+
+// Byte i of every file is i & 0xff; reads copy from this instead of looping
+const PATTERN = Buffer.alloc((1 << 20) + 256, 0);
+for (let i = 0; i < PATTERN.length; i++) {
+  PATTERN[i] = i & 0xff;
+}
+
+export class SyntheticTree {
+  constructor({ depth = 2, fanout = 10, files = 100, fileSize = 4096 } = {}) {
+    this.depth = depth;
+    this.fanout = fanout;
+    this.files = files;
+    this.fileSize = fileSize;
+    this.mtime = Date.now();
+  }
+
+  get directoryCount() {
+    let total = 0;
+    for (let level = 0, perLevel = 1; level <= this.depth; level++, perLevel *= this.fanout) {
+      total += perLevel;
+    }
+    return total;
+  }
+
+  get entryCount() {
+    return this.directoryCount * (1 + this.files) - 1;
+  }
+
+  /**
+   * { dir: true, level } or { dir: false }, null if the path is not in the tree
+   */
+  lookup(path) {
+    if (path === '/') {
+      return { dir: true, level: 0 };
+    }
+
+    const parts = path.split('/').slice(1);
+    let level = 0;
+    for (let i = 0; i < parts.length; i++) {
+      const match = /^([df])(\d+)$/.exec(parts[i]);
+      if (!match) {
+        return null;
+      }
+      const index = Number(match[2]);
+      if (match[1] === 'f') {
+        return i === parts.length - 1 && index < this.files ? { dir: false } : null;
+      }
+      if (level >= this.depth || index >= this.fanout) {
+        return null;
+      }
+      level++;
+    }
+    return { dir: true, level };
+  }
+
+  names(level) {
+    const names = [];
+    if (level < this.depth) {
+      for (let i = 0; i < this.fanout; i++) {
+        names.push(`d${i}`);
+      }
+    }
+    for (let i = 0; i < this.files; i++) {
+      names.push(`f${i}`);
+    }
+    return names;
+  }
+
+  /**
+   * Operations for new Fuse(); file content is a byte pattern of the offset
+   */
+  handlers() {
+    const mtime = this.mtime;
+    return {
+      getattr: (path, cb) => {
+        const entry = this.lookup(path);
+        if (!entry) {
+          return cb(ENOENT);
+        }
+        cb(null, entry.dir
+          ? { mode: 0o040755, size: 4096, mtime, atime: mtime, ctime: mtime }
+          : { mode: 0o100644, size: this.fileSize, mtime, atime: mtime, ctime: mtime });
+      },
+      readdir: (path, cb) => {
+        const entry = this.lookup(path);
+        if (!entry || !entry.dir) {
+          return cb(ENOENT);
+        }
+        cb(null, this.names(entry.level));
+      },
+      access: (path, mode, cb) => cb(this.lookup(path) ? null : ENOENT),
+      open: (path, flags, cb) => cb(this.lookup(path) ? null : ENOENT, 1),
+      read: (path, fd, buffer, length, offset, cb) => {
+        const count = Math.max(0, Math.min(length, this.fileSize - offset));
+        for (let done = 0; done < count; ) {
+          const start = (offset + done) & 0xff;
+          done += PATTERN.copy(buffer, done, start, start + Math.min(count - done, 1 << 20));
+        }
+        cb(null, count);
+      },
+      release: (path, fd, cb) => cb(null)
+    };
+  }
+}
+
+/**
+ * Operations serving several trees side by side, each under /<name>
+ */
+export function combineTrees(trees) {
+  const handlers = Object.fromEntries(Object.entries(trees).map(([name, tree]) => [name, tree.handlers()]));
+  const mtime = Date.now();
+
+  // Path inside the tree it belongs to, or null for the root and unknown names
+  const route = (path) => {
+    const slash = path.indexOf('/', 1);
+    const name = slash < 0 ? path.slice(1) : path.slice(1, slash);
+    return handlers[name] ? { ops: handlers[name], path: slash < 0 ? '/' : path.slice(slash) } : null;
+  };
+
+  const combined = {};
+  for (const op of ['getattr', 'readdir', 'access', 'open', 'read', 'release']) {
+    combined[op] = (path, ...args) => {
+      const target = route(path);
+      if (target) {
+        return target.ops[op](target.path, ...args);
+      }
+      const cb = args[args.length - 1];
+      if (path !== '/') {
+        return cb(ENOENT);
+      }
+      if (op === 'getattr') {
+        return cb(null, { mode: 0o040755, size: 4096, mtime, atime: mtime, ctime: mtime });
+      }
+      return op === 'readdir' ? cb(null, Object.keys(trees)) : cb(null, 0);
+    };
+  }
+  return combined;
+}
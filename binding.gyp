@@ -1,10 +1,26 @@
 {
+  "variables": {
+    "fuse3_log_min_level%": "1",
+    "fuse3_usdt%": "1",
+    "fuse3_alloc_stats%": "0"
+  },
   "targets": [
     {
       "target_name": "fuse3_napi",
       "sources": [ 
         "fuse3_napi.cc",
-        "fuse3_operations.cc"
+        "fuse3_operations.cc",
+        "fuse3_inode_data.cc",
+        "fuse3_log.cc",
+        "fuse3_stats.cc",
+        "fuse3_trace.cc",
+        "fuse3_watchdog.cc",
+        "fuse3_hotpaths.cc",
+        "fuse3_lag.cc",
+        "fuse3_control.cc",
+        "fuse3_bench.cc",
+        "fuse3_record.cc",
+        "fuse3_alloc.cc"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")"
@@ -12,7 +28,8 @@
       "defines": [ 
         "NAPI_DISABLE_CPP_EXCEPTIONS",
         "FUSE_USE_VERSION=31",
-        "_FILE_OFFSET_BITS=64"
+        "_FILE_OFFSET_BITS=64",
+        "FUSE3_LOG_MIN_LEVEL=<(fuse3_log_min_level)"
       ],
       "cflags!": [ "-fno-exceptions" ],
       "cflags_cc!": [ "-fno-exceptions" ],
@@ -30,6 +47,71 @@
             "/usr/include/fuse3"
           ]
         }],
+        ["OS!='linux'", {
+          "type": "none"
+        }],
+        ["fuse3_usdt==0", {
+          "defines": [ "FUSE3_NO_USDT" ]
+        }],
+        ["fuse3_alloc_stats==1", {
+          "defines": [ "FUSE3_ALLOC_STATS", "_GLIBCXX_ASSERTIONS" ],
+          "ldflags": [ "-Wl,-Bsymbolic-functions" ]
+        }]
+      ]
+    },
+    {
+      "target_name": "fuse3top",
+      "type": "executable",
+      "sources": [
+        "tools/fuse3top.cc"
+      ],
+      "cflags_cc!": [ "-fno-exceptions" ],
+      "cflags": [
+        "-Wall",
+        "-Wextra",
+        "-O2"
+      ],
+      "conditions": [
+        ["OS!='linux'", {
+          "type": "none"
+        }]
+      ]
+    },
+    {
+      "target_name": "fuse3_loadgen",
+      "type": "executable",
+      "sources": [
+        "tools/fuse3_loadgen.cc",
+        "fuse3_stats.cc"
+      ],
+      "cflags_cc!": [ "-fno-exceptions" ],
+      "cflags": [
+        "-Wall",
+        "-Wextra",
+        "-O2"
+      ],
+      "libraries": [ "-lpthread" ],
+      "conditions": [
+        ["OS!='linux'", {
+          "type": "none"
+        }]
+      ]
+    },
+    {
+      "target_name": "fuse3replay",
+      "type": "executable",
+      "sources": [
+        "tools/fuse3replay.cc",
+        "fuse3_stats.cc"
+      ],
+      "cflags_cc!": [ "-fno-exceptions" ],
+      "cflags": [
+        "-Wall",
+        "-Wextra",
+        "-O2"
+      ],
+      "libraries": [ "-lpthread" ],
+      "conditions": [
         ["OS!='linux'", {
           "type": "none"
         }]
@@ -0,0 +1,156 @@
+#include "fuse3_alloc.h"
+
+#include <stdlib.h>
+#include <cstddef>
+#include <new>
+
+void AllocStats::Snapshot(FuseOp op, AllocSnapshot *out) const {
+    const AllocCounters& counters = ops_[op];
+    out->allocations = counters.allocations.load(std::memory_order_relaxed);
+    out->bytes = counters.bytes.load(std::memory_order_relaxed);
+    out->jsValues = counters.jsValues.load(std::memory_order_relaxed);
+    out->jsBytes = counters.jsBytes.load(std::memory_order_relaxed);
+}
+
+void AllocStats::Reset() {
+    for (AllocCounters& counters : ops_) {
+        counters.allocations.store(0, std::memory_order_relaxed);
+        counters.bytes.store(0, std::memory_order_relaxed);
+        counters.jsValues.store(0, std::memory_order_relaxed);
+        counters.jsBytes.store(0, std::memory_order_relaxed);
+    }
+}
+
+#ifdef FUSE3_ALLOC_STATS
+
+// Replacement operator new/delete. The addon is linked with
+// -Bsymbolic-functions, so only its own code binds to these; node and
+// other addons keep the C++ library's. std::string is instantiated in the
+// addon too (_GLIBCXX_ASSERTIONS), so string copies are counted as well.
+
+thread_local AllocCounters *t_allocCounters = nullptr;
+
+static inline void *RawAlloc(size_t size, size_t alignment) {
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment <= alignof(std::max_align_t)) {
+        return malloc(size);
+    }
+    void *p = nullptr;
+    return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+}
+
+// Charge one allocation, then allocate the way the standard asks of a
+// replacement: on failure call the new-handler and retry until it throws
+// or there is none left
+static void *CountedNew(size_t size, size_t alignment) {
+    AllocCounters *counters = t_allocCounters;
+    if (counters) {
+        counters->allocations.fetch_add(1, std::memory_order_relaxed);
+        counters->bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    for (;;) {
+        void *p = RawAlloc(size, alignment);
+        if (p) {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+// The nothrow forms behave like the throwing ones, new-handler included
+static void *CountedNewNothrow(size_t size, size_t alignment) noexcept {
+    try {
+        return CountedNew(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void *operator new(size_t size) {
+    return CountedNew(size, 0);
+}
+
+void *operator new[](size_t size) {
+    return CountedNew(size, 0);
+}
+
+void *operator new(size_t size, const std::nothrow_t&) noexcept {
+    return CountedNewNothrow(size, 0);
+}
+
+void *operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return CountedNewNothrow(size, 0);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    return CountedNew(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+    return CountedNew(size, static_cast<size_t>(alignment));
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return CountedNewNothrow(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return CountedNewNothrow(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, size_t, std::align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, std::align_val_t, const std::nothrow_t&) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t&) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t&) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t&) noexcept {
+    free(p);
+}
+
+#endif // FUSE3_ALLOC_STATS
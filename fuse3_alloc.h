@@ -0,0 +1,92 @@
+#ifndef FUSE3_ALLOC_H
+#define FUSE3_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "fuse3_stats.h"
+
+// Allocation counting per operation, built with -Dfuse3_alloc_stats=1
+// (FUSE3_ALLOC_STATS). The addon then replaces operator new/delete and
+// charges every allocation its code makes to the operation the allocating
+// thread is serving: the FUSE thread for the whole request, and the JS
+// thread while it dispatches the request and runs its result callback.
+// jsValues counts the JS values the operations create for a request:
+// handler arguments, Buffers and the result callback; jsBytes is the size
+// of the Buffers among them. malloc() calls, such as libfuse's own, are not
+// seen. Without the option the macros compile to nothing.
+
+struct AllocCounters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> jsValues{0};
+    std::atomic<uint64_t> jsBytes{0};
+};
+
+struct AllocSnapshot {
+    uint64_t allocations;
+    uint64_t bytes;
+    uint64_t jsValues;
+    uint64_t jsBytes;
+};
+
+// Per-operation counters of one mount
+class AllocStats {
+public:
+    AllocCounters *For(FuseOp op) {
+        return &ops_[op];
+    }
+
+    void Snapshot(FuseOp op, AllocSnapshot *out) const;
+    void Reset();
+
+private:
+    AllocCounters ops_[kOpCount];
+};
+
+#ifdef FUSE3_ALLOC_STATS
+
+// Counters charged for allocations on this thread, nullptr for none
+extern thread_local AllocCounters *t_allocCounters;
+
+// Charges allocations on this thread to counters until it goes out of scope
+class AllocScope {
+public:
+    explicit AllocScope(AllocCounters *counters) : saved_(t_allocCounters) {
+        t_allocCounters = counters;
+    }
+    ~AllocScope() {
+        t_allocCounters = saved_;
+    }
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+    AllocCounters *saved_;
+};
+
+// Counts one JS value created on this thread, with bytes of Buffer contents
+static inline void AllocNoteJsValue(size_t bytes) {
+    if (t_allocCounters) {
+        t_allocCounters->jsValues.fetch_add(1, std::memory_order_relaxed);
+        if (bytes) {
+            t_allocCounters->jsBytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+    }
+}
+
+#define FUSE3_ALLOC_SCOPE(counters) AllocScope allocScope_(counters)
+#define FUSE3_ALLOC_JS_VALUE(bytes) AllocNoteJsValue(bytes)
+#define FUSE3_ALLOC_CURRENT() t_allocCounters
+
+#else
+
+#define FUSE3_ALLOC_SCOPE(counters) do {} while (0)
+#define FUSE3_ALLOC_JS_VALUE(bytes) do {} while (0)
+#define FUSE3_ALLOC_CURRENT() static_cast<AllocCounters *>(nullptr)
+
+#endif // FUSE3_ALLOC_STATS
+
+#endif // FUSE3_ALLOC_H
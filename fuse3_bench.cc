@@ -0,0 +1,157 @@
+#include "fuse3_bench.h"
+
+#include <fcntl.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#include <string.h>
+#include <memory>
+#include <thread>
+
+#include "fuse3_context.h"
+#include "fuse3_log.h"
+
+bool DispatchBenchSupports(FuseOp op) {
+    switch (op) {
+        case kOpGetattr:
+        case kOpAccess:
+        case kOpStatfs:
+        case kOpReaddir:
+        case kOpOpen:
+        case kOpRead:
+        case kOpWrite:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// readdir filler that only counts entries
+static int CountEntry(void *buf, const char *, const struct stat *, off_t, enum fuse_fill_dir_flags) {
+    ++*static_cast<uint64_t*>(buf);
+    return 0;
+}
+
+struct BenchThread {
+    Histogram latency[kOpCount];
+    uint64_t errors[kOpCount] = {};
+};
+
+static void RunThread(FuseContext* ctx, const struct fuse_operations& ops, const DispatchBenchConfig& config,
+                      uint64_t deadlineNs, BenchThread *out) {
+    // What fuse_get_context() would hold on a libfuse worker
+    struct fuse_context request = {};
+    request.private_data = ctx;
+    request.pid = getpid();
+    request.uid = getuid();
+    request.gid = getgid();
+    request.umask = 022;
+    t_requestContext = &request;
+
+    const char *path = config.path.c_str();
+    std::vector<char> buffer(config.size, 'x');
+
+    auto timed = [out](FuseOp op, int result, uint64_t startNs) {
+        out->latency[op].Record(MonotonicNs() - startNs);
+        if (result < 0) {
+            out->errors[op]++;
+        }
+    };
+
+    // One handle per thread for the data operations
+    struct fuse_file_info handle = {};
+    bool opened = false;
+    for (FuseOp op : config.ops) {
+        if ((op == kOpRead || op == kOpWrite) && !opened) {
+            handle.flags = O_RDWR;
+            uint64_t start = MonotonicNs();
+            int result = ops.open(path, &handle);
+            timed(kOpOpen, result, start);
+            opened = result == 0;
+            if (!opened) {
+                LOG_WARN(kLogCore, "dispatch bench: open %s failed (%d); read/write will fail", path, result);
+            }
+            break;
+        }
+    }
+
+    uint64_t offset = 0;
+    while (MonotonicNs() < deadlineNs) {
+        for (FuseOp op : config.ops) {
+            uint64_t start = MonotonicNs();
+            int result = 0;
+            switch (op) {
+                case kOpGetattr: {
+                    struct stat stbuf;
+                    result = ops.getattr(path, &stbuf, nullptr);
+                    break;
+                }
+                case kOpAccess:
+                    result = ops.access(path, R_OK);
+                    break;
+                case kOpStatfs: {
+                    struct statvfs stbuf;
+                    result = ops.statfs(path, &stbuf);
+                    break;
+                }
+                case kOpReaddir: {
+                    uint64_t entries = 0;
+                    result = ops.readdir(path, &entries, CountEntry, 0, nullptr, static_cast<fuse_readdir_flags>(0));
+                    break;
+                }
+                case kOpOpen: {
+                    // Release is timed on its own, as a kernel close would be
+                    struct fuse_file_info fi = {};
+                    fi.flags = O_RDONLY;
+                    result = ops.open(path, &fi);
+                    timed(kOpOpen, result, start);
+                    if (result == 0) {
+                        start = MonotonicNs();
+                        timed(kOpRelease, ops.release(path, &fi), start);
+                    }
+                    continue;
+                }
+                case kOpRead:
+                    result = opened ? ops.read(path, buffer.data(), buffer.size(), offset, &handle) : -EBADF;
+                    break;
+                case kOpWrite:
+                    result = opened ? ops.write(path, buffer.data(), buffer.size(), offset, &handle) : -EBADF;
+                    break;
+                default:
+                    result = -ENOSYS;
+                    break;
+            }
+            timed(op, result, start);
+        }
+        offset += config.size;
+    }
+
+    if (opened) {
+        uint64_t start = MonotonicNs();
+        timed(kOpRelease, ops.release(path, &handle), start);
+    }
+    t_requestContext = nullptr;
+}
+
+void RunDispatchBench(FuseContext* ctx, const struct fuse_operations& ops,
+                      const DispatchBenchConfig& config, DispatchBenchResult *out) {
+    int threads = config.threads > 0 ? config.threads : 1;
+    std::unique_ptr<BenchThread[]> results(new BenchThread[threads]);
+    std::vector<std::thread> workers;
+
+    uint64_t startNs = MonotonicNs();
+    uint64_t deadlineNs = startNs + config.durationNs;
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(RunThread, ctx, std::cref(ops), std::cref(config), deadlineNs, &results[i]);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    out->elapsedNs = MonotonicNs() - startNs;
+
+    for (int i = 0; i < threads; i++) {
+        for (int op = 0; op < kOpCount; op++) {
+            results[i].latency[op].AddTo(&out->latency[op]);
+            out->errors[op] += results[i].errors[op];
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef FUSE3_BENCH_H
+#define FUSE3_BENCH_H
+
+#include <fuse3/fuse.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "fuse3_stats.h"
+
+struct FuseContext;
+
+// In-process dispatch benchmark: native threads call the FUSE operation
+// table directly, as libfuse worker threads would, against the instance's
+// JS handlers. No kernel mount is involved, so dispatch changes can be
+// measured on any box that loads the addon.
+struct DispatchBenchConfig {
+    std::vector<FuseOp> ops;  // Each thread cycles through these
+    int threads = 4;
+    uint64_t durationNs = 1000000000;
+    std::string path = "/bench";
+    size_t size = 4096;       // Bytes per read/write
+};
+
+struct DispatchBenchResult {
+    uint64_t elapsedNs = 0;
+    HistogramSnapshot latency[kOpCount];
+    uint64_t errors[kOpCount] = {};
+};
+
+// Operations the benchmark knows how to issue
+bool DispatchBenchSupports(FuseOp op);
+
+// Blocks until every thread finishes; never call it on the JS thread, which
+// has to serve the calls
+void RunDispatchBench(FuseContext* ctx, const struct fuse_operations& ops,
+                      const DispatchBenchConfig& config, DispatchBenchResult *out);
+
+#endif // FUSE3_BENCH_H
@@ -0,0 +1,125 @@
+#ifndef FUSE3_CONTEXT_H
+#define FUSE3_CONTEXT_H
+
+#include <napi.h>
+#include <fuse3/fuse.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+
+#include "fuse3_range_lock.h"
+#include "fuse3_inode_data.h"
+#include "fuse3_stats.h"
+#include "fuse3_trace.h"
+#include "fuse3_watchdog.h"
+#include "fuse3_hotpaths.h"
+#include "fuse3_control.h"
+#include "fuse3_lag.h"
+#include "fuse3_record.h"
+#include "fuse3_alloc.h"
+
+// How the kernel may cache files opened read-only (openCache option)
+enum OpenCachePolicy {
+    kOpenCacheDirect,  // direct_io: every read reaches the handler
+    kOpenCachePage,    // Page cache, dropped at each open
+    kOpenCacheKeep,    // Page cache kept across opens (keep_cache)
+};
+
+// Mount options understood by the native layer (third constructor argument)
+struct FuseOptions {
+    // Splice write data from /dev/fuse straight into JS-designated staging files
+    bool splice = false;
+    // Serve requests on a multi-threaded FUSE loop (fuse_loop_mt)
+    bool multithreaded = false;
+    // Let the kernel issue direct writes to a file concurrently
+    // (FOPEN_PARALLEL_DIRECT_WRITES); implies multithreaded. Overlapping
+    // writes are still ordered per handle by FileHandle::writeLock
+    bool parallelDirectWrites = false;
+    // Buffer writes natively per inode until flush/fsync/release and serve
+    // reads of open files from native data where possible
+    bool writeback = false;
+    // Buffered bytes past which a write commits its file synchronously: for
+    // that file, and for all files of the mount together
+    size_t maxFileDirtyBytes = 64 * 1024 * 1024;
+    size_t maxDirtyBytes = 256 * 1024 * 1024;
+    // Page cache use for read-only opens; writers always use direct_io
+    OpenCachePolicy openCache = kOpenCacheDirect;
+    // Name of the natively served control directory in the mount root, empty for none
+    std::string controlDir;
+    // Keep the count-min sketch and top-K of hot paths and directories
+    bool hotPaths = true;
+    // Report requests running longer than this (ns, per operation, 0 = never)
+    uint64_t slowThresholdNs[kOpCount] = {};
+    // Serve stale attributes while calls wait this long for the event loop (ns, 0 = never)
+    uint64_t lagThresholdNs = 0;
+};
+
+// Per-open-file state. fi->fh points at one of these between open and release.
+struct FileHandle {
+    FileHandle(uint64_t jsFh, int stagingFd) : jsFh(jsFh), stagingFd(stagingFd) {}
+
+    uint64_t jsFh;      // Handle returned by the JS open callback
+    int stagingFd;      // File that write data is spliced into, -1 if none (owned by JS)
+    bool writable = false;  // Opened for writing (or created): commits may go through jsFh
+    RangeLock writeLock;  // Serializes overlapping writes when parallelDirectWrites is on
+    std::shared_ptr<InodeData> inode;  // Shared native data of the file (writeback mode)
+    std::string controlData;  // Contents read from a control directory file
+};
+
+// FUSE operation callback context. Shared: calls queued on the TSFN without
+// waiting for them hold a reference, so the context outlives unmount until
+// they have run on the JS thread.
+struct FuseContext : std::enable_shared_from_this<FuseContext> {
+    Napi::ThreadSafeFunction tsfn;
+    Napi::ObjectReference operations;
+    std::string mountPoint;
+    struct fuse *fuse;
+    std::thread *fuseThread;
+    bool mounted;
+    std::atomic<bool> loopExited{false};  // The FUSE loop ran and has returned
+    FuseOptions options;
+    InodeTable inodes;  // Open files with native data (writeback mode)
+    OpStats stats;      // Per-operation latency and result counts
+    AllocStats allocs;  // Per-operation allocations (FUSE3_ALLOC_STATS builds)
+    RequestGauges gauges;  // Requests in progress
+    TraceBuffer trace;  // Request trace while startTrace() is active
+    RequestRecorder recorder;  // Request stream to a file while startRecording() is active
+    HotPaths hotPaths;  // Hottest paths/directories (options.hotPaths)
+    RequestWatchdog watchdog;  // Slow request detection (slowThresholds option)
+    ControlState control;  // Behind options.controlDir
+    LoopLagMonitor loopLag;  // TSFN queue wait; degradation with options.lagThresholdNs
+    StaleAttrCache staleAttrs;  // Served by getattr while loopLag degrades
+    Napi::FunctionReference onEvent;  // options.onEvent(type, info), may be empty
+};
+
+// Global map to store contexts by mount point (defined in fuse3_napi.cc)
+extern std::unordered_map<std::string, std::shared_ptr<FuseContext>> g_contexts;
+extern std::mutex g_contexts_mutex;
+// Context of the mount serving the request on this thread
+extern FuseContext* CurrentContext();
+
+// Set on threads that call the operations outside a FUSE session (the
+// dispatch benchmark), where fuse_get_context() has nothing to return
+extern thread_local struct fuse_context *t_requestContext;
+
+// Caller and mount of the request this thread is serving
+static inline struct fuse_context* RequestContext() {
+    return t_requestContext ? t_requestContext : fuse_get_context();
+}
+
+// Native handle behind a fuse_file_info, nullptr for files opened without one
+static inline FileHandle* GetFileHandle(const struct fuse_file_info *fi) {
+    return fi ? reinterpret_cast<FileHandle*>(fi->fh) : nullptr;
+}
+
+// Handle to pass to JS for a fuse_file_info
+static inline uint64_t GetJsFh(const struct fuse_file_info *fi) {
+    FileHandle* handle = GetFileHandle(fi);
+    return handle ? handle->jsFh : 0;
+}
+
+#endif // FUSE3_CONTEXT_H
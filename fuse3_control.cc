@@ -0,0 +1,634 @@
+#include "fuse3_control.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include "fuse3_context.h"
+#include "fuse3_log.h"
+
+// Flat "a.b.c" keys rendered either as "key value" lines or as nested JSON.
+// Keys sharing a prefix must be added next to each other.
+class ControlReport {
+public:
+    void Count(const std::string& key, uint64_t value) {
+        std::string text = std::to_string(value);
+        items_.push_back({key, text, text});
+    }
+
+    void Number(const std::string& key, double value) {
+        char text[32];
+        snprintf(text, sizeof(text), "%.3f", value);
+        items_.push_back({key, text, text});
+    }
+
+    void Flag(const std::string& key, bool value) {
+        items_.push_back({key, value ? "true" : "false", value ? "true" : "false"});
+    }
+
+    // Newlines are escaped in the text form so every item stays on one line
+    void String(const std::string& key, const std::string& value) {
+        std::string text;
+        for (char c : value) {
+            text += c == '\n' ? "\\n" : std::string(1, c);
+        }
+        items_.push_back({key, text, Quote(value)});
+    }
+
+    void List(const std::string& key, const std::vector<std::string>& values) {
+        std::string text;
+        std::string json = "[";
+        for (size_t i = 0; i < values.size(); i++) {
+            text += (i ? " " : "") + values[i];
+            json += (i ? "," : "") + Quote(values[i]);
+        }
+        items_.push_back({key, text, json + "]"});
+    }
+
+    // Non-empty buckets as "limitNs:count" pairs, or [[limitNs, count], ...]
+    void Buckets(const std::string& key, const HistogramSnapshot& histogram) {
+        std::string text;
+        std::string json = "[";
+        for (int i = 0; i < kHistogramBuckets; i++) {
+            if (histogram.buckets[i] == 0) {
+                continue;
+            }
+            std::string limit = std::to_string(HistogramBucketLimitNs(i));
+            std::string count = std::to_string(histogram.buckets[i]);
+            bool first = json.size() == 1;
+            text += (first ? "" : " ") + limit + ":" + count;
+            json += (first ? "[" : ",[") + limit + "," + count + "]";
+        }
+        items_.push_back({key, text, json + "]"});
+    }
+
+    std::string Text() const {
+        std::string out;
+        for (const Item& item : items_) {
+            out += item.key + " " + item.text + "\n";
+        }
+        return out;
+    }
+
+    std::string Json() const {
+        std::string out = "{";
+        std::vector<std::string> open;  // Objects currently open below the root
+        bool first = true;
+
+        for (const Item& item : items_) {
+            std::vector<std::string> parts;
+            for (size_t start = 0;;) {
+                size_t dot = item.key.find('.', start);
+                parts.push_back(item.key.substr(start, dot - start));
+                if (dot == std::string::npos) {
+                    break;
+                }
+                start = dot + 1;
+            }
+
+            size_t common = 0;
+            while (common < open.size() && common + 1 < parts.size() && open[common] == parts[common]) {
+                common++;
+            }
+            while (open.size() > common) {
+                out += '}';
+                open.pop_back();
+                first = false;
+            }
+            for (size_t i = common; i + 1 < parts.size(); i++) {
+                out += (first ? "" : ",") + Quote(parts[i]) + ":{";
+                open.push_back(parts[i]);
+                first = true;
+            }
+            out += (first ? "" : ",") + Quote(parts.back()) + ":" + item.json;
+            first = false;
+        }
+        out.append(open.size(), '}');
+        return out + "}\n";
+    }
+
+private:
+    struct Item {
+        std::string key;
+        std::string text;
+        std::string json;
+    };
+
+    static std::string Quote(const std::string& value) {
+        std::string out = "\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            } else {
+                out += c;
+            }
+        }
+        return out + "\"";
+    }
+
+    std::vector<Item> items_;
+};
+
+static void AddHistogram(ControlReport *report, const std::string& prefix, const HistogramSnapshot& histogram) {
+    report->Count(prefix + "count", histogram.count);
+    report->Number(prefix + "meanUs", histogram.MeanUs());
+    report->Number(prefix + "p50Us", histogram.PercentileUs(0.5));
+    report->Number(prefix + "p90Us", histogram.PercentileUs(0.9));
+    report->Number(prefix + "p99Us", histogram.PercentileUs(0.99));
+    report->Number(prefix + "p999Us", histogram.PercentileUs(0.999));
+    report->Number(prefix + "maxUs", static_cast<double>(histogram.maxNs) / 1000.0);
+}
+
+// Same shape as getStats()
+static void ReportStats(FuseContext* ctx, ControlReport *report) {
+    for (int op = 0; op < kOpCount; op++) {
+        OpSnapshot snapshot;
+        ctx->stats.Snapshot(static_cast<FuseOp>(op), &snapshot);
+        if (snapshot.latency.count == 0) {
+            continue;
+        }
+
+        std::string prefix = std::string("ops.") + OpName(static_cast<FuseOp>(op)) + ".";
+        AddHistogram(report, prefix, snapshot.latency);
+        report->Count(prefix + "errors", snapshot.errors);
+        report->Count(prefix + "bytes", snapshot.bytes);
+        report->Count(prefix + "jsCalls", snapshot.jsCalls);
+
+        for (int err = 1; err < kErrnoSlots; err++) {
+            if (snapshot.errnos[err] == 0) {
+                continue;
+            }
+            const char *name = err == kErrnoSlots - 1 ? "other" : ErrnoName(err);
+            report->Count(prefix + "errnos." + (name ? name : std::to_string(err)), snapshot.errnos[err]);
+        }
+        for (int stage = 0; stage < kStageCount; stage++) {
+            if (snapshot.stages[stage].count > 0) {
+                AddHistogram(report, prefix + "stages." + StageName(static_cast<RequestStage>(stage)) + ".",
+                             snapshot.stages[stage]);
+            }
+        }
+    }
+
+    CacheSnapshot cache;
+    ctx->stats.Snapshot(&cache);
+    for (int kind = 0; kind < kCacheKindCount; kind++) {
+        std::string prefix = std::string("cache.") + CacheKindName(static_cast<CacheKind>(kind)) + ".";
+        report->Count(prefix + "hits", cache.hits[kind]);
+        report->Count(prefix + "misses", cache.misses[kind]);
+    }
+
+    LagSnapshot lag;
+    ctx->loopLag.Snapshot(&lag, ctx->gauges.queued.load(std::memory_order_relaxed));
+    AddHistogram(report, "eventLoopLag.", lag.lag);
+    report->Number("eventLoopLag.currentUs", static_cast<double>(lag.currentNs) / 1000.0);
+    report->Flag("eventLoopLag.degraded", lag.degraded);
+    report->Count("eventLoopLag.episodes", lag.episodes);
+    report->Count("eventLoopLag.staleAttrs", lag.staleAttrs);
+}
+
+static void ReportHistograms(FuseContext* ctx, ControlReport *report) {
+    for (int op = 0; op < kOpCount; op++) {
+        OpSnapshot snapshot;
+        ctx->stats.Snapshot(static_cast<FuseOp>(op), &snapshot);
+        if (snapshot.latency.count == 0) {
+            continue;
+        }
+
+        std::string prefix = std::string("ops.") + OpName(static_cast<FuseOp>(op)) + ".";
+        report->Buckets(prefix + "latency", snapshot.latency);
+        for (int stage = 0; stage < kStageCount; stage++) {
+            if (snapshot.stages[stage].count > 0) {
+                report->Buckets(prefix + StageName(static_cast<RequestStage>(stage)), snapshot.stages[stage]);
+            }
+        }
+    }
+
+    LagSnapshot lag;
+    ctx->loopLag.Snapshot(&lag, ctx->gauges.queued.load(std::memory_order_relaxed));
+    if (lag.lag.count > 0) {
+        report->Buckets("eventLoopLag", lag.lag);
+    }
+}
+
+static void AddHotEntries(ControlReport *report, const std::string& prefix, const char *keyName,
+                          const std::vector<TopK::Entry>& entries) {
+    for (size_t i = 0; i < entries.size(); i++) {
+        std::string entryPrefix = prefix + std::to_string(i + 1) + ".";
+        report->String(entryPrefix + keyName, entries[i].key);
+        report->Count(entryPrefix + "count", entries[i].count);
+        report->Count(entryPrefix + "bytes", entries[i].bytes);
+    }
+}
+
+// Ranked from 1; pids are resolved to process names by the reader
+static void ReportHotPaths(FuseContext* ctx, ControlReport *report) {
+    if (!ctx->options.hotPaths) {
+        return;
+    }
+    AddHotEntries(report, "paths.byCount.", "path", ctx->hotPaths.PathsByCount());
+    AddHotEntries(report, "paths.byBytes.", "path", ctx->hotPaths.PathsByBytes());
+    AddHotEntries(report, "dirs.byCount.", "path", ctx->hotPaths.DirsByCount());
+    AddHotEntries(report, "dirs.byBytes.", "path", ctx->hotPaths.DirsByBytes());
+    AddHotEntries(report, "pids.byCount.", "pid", ctx->hotPaths.PidsByCount());
+    AddHotEntries(report, "pids.byBytes.", "pid", ctx->hotPaths.PidsByBytes());
+}
+
+static void ReportCache(FuseContext* ctx, ControlReport *report) {
+    report->Count("inodes.open", ctx->inodes.Count());
+    report->Count("inodes.dirtyBytes", ctx->inodes.DirtyBytes());
+    report->Count("inodes.dirtyLimitBytes", ctx->options.maxDirtyBytes);
+    report->Count("inodes.fileDirtyLimitBytes", ctx->options.maxFileDirtyBytes);
+    report->Count("inodes.dirtyLimitCommits", ctx->gauges.dirtyLimitCommits.load(std::memory_order_relaxed));
+    report->Count("inodes.memoryBytes", ctx->inodes.MemoryUsage());
+    report->Count("hotPaths.memoryBytes", ctx->options.hotPaths ? ctx->hotPaths.MemoryUsage() : 0);
+    report->Flag("trace.running", ctx->trace.Enabled());
+    report->Count("trace.memoryBytes", ctx->trace.MemoryUsage());
+    report->Count("staleAttrs.entries", ctx->staleAttrs.Count());
+    report->Count("staleAttrs.memoryBytes", ctx->staleAttrs.MemoryUsage());
+    report->Count("recorder.memoryBytes", ctx->recorder.MemoryUsage());
+    report->Count("opStats.memoryBytes", ctx->stats.MemoryUsage());
+    report->Count("loopLag.memoryBytes", sizeof(ctx->loopLag));
+    report->Count("allocStats.memoryBytes", sizeof(ctx->allocs));
+}
+
+static void ReportQueues(FuseContext* ctx, ControlReport *report) {
+    report->Count("requests.inflight", ctx->gauges.inflight.load(std::memory_order_relaxed));
+    report->Count("requests.waitingForJs", ctx->gauges.waiting.load(std::memory_order_relaxed));
+    report->Count("requests.queued", ctx->gauges.queued.load(std::memory_order_relaxed));
+    report->Count("log.dropped", LogDroppedCount());
+}
+
+static const struct {
+    uint64_t flag;
+    const char *name;
+} kCapabilities[] = {
+#ifdef FUSE_CAP_ASYNC_READ
+    { FUSE_CAP_ASYNC_READ, "ASYNC_READ" },
+#endif
+#ifdef FUSE_CAP_POSIX_LOCKS
+    { FUSE_CAP_POSIX_LOCKS, "POSIX_LOCKS" },
+#endif
+#ifdef FUSE_CAP_ATOMIC_O_TRUNC
+    { FUSE_CAP_ATOMIC_O_TRUNC, "ATOMIC_O_TRUNC" },
+#endif
+#ifdef FUSE_CAP_EXPORT_SUPPORT
+    { FUSE_CAP_EXPORT_SUPPORT, "EXPORT_SUPPORT" },
+#endif
+#ifdef FUSE_CAP_DONT_MASK
+    { FUSE_CAP_DONT_MASK, "DONT_MASK" },
+#endif
+#ifdef FUSE_CAP_SPLICE_WRITE
+    { FUSE_CAP_SPLICE_WRITE, "SPLICE_WRITE" },
+#endif
+#ifdef FUSE_CAP_SPLICE_MOVE
+    { FUSE_CAP_SPLICE_MOVE, "SPLICE_MOVE" },
+#endif
+#ifdef FUSE_CAP_SPLICE_READ
+    { FUSE_CAP_SPLICE_READ, "SPLICE_READ" },
+#endif
+#ifdef FUSE_CAP_FLOCK_LOCKS
+    { FUSE_CAP_FLOCK_LOCKS, "FLOCK_LOCKS" },
+#endif
+#ifdef FUSE_CAP_IOCTL_DIR
+    { FUSE_CAP_IOCTL_DIR, "IOCTL_DIR" },
+#endif
+#ifdef FUSE_CAP_AUTO_INVAL_DATA
+    { FUSE_CAP_AUTO_INVAL_DATA, "AUTO_INVAL_DATA" },
+#endif
+#ifdef FUSE_CAP_READDIRPLUS
+    { FUSE_CAP_READDIRPLUS, "READDIRPLUS" },
+#endif
+#ifdef FUSE_CAP_READDIRPLUS_AUTO
+    { FUSE_CAP_READDIRPLUS_AUTO, "READDIRPLUS_AUTO" },
+#endif
+#ifdef FUSE_CAP_ASYNC_DIO
+    { FUSE_CAP_ASYNC_DIO, "ASYNC_DIO" },
+#endif
+#ifdef FUSE_CAP_WRITEBACK_CACHE
+    { FUSE_CAP_WRITEBACK_CACHE, "WRITEBACK_CACHE" },
+#endif
+#ifdef FUSE_CAP_NO_OPEN_SUPPORT
+    { FUSE_CAP_NO_OPEN_SUPPORT, "NO_OPEN_SUPPORT" },
+#endif
+#ifdef FUSE_CAP_PARALLEL_DIROPS
+    { FUSE_CAP_PARALLEL_DIROPS, "PARALLEL_DIROPS" },
+#endif
+#ifdef FUSE_CAP_POSIX_ACL
+    { FUSE_CAP_POSIX_ACL, "POSIX_ACL" },
+#endif
+#ifdef FUSE_CAP_HANDLE_KILLPRIV
+    { FUSE_CAP_HANDLE_KILLPRIV, "HANDLE_KILLPRIV" },
+#endif
+#ifdef FUSE_CAP_CACHE_SYMLINKS
+    { FUSE_CAP_CACHE_SYMLINKS, "CACHE_SYMLINKS" },
+#endif
+#ifdef FUSE_CAP_NO_OPENDIR_SUPPORT
+    { FUSE_CAP_NO_OPENDIR_SUPPORT, "NO_OPENDIR_SUPPORT" },
+#endif
+#ifdef FUSE_CAP_EXPLICIT_INVAL_DATA
+    { FUSE_CAP_EXPLICIT_INVAL_DATA, "EXPLICIT_INVAL_DATA" },
+#endif
+#ifdef FUSE_CAP_EXPIRE_ONLY
+    { FUSE_CAP_EXPIRE_ONLY, "EXPIRE_ONLY" },
+#endif
+#ifdef FUSE_CAP_SETXATTR_EXT
+    { FUSE_CAP_SETXATTR_EXT, "SETXATTR_EXT" },
+#endif
+#ifdef FUSE_CAP_DIRECT_IO_ALLOW_MMAP
+    { FUSE_CAP_DIRECT_IO_ALLOW_MMAP, "DIRECT_IO_ALLOW_MMAP" },
+#endif
+#ifdef FUSE_CAP_PASSTHROUGH
+    { FUSE_CAP_PASSTHROUGH, "PASSTHROUGH" },
+#endif
+};
+
+static std::vector<std::string> CapabilityNames(unsigned mask) {
+    std::vector<std::string> names;
+    for (const auto& capability : kCapabilities) {
+        if (mask & capability.flag) {
+            names.push_back(capability.name);
+        }
+    }
+    return names;
+}
+
+static void ReportCapabilities(FuseContext* ctx, ControlReport *report) {
+    const ConnectionInfo& conn = ctx->control.connection;
+    report->String("proto", std::to_string(conn.protoMajor) + "." + std::to_string(conn.protoMinor));
+    report->Count("maxWrite", conn.maxWrite);
+    report->Count("maxRead", conn.maxRead);
+    report->Count("maxReadahead", conn.maxReadahead);
+    report->Count("maxBackground", conn.maxBackground);
+    report->Count("congestionThreshold", conn.congestionThreshold);
+    report->Count("timeGran", conn.timeGran);
+    report->List("capable", CapabilityNames(conn.capable));
+    report->List("want", CapabilityNames(conn.want));
+    report->Flag("options.splice", ctx->options.splice);
+    report->Flag("options.multithreaded", ctx->options.multithreaded);
+    report->Flag("options.parallelDirectWrites", ctx->options.parallelDirectWrites);
+    report->Flag("options.writeback", ctx->options.writeback);
+}
+
+template <void (*report)(FuseContext*, ControlReport*)>
+static std::string RenderText(FuseContext* ctx) {
+    ControlReport out;
+    report(ctx, &out);
+    return out.Text();
+}
+
+template <void (*report)(FuseContext*, ControlReport*)>
+static std::string RenderJson(FuseContext* ctx) {
+    ControlReport out;
+    report(ctx, &out);
+    return out.Json();
+}
+
+static std::string RenderLogLevel(FuseContext*) {
+    return LogDescribeLevels() + "\n";
+}
+
+static int ApplyLogLevel(FuseContext*, const std::string& input) {
+    if (!LogConfigure(input.c_str())) {
+        return -EINVAL;
+    }
+    LOG_INFO(kLogCore, "control: log level %s", LogDescribeLevels().c_str());
+    return 0;
+}
+
+static std::string RenderTrace(FuseContext* ctx) {
+    return ctx->trace.Enabled() ? "running\n" : "stopped\n";
+}
+
+// "start [capacity]" or "stop"; a stopped trace is kept for trace.json
+static int ApplyTrace(FuseContext* ctx, const std::string& input) {
+    if (input == "stop") {
+        if (!ctx->trace.Enabled()) {
+            return -EINVAL;
+        }
+        std::string json = ctx->trace.Stop();
+        std::lock_guard<std::mutex> lock(ctx->control.mutex);
+        ctx->control.lastTrace = std::move(json);
+        return 0;
+    }
+
+    if (input.compare(0, 5, "start") != 0 || (input.size() > 5 && input[5] != ' ')) {
+        return -EINVAL;
+    }
+    size_t capacity = TraceBuffer::kDefaultCapacity;
+    if (input.size() > 5) {
+        char *end = nullptr;
+        unsigned long long requested = strtoull(input.c_str() + 6, &end, 10);
+        if (requested == 0 || *end != '\0') {
+            return -EINVAL;
+        }
+        capacity = static_cast<size_t>(requested);
+    }
+    ctx->trace.Start(capacity);
+    return 0;
+}
+
+static std::string RenderLastTrace(FuseContext* ctx) {
+    std::lock_guard<std::mutex> lock(ctx->control.mutex);
+    return ctx->control.lastTrace;
+}
+
+static int ApplyDropCaches(FuseContext* ctx, const std::string&) {
+    size_t freed = ctx->inodes.DropClean();
+    LOG_INFO(kLogData, "control: dropped %zu bytes of clean data", freed);
+    return 0;
+}
+
+struct ControlFile {
+    const char *name;
+    mode_t mode;
+    std::string (*render)(FuseContext* ctx);                      // nullptr if write-only
+    int (*apply)(FuseContext* ctx, const std::string& input);     // nullptr if read-only
+};
+
+static const ControlFile kControlFiles[] = {
+    { "stats", 0444, RenderText<ReportStats>, nullptr },
+    { "stats.json", 0444, RenderJson<ReportStats>, nullptr },
+    { "histograms", 0444, RenderText<ReportHistograms>, nullptr },
+    { "histograms.json", 0444, RenderJson<ReportHistograms>, nullptr },
+    { "cache", 0444, RenderText<ReportCache>, nullptr },
+    { "cache.json", 0444, RenderJson<ReportCache>, nullptr },
+    { "queues", 0444, RenderText<ReportQueues>, nullptr },
+    { "queues.json", 0444, RenderJson<ReportQueues>, nullptr },
+    { "hotpaths", 0444, RenderText<ReportHotPaths>, nullptr },
+    { "hotpaths.json", 0444, RenderJson<ReportHotPaths>, nullptr },
+    { "capabilities", 0444, RenderText<ReportCapabilities>, nullptr },
+    { "capabilities.json", 0444, RenderJson<ReportCapabilities>, nullptr },
+    { "log_level", 0644, RenderLogLevel, ApplyLogLevel },
+    { "trace", 0644, RenderTrace, ApplyTrace },
+    { "trace.json", 0444, RenderLastTrace, nullptr },
+    { "drop_caches", 0200, nullptr, ApplyDropCaches },
+};
+
+// Part of a control path after the directory name: "" for the directory, "/name" for a file
+static const char *ControlRest(FuseContext* ctx, const char *path) {
+    return path + ctx->options.controlDir.size() + 1;
+}
+
+static const ControlFile *FindControlFile(const char *rest) {
+    if (rest[0] != '/') {
+        return nullptr;
+    }
+    for (const ControlFile& file : kControlFiles) {
+        if (strcmp(rest + 1, file.name) == 0) {
+            return &file;
+        }
+    }
+    return nullptr;
+}
+
+// Only the user running the mount (or root) may change settings
+static bool MayWrite() {
+    uid_t caller = RequestContext()->uid;
+    return caller == 0 || caller == getuid();
+}
+
+void ControlNoteConnection(FuseContext* ctx, const struct fuse_conn_info *conn) {
+    ConnectionInfo& info = ctx->control.connection;
+    info.protoMajor = conn->proto_major;
+    info.protoMinor = conn->proto_minor;
+    info.maxWrite = conn->max_write;
+    info.maxRead = conn->max_read;
+    info.maxReadahead = conn->max_readahead;
+    info.maxBackground = conn->max_background;
+    info.congestionThreshold = conn->congestion_threshold;
+    info.timeGran = conn->time_gran;
+    info.capable = conn->capable;
+    info.want = conn->want;
+    ctx->control.mountTime = time(nullptr);
+}
+
+int ControlGetattr(FuseContext* ctx, const char *path, struct stat *stbuf) {
+    memset(stbuf, 0, sizeof(struct stat));
+    const char *rest = ControlRest(ctx, path);
+
+    if (rest[0] == '\0') {
+        stbuf->st_mode = S_IFDIR | 0555;
+        stbuf->st_nlink = 2;
+    } else {
+        const ControlFile *file = FindControlFile(rest);
+        if (!file) {
+            return -ENOENT;
+        }
+        // Contents are made at open and read with direct_io, so no size is needed
+        stbuf->st_mode = S_IFREG | file->mode;
+        stbuf->st_nlink = 1;
+    }
+
+    stbuf->st_uid = getuid();
+    stbuf->st_gid = getgid();
+    stbuf->st_atime = stbuf->st_mtime = stbuf->st_ctime = ctx->control.mountTime;
+    return 0;
+}
+
+int ControlReaddir(FuseContext* ctx, const char *path, void *buf, fuse_fill_dir_t filler) {
+    if (ControlRest(ctx, path)[0] != '\0') {
+        return FindControlFile(ControlRest(ctx, path)) ? -ENOTDIR : -ENOENT;
+    }
+
+    enum fuse_fill_dir_flags flags = static_cast<enum fuse_fill_dir_flags>(0);
+    filler(buf, ".", nullptr, 0, flags);
+    filler(buf, "..", nullptr, 0, flags);
+    for (const ControlFile& file : kControlFiles) {
+        filler(buf, file.name, nullptr, 0, flags);
+    }
+    return 0;
+}
+
+int ControlAccess(FuseContext* ctx, const char *path, int mask) {
+    const char *rest = ControlRest(ctx, path);
+    if (rest[0] == '\0') {
+        return (mask & W_OK) ? -EACCES : 0;
+    }
+
+    const ControlFile *file = FindControlFile(rest);
+    if (!file) {
+        return -ENOENT;
+    }
+    if (((mask & R_OK) && !file->render) || ((mask & W_OK) && (!file->apply || !MayWrite())) || (mask & X_OK)) {
+        return -EACCES;
+    }
+    return 0;
+}
+
+int ControlOpen(FuseContext* ctx, const char *path, struct fuse_file_info *fi) {
+    const ControlFile *file = FindControlFile(ControlRest(ctx, path));
+    if (!file) {
+        return ControlRest(ctx, path)[0] == '\0' ? -EISDIR : -ENOENT;
+    }
+
+    int access = fi->flags & O_ACCMODE;
+    bool reading = access != O_WRONLY;
+    bool writing = access != O_RDONLY;
+    if ((reading && !file->render) || (writing && (!file->apply || !MayWrite()))) {
+        return -EACCES;
+    }
+
+    FileHandle* handle = new FileHandle(0, -1);
+    if (reading) {
+        // One snapshot per open, so a reader sees consistent contents
+        handle->controlData = file->render(ctx);
+    }
+    fi->fh = reinterpret_cast<uint64_t>(handle);
+    fi->direct_io = 1;
+    return 0;
+}
+
+int ControlRead(struct fuse_file_info *fi, char *buf, size_t size, off_t offset) {
+    FileHandle* handle = GetFileHandle(fi);
+    if (!handle) {
+        return -EBADF;
+    }
+
+    const std::string& data = handle->controlData;
+    if (offset < 0 || static_cast<size_t>(offset) >= data.size()) {
+        return 0;
+    }
+    size_t count = std::min(size, data.size() - static_cast<size_t>(offset));
+    memcpy(buf, data.data() + offset, count);
+    return static_cast<int>(count);
+}
+
+// Each write is one command; trailing whitespace (echo's newline) is ignored
+int ControlWrite(FuseContext* ctx, const char *path, const char *buf, size_t size) {
+    const ControlFile *file = FindControlFile(ControlRest(ctx, path));
+    if (!file || !file->apply) {
+        return -EACCES;
+    }
+
+    std::string input(buf, size);
+    while (!input.empty() && isspace(static_cast<unsigned char>(input.back()))) {
+        input.pop_back();
+    }
+    int result = file->apply(ctx, input);
+    return result < 0 ? result : static_cast<int>(size);
+}
+
+// O_TRUNC on a writable file (echo > file) is fine; there is nothing to truncate
+int ControlTruncate(FuseContext* ctx, const char *path) {
+    const ControlFile *file = FindControlFile(ControlRest(ctx, path));
+    if (!file) {
+        return ControlRest(ctx, path)[0] == '\0' ? -EISDIR : -ENOENT;
+    }
+    return file->apply && MayWrite() ? 0 : -EACCES;
+}
+
+int ControlRelease(struct fuse_file_info *fi) {
+    delete GetFileHandle(fi);
+    fi->fh = 0;
+    return 0;
+}
@@ -0,0 +1,61 @@
+#ifndef FUSE3_CONTROL_H
+#define FUSE3_CONTROL_H
+
+#include <fuse3/fuse.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <time.h>
+#include <mutex>
+#include <string>
+
+struct FuseContext;
+
+// What fuse3_init negotiated with the kernel
+struct ConnectionInfo {
+    unsigned protoMajor;
+    unsigned protoMinor;
+    unsigned maxWrite;
+    unsigned maxRead;
+    unsigned maxReadahead;
+    unsigned maxBackground;
+    unsigned congestionThreshold;
+    unsigned timeGran;
+    unsigned capable;
+    unsigned want;
+};
+
+// Per-mount state behind the control directory (options.controlDir)
+struct ControlState {
+    ConnectionInfo connection = {};  // Written once by fuse3_init, before any request
+    time_t mountTime = 0;
+
+    std::mutex mutex;
+    std::string lastTrace;  // JSON of the last trace stopped through the trace file
+};
+
+// The control directory itself or anything below it. dir is its name in
+// the mount root, empty when the control directory is off.
+static inline bool IsControlPath(const std::string& dir, const char *path) {
+    if (dir.empty() || path[0] != '/' || strncmp(path + 1, dir.c_str(), dir.size()) != 0) {
+        return false;
+    }
+    char next = path[dir.size() + 1];
+    return next == '\0' || next == '/';
+}
+
+// Remember the negotiated connection for the capabilities file
+void ControlNoteConnection(FuseContext* ctx, const struct fuse_conn_info *conn);
+
+// Operations on control paths. They are answered natively and never reach
+// JS, so the directory stays readable while the event loop is stuck.
+int ControlGetattr(FuseContext* ctx, const char *path, struct stat *stbuf);
+int ControlReaddir(FuseContext* ctx, const char *path, void *buf, fuse_fill_dir_t filler);
+int ControlAccess(FuseContext* ctx, const char *path, int mask);
+int ControlOpen(FuseContext* ctx, const char *path, struct fuse_file_info *fi);
+int ControlRead(struct fuse_file_info *fi, char *buf, size_t size, off_t offset);
+int ControlWrite(FuseContext* ctx, const char *path, const char *buf, size_t size);
+int ControlTruncate(FuseContext* ctx, const char *path);
+int ControlRelease(struct fuse_file_info *fi);
+
+#endif // FUSE3_CONTROL_H
@@ -0,0 +1,243 @@
+#include "fuse3_hotpaths.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+static const uint64_t kFnvOffset = 14695981039346656037ULL;
+static const uint64_t kFnvPrime = 1099511628211ULL;
+
+CountMinSketch::CountMinSketch() {
+    Reset();
+}
+
+// Row indexes from one 64-bit hash (Kirsch-Mitzenmacher double hashing)
+size_t CountMinSketch::Index(uint64_t hash, int row) {
+    uint64_t h1 = hash;
+    uint64_t h2 = (hash >> 32) | 1;
+    return static_cast<size_t>((h1 + static_cast<uint64_t>(row) * h2) % kWidth);
+}
+
+void CountMinSketch::Add(uint64_t hash, uint64_t bytes, uint64_t *count, uint64_t *totalBytes) {
+    uint64_t minCount = UINT64_MAX;
+    uint64_t minBytes = UINT64_MAX;
+    for (int row = 0; row < kDepth; row++) {
+        Cell& cell = cells_[row][Index(hash, row)];
+        minCount = std::min(minCount, cell.count.fetch_add(1, std::memory_order_relaxed) + 1);
+        uint64_t cellBytes = bytes ? cell.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes
+                                   : cell.bytes.load(std::memory_order_relaxed);
+        minBytes = std::min(minBytes, cellBytes);
+    }
+    *count = minCount;
+    *totalBytes = minBytes;
+}
+
+void CountMinSketch::Estimate(uint64_t hash, uint64_t *count, uint64_t *totalBytes) const {
+    uint64_t minCount = UINT64_MAX;
+    uint64_t minBytes = UINT64_MAX;
+    for (int row = 0; row < kDepth; row++) {
+        const Cell& cell = cells_[row][Index(hash, row)];
+        minCount = std::min(minCount, cell.count.load(std::memory_order_relaxed));
+        minBytes = std::min(minBytes, cell.bytes.load(std::memory_order_relaxed));
+    }
+    *count = minCount;
+    *totalBytes = minBytes;
+}
+
+void CountMinSketch::Reset() {
+    for (auto& row : cells_) {
+        for (auto& cell : row) {
+            cell.count.store(0, std::memory_order_relaxed);
+            cell.bytes.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+TopK::TopK(const CountMinSketch *sketch, bool byBytes) : sketch_(sketch), byBytes_(byBytes) {
+    Reset();
+}
+
+uint64_t TopK::Metric(uint64_t hash) const {
+    uint64_t count;
+    uint64_t bytes;
+    sketch_->Estimate(hash, &count, &bytes);
+    return byBytes_ ? bytes : count;
+}
+
+void TopK::Offer(uint64_t hash, const char *key, size_t keyLength, uint64_t estimate, FuseOp op) {
+    if (hash == 0) {
+        hash = 1;  // 0 marks an empty slot
+    }
+
+    for (int i = 0; i < kSize; i++) {
+        if (hashes_[i].load(std::memory_order_relaxed) == hash) {
+            ops_[i][op].fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    if (estimate == 0 || estimate <= floor_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Take an empty slot, or the coldest member if this key is now hotter
+    int victim = -1;
+    uint64_t coldest = UINT64_MAX;
+    uint64_t secondColdest = UINT64_MAX;
+    for (int i = 0; i < kSize; i++) {
+        uint64_t member = hashes_[i].load(std::memory_order_relaxed);
+        if (member == hash) {
+            return;  // Admitted by another thread meanwhile
+        }
+        uint64_t metric = member ? Metric(member) : 0;
+        if (metric < coldest) {
+            secondColdest = coldest;
+            coldest = metric;
+            victim = i;
+        } else if (metric < secondColdest) {
+            secondColdest = metric;
+        }
+    }
+
+    if (coldest >= estimate) {
+        floor_.store(coldest, std::memory_order_relaxed);
+        return;
+    }
+
+    hashes_[victim].store(0, std::memory_order_relaxed);
+    keys_[victim].assign(key, keyLength);
+    for (auto& count : ops_[victim]) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    ops_[victim][op].store(1, std::memory_order_relaxed);
+    hashes_[victim].store(hash, std::memory_order_relaxed);
+
+    // The new member may itself be the coldest now
+    floor_.store(std::min(secondColdest, estimate), std::memory_order_relaxed);
+}
+
+std::vector<TopK::Entry> TopK::Snapshot() const {
+    std::vector<Entry> entries;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < kSize; i++) {
+        uint64_t hash = hashes_[i].load(std::memory_order_relaxed);
+        if (hash == 0) {
+            continue;
+        }
+
+        Entry entry;
+        entry.key = keys_[i];
+        sketch_->Estimate(hash, &entry.count, &entry.bytes);
+        for (int op = 0; op < kOpCount; op++) {
+            entry.ops[op] = ops_[i][op].load(std::memory_order_relaxed);
+        }
+        entries.push_back(std::move(entry));
+    }
+
+    bool byBytes = byBytes_;
+    std::sort(entries.begin(), entries.end(), [byBytes](const Entry& a, const Entry& b) {
+        return byBytes ? a.bytes > b.bytes : a.count > b.count;
+    });
+    return entries;
+}
+
+void TopK::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < kSize; i++) {
+        hashes_[i].store(0, std::memory_order_relaxed);
+        keys_[i].clear();
+        for (auto& count : ops_[i]) {
+            count.store(0, std::memory_order_relaxed);
+        }
+    }
+    floor_.store(0, std::memory_order_relaxed);
+}
+
+size_t TopK::KeyBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t total = 0;
+    for (const auto& key : keys_) {
+        total += key.capacity();
+    }
+    return total;
+}
+
+HotPaths::HotPaths()
+    : pathsByCount_(&paths_, false), pathsByBytes_(&paths_, true),
+      dirsByCount_(&dirs_, false), dirsByBytes_(&dirs_, true),
+      pidsByCount_(&pids_, false), pidsByBytes_(&pids_, true) {
+}
+
+// splitmix64 finalizer, so neighbouring pids land in unrelated cells
+static uint64_t HashPid(pid_t pid) {
+    uint64_t x = static_cast<uint64_t>(pid) + 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+void HotPaths::Record(FuseOp op, const char *path, pid_t pid, uint64_t bytes) {
+    uint64_t count;
+    uint64_t totalBytes;
+
+    uint64_t pidHash = HashPid(pid);
+    char pidKey[16];
+    int pidLength = snprintf(pidKey, sizeof(pidKey), "%d", static_cast<int>(pid));
+    pids_.Add(pidHash, bytes, &count, &totalBytes);
+    pidsByCount_.Offer(pidHash, pidKey, static_cast<size_t>(pidLength), count, op);
+    if (bytes > 0) {
+        pidsByBytes_.Offer(pidHash, pidKey, static_cast<size_t>(pidLength), totalBytes, op);
+    }
+
+    // Hash the path and its parent directory in one pass
+    uint64_t hash = kFnvOffset;
+    uint64_t dirHash = kFnvOffset;
+    size_t dirLength = 1;  // "/" for top-level entries
+    size_t length = 0;
+    for (const char *p = path; *p; p++, length++) {
+        if (*p == '/' && length > 0) {
+            dirHash = hash;
+            dirLength = length;
+        }
+        hash ^= static_cast<unsigned char>(*p);
+        hash *= kFnvPrime;
+    }
+    if (length <= 1) {
+        return;  // The root has no parent worth counting
+    }
+    if (dirLength == 1) {
+        dirHash = (kFnvOffset ^ '/') * kFnvPrime;
+    }
+
+    paths_.Add(hash, bytes, &count, &totalBytes);
+    pathsByCount_.Offer(hash, path, length, count, op);
+    if (bytes > 0) {
+        pathsByBytes_.Offer(hash, path, length, totalBytes, op);
+    }
+
+    dirs_.Add(dirHash, bytes, &count, &totalBytes);
+    dirsByCount_.Offer(dirHash, path, dirLength, count, op);
+    if (bytes > 0) {
+        dirsByBytes_.Offer(dirHash, path, dirLength, totalBytes, op);
+    }
+}
+
+void HotPaths::Reset() {
+    paths_.Reset();
+    dirs_.Reset();
+    pids_.Reset();
+    pathsByCount_.Reset();
+    pathsByBytes_.Reset();
+    dirsByCount_.Reset();
+    dirsByBytes_.Reset();
+    pidsByCount_.Reset();
+    pidsByBytes_.Reset();
+}
+
+size_t HotPaths::MemoryUsage() const {
+    return sizeof(HotPaths) + pathsByCount_.KeyBytes() + pathsByBytes_.KeyBytes() +
+           dirsByCount_.KeyBytes() + dirsByBytes_.KeyBytes() + pidsByCount_.KeyBytes() + pidsByBytes_.KeyBytes();
+}
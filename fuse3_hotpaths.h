@@ -0,0 +1,105 @@
+#ifndef FUSE3_HOTPATHS_H
+#define FUSE3_HOTPATHS_H
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "fuse3_stats.h"
+
+// Count-min sketch of request counts and bytes. Estimates never undercount;
+// they overcount by at most e/kWidth of the total with probability
+// 1 - e^-kDepth. Updates are relaxed atomic adds, so any thread may record.
+class CountMinSketch {
+public:
+    static const int kDepth = 4;
+    static const int kWidth = 2048;
+
+    CountMinSketch();
+
+    // Add one request of bytes; returns the updated estimates
+    void Add(uint64_t hash, uint64_t bytes, uint64_t *count, uint64_t *totalBytes);
+    void Estimate(uint64_t hash, uint64_t *count, uint64_t *totalBytes) const;
+    void Reset();
+
+private:
+    struct Cell {
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> bytes;
+    };
+
+    static size_t Index(uint64_t hash, int row);
+
+    Cell cells_[kDepth][kWidth];
+};
+
+// Hottest keys by one sketch metric. Members are found with a lock-free scan;
+// the lock is only taken when a non-member's estimate beats the coldest
+// member, which with skewed traffic is rare once the set has settled.
+class TopK {
+public:
+    static const int kSize = 32;
+
+    struct Entry {
+        std::string key;
+        uint64_t count;
+        uint64_t bytes;
+        uint64_t ops[kOpCount];     // Requests per operation since the key entered the set
+    };
+
+    TopK(const CountMinSketch *sketch, bool byBytes);
+
+    void Offer(uint64_t hash, const char *key, size_t keyLength, uint64_t estimate, FuseOp op);
+    std::vector<Entry> Snapshot() const;
+    void Reset();
+    size_t KeyBytes() const;
+
+private:
+    uint64_t Metric(uint64_t hash) const;
+
+    const CountMinSketch *sketch_;
+    bool byBytes_;
+
+    std::atomic<uint64_t> hashes_[kSize];   // 0 = empty slot
+    std::atomic<uint64_t> floor_;           // Coldest member's estimate when last checked, 0 while not full
+    std::atomic<uint64_t> ops_[kSize][kOpCount];
+
+    mutable std::mutex mutex_;
+    std::string keys_[kSize];
+};
+
+// Traffic per path, per parent directory and per calling process for one
+// mount, in constant memory
+class HotPaths {
+public:
+    HotPaths();
+
+    void Record(FuseOp op, const char *path, pid_t pid, uint64_t bytes);
+    void Reset();
+
+    std::vector<TopK::Entry> PathsByCount() const { return pathsByCount_.Snapshot(); }
+    std::vector<TopK::Entry> PathsByBytes() const { return pathsByBytes_.Snapshot(); }
+    std::vector<TopK::Entry> DirsByCount() const { return dirsByCount_.Snapshot(); }
+    std::vector<TopK::Entry> DirsByBytes() const { return dirsByBytes_.Snapshot(); }
+    std::vector<TopK::Entry> PidsByCount() const { return pidsByCount_.Snapshot(); }   // Keys are decimal pids
+    std::vector<TopK::Entry> PidsByBytes() const { return pidsByBytes_.Snapshot(); }
+
+    size_t MemoryUsage() const;
+
+private:
+    CountMinSketch paths_;
+    CountMinSketch dirs_;
+    CountMinSketch pids_;
+    TopK pathsByCount_;
+    TopK pathsByBytes_;
+    TopK dirsByCount_;
+    TopK dirsByBytes_;
+    TopK pidsByCount_;
+    TopK pidsByBytes_;
+};
+
+#endif // FUSE3_HOTPATHS_H
@@ -0,0 +1,516 @@
+#include "fuse3_inode_data.h"
+
+#include <string.h>
+#include <algorithm>
+#include <iterator>
+
+// Clean data kept per open inode; reads beyond this go to JS every time
+static const size_t kMaxCleanBytes = 64 * 1024 * 1024;
+
+static off_t ExtentEnd(const ExtentMap::const_iterator& it) {
+    return it->first + static_cast<off_t>(it->second.size());
+}
+
+// Extent containing pos, or end()
+static ExtentMap::const_iterator FindContaining(const ExtentMap& extents, off_t pos) {
+    auto it = extents.upper_bound(pos);
+    if (it == extents.begin()) {
+        return extents.end();
+    }
+    --it;
+    return pos < ExtentEnd(it) ? it : extents.end();
+}
+
+// Merge [offset, offset + size) into extents, coalescing with anything it
+// overlaps or touches. With overwrite the new data wins where it overlaps,
+// otherwise only holes are filled. Returns the change in bytes held.
+static ssize_t InsertExtent(ExtentMap& extents, off_t offset, const char *data, size_t size,
+                            bool overwrite) {
+    if (size == 0) {
+        return 0;
+    }
+
+    off_t end = offset + static_cast<off_t>(size);
+
+    auto first = extents.lower_bound(offset);
+    if (first != extents.begin()) {
+        auto prev = std::prev(first);
+        if (ExtentEnd(prev) >= offset) {
+            first = prev;
+        }
+    }
+
+    off_t mergedStart = offset;
+    off_t mergedEnd = end;
+    size_t removed = 0;
+    auto last = first;
+    while (last != extents.end() && last->first <= end) {
+        mergedStart = std::min(mergedStart, last->first);
+        mergedEnd = std::max(mergedEnd, ExtentEnd(last));
+        removed += last->second.size();
+        ++last;
+    }
+
+    std::string merged(static_cast<size_t>(mergedEnd - mergedStart), '\0');
+    if (!overwrite) {
+        memcpy(&merged[offset - mergedStart], data, size);
+    }
+    for (auto it = first; it != last; ++it) {
+        memcpy(&merged[it->first - mergedStart], it->second.data(), it->second.size());
+    }
+    if (overwrite) {
+        memcpy(&merged[offset - mergedStart], data, size);
+    }
+
+    extents.erase(first, last);
+    extents.emplace(mergedStart, std::move(merged));
+
+    return static_cast<ssize_t>(mergedEnd - mergedStart) - static_cast<ssize_t>(removed);
+}
+
+InodeData::InodeData(std::atomic<size_t> *mountDirty)
+    : mountDirty_(mountDirty), dirtyBytes_(0), cleanBytes_(0), size_(0), sizeKnown_(false), writtenEnd_(0),
+      mtime_(0), attrKnown_(false), truncatePending_(false), truncateMin_(0) {
+    memset(&attr_, 0, sizeof(attr_));
+}
+
+InodeData::~InodeData() {
+    // Dirty data whose commit never succeeded goes with the last handle
+    SetDirtyBytesLocked(0);
+}
+
+size_t InodeData::Write(off_t offset, const char *data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    SetDirtyBytesLocked(dirtyBytes_ + InsertExtent(dirty_, offset, data, size, true));
+    ExtendLocked(offset + static_cast<off_t>(size));
+    return dirtyBytes_;
+}
+
+void InodeData::SetDirtyBytesLocked(size_t bytes) {
+    if (mountDirty_) {
+        if (bytes >= dirtyBytes_) {
+            mountDirty_->fetch_add(bytes - dirtyBytes_, std::memory_order_relaxed);
+        } else {
+            mountDirty_->fetch_sub(dirtyBytes_ - bytes, std::memory_order_relaxed);
+        }
+    }
+    dirtyBytes_ = bytes;
+}
+
+void InodeData::NoteWrite(off_t end) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ExtendLocked(end);
+}
+
+void InodeData::Replaced(off_t offset, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    off_t end = offset + static_cast<off_t>(size);
+    size_t dirtyBytes = dirtyBytes_;
+    DropRange(dirty_, dirtyBytes, offset, end);
+    SetDirtyBytesLocked(dirtyBytes);
+    DropRange(clean_, cleanBytes_, offset, end);
+    ExtendLocked(end);
+}
+
+void InodeData::ExtendLocked(off_t end) {
+    writtenEnd_ = std::max(writtenEnd_, end);
+    if (sizeKnown_) {
+        size_ = std::max(size_, end);
+    }
+    mtime_ = time(nullptr);
+}
+
+void InodeData::Fill(off_t offset, const char *data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (cleanBytes_ >= kMaxCleanBytes) {
+        return;
+    }
+    // JS still has the old contents past a truncate it has not seen
+    off_t limit = truncatePending_ ? truncateMin_ : (sizeKnown_ ? size_ : -1);
+    if (limit >= 0) {
+        if (offset >= limit) {
+            return;
+        }
+        size = std::min(size, static_cast<size_t>(limit - offset));
+    }
+    cleanBytes_ += InsertExtent(clean_, offset, data, size, false);
+}
+
+ssize_t InodeData::Read(off_t offset, char *out, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    off_t end = offset + static_cast<off_t>(size);
+    if (sizeKnown_) {
+        if (offset >= size_) {
+            return 0;
+        }
+        end = std::min(end, size_);
+    }
+
+    if (!Covered(offset, end)) {
+        return -1;
+    }
+
+    size_t count = static_cast<size_t>(end - offset);
+    ZeroHole(offset, out, count);
+    CopyOut(clean_, offset, out, count);
+    CopyOut(dirty_, offset, out, count);
+    return static_cast<ssize_t>(count);
+}
+
+size_t InodeData::Overlay(off_t offset, char *out, size_t size, size_t jsBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    off_t validEnd = sizeKnown_ ? size_ : std::max(offset + static_cast<off_t>(jsBytes), writtenEnd_);
+    size_t count = validEnd > offset ? std::min(size, static_cast<size_t>(validEnd - offset)) : 0;
+
+    // Bytes JS did not return but the native size covers are a hole
+    if (count > jsBytes) {
+        memset(out + jsBytes, 0, count - jsBytes);
+    }
+
+    ZeroHole(offset, out, count);
+    CopyOut(clean_, offset, out, count);
+    CopyOut(dirty_, offset, out, count);
+    return count;
+}
+
+void InodeData::Truncate(off_t size, bool deferred) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t dirtyBytes = dirtyBytes_;
+    DropBeyond(dirty_, dirtyBytes, size);
+    SetDirtyBytesLocked(dirtyBytes);
+    DropBeyond(clean_, cleanBytes_, size);
+    size_ = size;
+    sizeKnown_ = true;
+    writtenEnd_ = std::min(writtenEnd_, size);
+    mtime_ = time(nullptr);
+
+    if (deferred) {
+        truncateMin_ = truncatePending_ ? std::min(truncateMin_, size) : size;
+        truncatePending_ = true;
+    }
+}
+
+void InodeData::UpdateAttr(struct stat *stbuf) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    attr_ = *stbuf;
+    attrKnown_ = true;
+
+    // The first size JS reports while open becomes the baseline native writes build on
+    if (!sizeKnown_) {
+        size_ = std::max(stbuf->st_size, writtenEnd_);
+        sizeKnown_ = true;
+    }
+    stbuf->st_size = size_;
+    if (mtime_ > stbuf->st_mtime) {
+        stbuf->st_mtime = mtime_;
+        stbuf->st_ctime = mtime_;
+    }
+}
+
+bool InodeData::GetAttr(struct stat *stbuf) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!attrKnown_ || !sizeKnown_) {
+        return false;
+    }
+
+    *stbuf = attr_;
+    stbuf->st_size = size_;
+    if (mtime_ > stbuf->st_mtime) {
+        stbuf->st_mtime = mtime_;
+        stbuf->st_ctime = mtime_;
+    }
+    return true;
+}
+
+void InodeData::InvalidateAttr() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    attrKnown_ = false;
+    mtime_ = 0;  // An explicit utimens wins over the implicit write mtime
+}
+
+bool InodeData::TakePendingTruncate(off_t *minSize, off_t *finalSize) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!truncatePending_) {
+        return false;
+    }
+    *minSize = truncateMin_;
+    *finalSize = size_;
+    truncatePending_ = false;
+    return true;
+}
+
+void InodeData::RestorePendingTruncate(off_t minSize) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // size_ already is the final size to replay
+    truncateMin_ = truncatePending_ ? std::min(truncateMin_, minSize) : minSize;
+    truncatePending_ = true;
+}
+
+void InodeData::AddWriter(uint64_t jsFh) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    writerFhs_.push_back(jsFh);
+}
+
+void InodeData::RemoveWriter(uint64_t jsFh) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = std::find(writerFhs_.begin(), writerFhs_.end(), jsFh);
+    if (it != writerFhs_.end()) {
+        writerFhs_.erase(it);
+    }
+}
+
+bool InodeData::WriterFh(uint64_t *jsFh) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (writerFhs_.empty()) {
+        return false;
+    }
+    *jsFh = writerFhs_.front();
+    return true;
+}
+
+bool InodeData::NeedsCommit() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !dirty_.empty() || truncatePending_;
+}
+
+ExtentMap InodeData::TakeDirty() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    ExtentMap taken;
+    taken.swap(dirty_);
+    SetDirtyBytesLocked(0);
+
+    for (const auto& extent : taken) {
+        cleanBytes_ += InsertExtent(clean_, extent.first, extent.second.data(), extent.second.size(), true);
+    }
+    return taken;
+}
+
+void InodeData::RestoreDirty(ExtentMap extents) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    ExtentMap newer;
+    newer.swap(dirty_);
+
+    size_t bytes = 0;
+    for (const auto& extent : extents) {
+        bytes += InsertExtent(dirty_, extent.first, extent.second.data(), extent.second.size(), true);
+    }
+    for (const auto& extent : newer) {
+        bytes += InsertExtent(dirty_, extent.first, extent.second.data(), extent.second.size(), true);
+    }
+    SetDirtyBytesLocked(bytes);
+}
+
+size_t InodeData::MemoryUsage() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dirtyBytes_ + cleanBytes_;
+}
+
+size_t InodeData::DirtyBytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dirtyBytes_;
+}
+
+size_t InodeData::DropClean() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t freed = cleanBytes_;
+    clean_.clear();
+    cleanBytes_ = 0;
+    attrKnown_ = false;
+    return freed;
+}
+
+bool InodeData::Covered(off_t start, off_t end) const {
+    off_t pos = start;
+    while (pos < end) {
+        if (truncatePending_ && pos >= truncateMin_) {
+            return true;  // The rest is written data or the zero hole
+        }
+
+        off_t next = pos;
+
+        auto dirty = FindContaining(dirty_, pos);
+        if (dirty != dirty_.end()) {
+            next = std::max(next, ExtentEnd(dirty));
+        }
+        auto clean = FindContaining(clean_, pos);
+        if (clean != clean_.end()) {
+            next = std::max(next, ExtentEnd(clean));
+        }
+
+        if (next == pos) {
+            return false;
+        }
+        pos = next;
+    }
+    return true;
+}
+
+void InodeData::ZeroHole(off_t offset, char *out, size_t size) const {
+    if (!truncatePending_) {
+        return;
+    }
+
+    off_t from = std::max(offset, truncateMin_);
+    off_t end = offset + static_cast<off_t>(size);
+    if (from < end) {
+        memset(out + (from - offset), 0, static_cast<size_t>(end - from));
+    }
+}
+
+void InodeData::CopyOut(const ExtentMap& extents, off_t offset, char *out, size_t size) const {
+    off_t end = offset + static_cast<off_t>(size);
+
+    auto it = extents.upper_bound(offset);
+    if (it != extents.begin()) {
+        --it;
+    }
+
+    for (; it != extents.end() && it->first < end; ++it) {
+        off_t from = std::max(offset, it->first);
+        off_t to = std::min(end, ExtentEnd(it));
+        if (from < to) {
+            memcpy(out + (from - offset), it->second.data() + (from - it->first), static_cast<size_t>(to - from));
+        }
+    }
+}
+
+void InodeData::DropBeyond(ExtentMap& extents, size_t& bytes, off_t size) {
+    auto it = extents.lower_bound(size);
+    if (it != extents.begin()) {
+        auto prev = std::prev(it);
+        if (ExtentEnd(prev) > size) {
+            size_t keep = static_cast<size_t>(size - prev->first);
+            bytes -= prev->second.size() - keep;
+            prev->second.resize(keep);
+        }
+    }
+    while (it != extents.end()) {
+        bytes -= it->second.size();
+        it = extents.erase(it);
+    }
+}
+
+void InodeData::DropRange(ExtentMap& extents, size_t& bytes, off_t start, off_t end) {
+    auto it = extents.lower_bound(start);
+    if (it != extents.begin() && ExtentEnd(std::prev(it)) > start) {
+        --it;
+    }
+
+    while (it != extents.end() && it->first < end) {
+        off_t extentStart = it->first;
+        off_t extentEnd = ExtentEnd(it);
+        std::string data = std::move(it->second);
+        bytes -= data.size();
+        it = extents.erase(it);
+
+        // Keep what lies outside the range on either side
+        if (extentStart < start) {
+            size_t keep = static_cast<size_t>(start - extentStart);
+            bytes += keep;
+            extents.emplace(extentStart, data.substr(0, keep));
+        }
+        if (extentEnd > end) {
+            size_t skip = static_cast<size_t>(end - extentStart);
+            bytes += data.size() - skip;
+            it = extents.emplace(end, data.substr(skip)).first;
+            break;
+        }
+    }
+}
+
+std::shared_ptr<InodeData> InodeTable::Acquire(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Entry& entry = entries_[path];
+    if (!entry.inode) {
+        entry.inode = std::make_shared<InodeData>(&dirtyBytes_);
+        entry.openCount = 0;
+    }
+    entry.openCount++;
+    return entry.inode;
+}
+
+void InodeTable::Release(const std::string& path, const std::shared_ptr<InodeData>& inode) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(path);
+    if (it == entries_.end() || it->second.inode != inode) {
+        // Renamed under a name we did not see; fall back to a scan
+        it = std::find_if(entries_.begin(), entries_.end(),
+                          [&inode](const std::pair<const std::string, Entry>& e) { return e.second.inode == inode; });
+    }
+    if (it == entries_.end()) {
+        return;  // Forgotten by unlink; the handle held the last reference
+    }
+
+    if (--it->second.openCount == 0) {
+        entries_.erase(it);
+    }
+}
+
+std::shared_ptr<InodeData> InodeTable::Find(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(path);
+    return it != entries_.end() ? it->second.inode : nullptr;
+}
+
+void InodeTable::Rename(const std::string& from, const std::string& to) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Whatever was open under the target name is no longer reachable by it
+    entries_.erase(to);
+
+    auto it = entries_.find(from);
+    if (it != entries_.end()) {
+        Entry entry = it->second;
+        entries_.erase(it);
+        entries_[to] = entry;
+    }
+}
+
+void InodeTable::Forget(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(path);
+}
+
+size_t InodeTable::Count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+size_t InodeTable::MemoryUsage() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t total = 0;
+    for (const auto& entry : entries_) {
+        total += sizeof(Entry) + entry.first.capacity() + sizeof(InodeData) + entry.second.inode->MemoryUsage();
+    }
+    return total;
+}
+
+size_t InodeTable::DropClean() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t freed = 0;
+    for (const auto& entry : entries_) {
+        freed += entry.second.inode->DropClean();
+    }
+    return freed;
+}
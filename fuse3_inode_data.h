@@ -0,0 +1,166 @@
+#ifndef FUSE3_INODE_DATA_H
+#define FUSE3_INODE_DATA_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Non-overlapping byte extents keyed by file offset
+typedef std::map<off_t, std::string> ExtentMap;
+
+// Native view of one file while it is open. Tracks size and attributes so
+// getattr on a file being written needs no JS round trip. In writeback mode
+// dirty extents (written, not yet committed to JS) also overlay clean extents
+// (read from JS or already committed), so a read on any handle sees writes
+// from every other handle.
+class InodeData {
+public:
+    // mountDirty, if given, is kept at the dirty bytes of every inode sharing it
+    explicit InodeData(std::atomic<size_t> *mountDirty = nullptr);
+    ~InodeData();
+
+    // Buffer written data; extends the size and bumps mtime. Returns the
+    // inode's dirty bytes afterwards.
+    size_t Write(off_t offset, const char *data, size_t size);
+
+    // A write JS already has (write-through) ended at end
+    void NoteWrite(off_t end);
+
+    // JS wrote [offset, offset + size) itself (a server-side copy or a
+    // spliced write): forget native data there so reads go to JS and a
+    // later commit cannot overwrite it, and extend the size
+    void Replaced(off_t offset, size_t size);
+
+    // Remember data JS returned for a read. Only fills holes, so it never
+    // hides newer writes that are still on their way to JS.
+    void Fill(off_t offset, const char *data, size_t size);
+
+    // Serve a read natively. Returns bytes copied, or -1 if the range is not
+    // fully covered by native data.
+    ssize_t Read(off_t offset, char *out, size_t size);
+
+    // Patch a buffer JS just filled with jsBytes bytes so it reflects native
+    // data and the native size. Returns the number of valid bytes.
+    size_t Overlay(off_t offset, char *out, size_t size, size_t jsBytes);
+
+    // Set the file size, dropping native data beyond it. A deferred truncate
+    // is replayed to JS by the next commit instead of being sent now.
+    void Truncate(off_t size, bool deferred);
+
+    // Remember attributes JS reported and patch them with native size/mtime
+    void UpdateAttr(struct stat *stbuf);
+
+    // Answer getattr natively; false until JS attributes are known
+    bool GetAttr(struct stat *stbuf);
+
+    // Attributes changed through JS (chmod, chown, utimens); ask again
+    void InvalidateAttr();
+
+    // Handles open for writing. Every open of a file in writeback mode
+    // shares its inode, so a commit started from a read-only handle goes
+    // through the JS handle of one of these.
+    void AddWriter(uint64_t jsFh);
+    void RemoveWriter(uint64_t jsFh);
+    bool WriterFh(uint64_t *jsFh);
+
+    // Dirty extents or a deferred truncate are waiting for JS
+    bool NeedsCommit();
+
+    // Truncates JS has not seen: shrink to minSize, then set finalSize
+    bool TakePendingTruncate(off_t *minSize, off_t *finalSize);
+    void RestorePendingTruncate(off_t minSize);
+
+    // Take all dirty extents for commit. They stay readable as clean data.
+    ExtentMap TakeDirty();
+
+    // Put back extents whose commit failed, underneath any newer writes
+    void RestoreDirty(ExtentMap extents);
+
+    // Bytes held natively (dirty + clean)
+    size_t MemoryUsage();
+    size_t DirtyBytes();
+
+    // Forget clean data and JS attributes so they are read from JS again.
+    // Dirty data and the size stay. Returns the bytes freed.
+    size_t DropClean();
+
+private:
+    void ExtendLocked(off_t end);
+    void SetDirtyBytesLocked(size_t bytes);
+    bool Covered(off_t start, off_t end) const;
+    // Zero the part of a buffer at or past a pending truncate's smallest
+    // size: until the truncate is committed JS still returns old contents
+    // there, and what is not overwritten by native data reads as zeros
+    void ZeroHole(off_t offset, char *out, size_t size) const;
+    void CopyOut(const ExtentMap& extents, off_t offset, char *out, size_t size) const;
+    void DropBeyond(ExtentMap& extents, size_t& bytes, off_t size);
+    void DropRange(ExtentMap& extents, size_t& bytes, off_t start, off_t end);
+
+    std::mutex mutex_;
+    std::atomic<size_t> *mountDirty_;
+    ExtentMap dirty_;
+    ExtentMap clean_;
+    size_t dirtyBytes_;
+    size_t cleanBytes_;
+    off_t size_;           // Authoritative size once sizeKnown_
+    bool sizeKnown_;
+    off_t writtenEnd_;     // Highest offset written since open
+    time_t mtime_;         // 0 until written or truncated
+    struct stat attr_;     // Last attributes from JS
+    bool attrKnown_;
+    bool truncatePending_;
+    off_t truncateMin_;    // Smallest size truncated to since the last commit;
+                           // [truncateMin_, size_) reads as zeros under dirty data
+    std::vector<uint64_t> writerFhs_;  // JS handles of open writers, oldest first
+};
+
+// Open inodes of one mount keyed by path. An entry lives while at least one
+// handle references it.
+class InodeTable {
+public:
+    // Get or create the entry for an opening handle
+    std::shared_ptr<InodeData> Acquire(const std::string& path);
+
+    // Drop a handle's reference; the entry goes away with the last one
+    void Release(const std::string& path, const std::shared_ptr<InodeData>& inode);
+
+    std::shared_ptr<InodeData> Find(const std::string& path);
+
+    // Keep open inodes attached to their new name
+    void Rename(const std::string& from, const std::string& to);
+
+    // The name no longer refers to this inode (unlink)
+    void Forget(const std::string& path);
+
+    size_t Count();
+    size_t MemoryUsage();
+
+    // Dirty bytes of every inode acquired here, forgotten ones included
+    size_t DirtyBytes() const {
+        return dirtyBytes_.load(std::memory_order_relaxed);
+    }
+
+    // InodeData::DropClean on every open inode; returns the bytes freed
+    size_t DropClean();
+
+private:
+    struct Entry {
+        std::shared_ptr<InodeData> inode;
+        unsigned openCount;
+    };
+
+    std::atomic<size_t> dirtyBytes_{0};  // Before entries_: inodes update it as they go
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+#endif // FUSE3_INODE_DATA_H
@@ -0,0 +1,178 @@
+#include "fuse3_lag.h"
+
+#include <string.h>
+
+#include "fuse3_log.h"
+
+LoopLagMonitor::LoopLagMonitor()
+    : thresholdNs_(0), lastLagNs_(0), pendingSinceNs_(0), degraded_(false), degradedSinceNs_(0),
+      episodes_(0), staleAttrs_(0), episodeStaleAttrs_(0) {
+}
+
+void LoopLagMonitor::Configure(uint64_t thresholdNs) {
+    thresholdNs_ = thresholdNs;
+}
+
+void LoopLagMonitor::SetReporter(Reporter reporter) {
+    reporter_ = reporter;
+}
+
+void LoopLagMonitor::Enqueued(uint64_t now, int64_t queuedBefore) {
+    if (queuedBefore == 0) {
+        pendingSinceNs_.store(now, std::memory_order_relaxed);
+    }
+}
+
+void LoopLagMonitor::Dequeued(uint64_t enqueueNs, uint64_t now) {
+    uint64_t lag = now > enqueueNs ? now - enqueueNs : 0;
+    lag_.Record(lag);
+    lastLagNs_.store(lag, std::memory_order_relaxed);
+    pendingSinceNs_.store(now, std::memory_order_relaxed);
+
+    // Calls get through in well under the threshold again
+    if (thresholdNs_ > 0 && lag < thresholdNs_ / 2) {
+        Recover(now, lag);
+    }
+}
+
+void LoopLagMonitor::Recover(uint64_t now, uint64_t lag) {
+    if (!degraded_.load(std::memory_order_relaxed) || !degraded_.exchange(false)) {
+        return;
+    }
+
+    LagEvent event = {};
+    event.degraded = false;
+    event.lagNs = lag;
+    event.durationNs = now - degradedSinceNs_.load(std::memory_order_relaxed);
+    event.staleAttrs = episodeStaleAttrs_.exchange(0, std::memory_order_relaxed);
+    LOG_INFO(kLogOps, "event loop recovered after %llu ms; %llu getattr served stale",
+             static_cast<unsigned long long>(event.durationNs / 1000000),
+             static_cast<unsigned long long>(event.staleAttrs));
+    if (reporter_) {
+        reporter_(event);
+    }
+}
+
+uint64_t LoopLagMonitor::CurrentLagNs(uint64_t now, int64_t queued) const {
+    uint64_t lag = lastLagNs_.load(std::memory_order_relaxed);
+    uint64_t pendingSince = pendingSinceNs_.load(std::memory_order_relaxed);
+    if (queued > 0 && now > pendingSince && now - pendingSince > lag) {
+        lag = now - pendingSince;
+    }
+    return lag;
+}
+
+bool LoopLagMonitor::ShouldDegrade(uint64_t now, int64_t queued) {
+    if (thresholdNs_ == 0) {
+        return false;
+    }
+
+    // Degrade only while calls are waiting and the JS thread has not taken
+    // one for a threshold. With nothing queued a new call may run at once,
+    // and its wait tells whether the loop recovered.
+    uint64_t pendingSince = pendingSinceNs_.load(std::memory_order_relaxed);
+    uint64_t stalled = queued > 0 && now > pendingSince ? now - pendingSince : 0;
+    if (stalled < thresholdNs_) {
+        if (queued == 0) {
+            Recover(now, lastLagNs_.load(std::memory_order_relaxed));
+        }
+        return false;
+    }
+    if (degraded_.load(std::memory_order_relaxed) || degraded_.exchange(true)) {
+        return true;  // Already degraded, or another FUSE thread just started it
+    }
+    uint64_t lag = stalled;
+
+    degradedSinceNs_.store(now, std::memory_order_relaxed);
+    episodes_.fetch_add(1, std::memory_order_relaxed);
+    LOG_WARN(kLogOps, "event loop lagging %llu ms; serving stale attributes",
+             static_cast<unsigned long long>(lag / 1000000));
+
+    LagEvent event = {};
+    event.degraded = true;
+    event.lagNs = lag;
+    if (reporter_) {
+        reporter_(event);
+    }
+    return true;
+}
+
+void LoopLagMonitor::NoteStaleAttr() {
+    staleAttrs_.fetch_add(1, std::memory_order_relaxed);
+    episodeStaleAttrs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LoopLagMonitor::Snapshot(LagSnapshot *out, int64_t queued) const {
+    lag_.AddTo(&out->lag);
+    out->currentNs = CurrentLagNs(MonotonicNs(), queued);
+    out->degraded = degraded_.load(std::memory_order_relaxed);
+    out->episodes = episodes_.load(std::memory_order_relaxed);
+    out->staleAttrs = staleAttrs_.load(std::memory_order_relaxed);
+}
+
+void LoopLagMonitor::Reset() {
+    lag_.Reset();
+    episodes_.store(0, std::memory_order_relaxed);
+    staleAttrs_.store(0, std::memory_order_relaxed);
+}
+
+void StaleAttrCache::Remember(const char *path, const struct stat& attr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(path);
+    if (it != entries_.end()) {
+        it->second = attr;
+        return;
+    }
+    if (entries_.size() >= kCapacity) {
+        entries_.erase(entries_.begin());  // Any victim will do; this only bounds memory
+    }
+    entries_.emplace(path, attr);
+}
+
+bool StaleAttrCache::Lookup(const char *path, struct stat *attr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(path);
+    if (it == entries_.end()) {
+        return false;
+    }
+    *attr = it->second;
+    return true;
+}
+
+void StaleAttrCache::Forget(const char *path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // A renamed or removed directory takes everything below it along
+    size_t length = strlen(path);
+    for (auto it = entries_.begin(); it != entries_.end(); ) {
+        const std::string& name = it->first;
+        bool below = name.size() > length && name[length] == '/' && name.compare(0, length, path) == 0;
+        if (below || name == path) {
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void StaleAttrCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+size_t StaleAttrCache::Count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+size_t StaleAttrCache::MemoryUsage() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t total = 0;
+    for (const auto& entry : entries_) {
+        total += sizeof(entry) + entry.first.capacity() + sizeof(void *) * 2;
+    }
+    return total + entries_.bucket_count() * sizeof(void *);
+}
@@ -0,0 +1,110 @@
+#ifndef FUSE3_LAG_H
+#define FUSE3_LAG_H
+
+#include <sys/stat.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "fuse3_stats.h"
+
+// Start or end of a period in which requests were degraded because of lag
+struct LagEvent {
+    bool degraded;          // true when degradation starts, false when it ends
+    uint64_t lagNs;         // Lag that started it, or of the call that ended it
+    uint64_t durationNs;    // How long it lasted (end only)
+    uint64_t staleAttrs;    // getattr answered from stale attributes during it (end only)
+};
+
+struct LagSnapshot {
+    HistogramSnapshot lag;
+    uint64_t currentNs;
+    bool degraded;
+    uint64_t episodes;
+    uint64_t staleAttrs;
+};
+
+// Event-loop lag as the FUSE side sees it: how long calls wait in the TSFN
+// queue before the JS thread takes them. Every call is recorded in a
+// histogram. With a threshold configured, the monitor also decides when
+// requests should be degraded rather than queued behind a busy event loop.
+//
+// The current lag is the larger of the last call's wait and, while calls are
+// queued, the time since the JS thread last took one. So a stuck loop is
+// noticed before the stuck call finally runs.
+class LoopLagMonitor {
+public:
+    typedef std::function<void(const LagEvent&)> Reporter;
+
+    LoopLagMonitor();
+
+    // Degrade while lag is at or over thresholdNs; 0 turns degradation off
+    void Configure(uint64_t thresholdNs);
+
+    bool Enabled() const {
+        return thresholdNs_ > 0;
+    }
+
+    // Receives degradation start/end; set before the FUSE loop runs
+    void SetReporter(Reporter reporter);
+
+    // FUSE thread, before queuing a call; queuedBefore is the depth it found
+    void Enqueued(uint64_t now, int64_t queuedBefore);
+
+    // JS thread, as a call starts
+    void Dequeued(uint64_t enqueueNs, uint64_t now);
+
+    // queued is the current TSFN queue depth (RequestGauges::queued)
+    uint64_t CurrentLagNs(uint64_t now, int64_t queued) const;
+
+    // Whether a request that could be answered without JS should be: calls
+    // are queued and none was taken for a threshold. Starts and ends the
+    // degraded period, reporting both.
+    bool ShouldDegrade(uint64_t now, int64_t queued);
+
+    void NoteStaleAttr();
+
+    void Snapshot(LagSnapshot *out, int64_t queued) const;
+    void Reset();
+
+private:
+    void Recover(uint64_t now, uint64_t lag);
+
+    uint64_t thresholdNs_;
+    Reporter reporter_;
+
+    Histogram lag_;
+    std::atomic<uint64_t> lastLagNs_;
+    std::atomic<uint64_t> pendingSinceNs_;  // Last call taken, or first call queued after the queue was empty
+    std::atomic<bool> degraded_;
+    std::atomic<uint64_t> degradedSinceNs_;
+    std::atomic<uint64_t> episodes_;
+    std::atomic<uint64_t> staleAttrs_;
+    std::atomic<uint64_t> episodeStaleAttrs_;
+};
+
+// Last attributes JS reported per path, kept only while lag degradation is
+// configured. Served in place of a JS getattr while the event loop lags.
+class StaleAttrCache {
+public:
+    static const size_t kCapacity = 4096;
+
+    void Remember(const char *path, const struct stat& attr);
+    bool Lookup(const char *path, struct stat *attr);
+
+    // The path changed through this mount; its old attributes must not come back
+    void Forget(const char *path);
+    void Clear();
+
+    size_t Count();
+    size_t MemoryUsage();
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, struct stat> entries_;
+};
+
+#endif // FUSE3_LAG_H
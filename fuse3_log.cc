@@ -0,0 +1,225 @@
+#include "fuse3_log.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Runtime levels start at warn: errors and warnings are visible, the hot-path
+// debug/trace messages cost one relaxed load each
+std::atomic<int> g_logLevels[kLogSubsystemCount] = {
+    {FUSE3_LOG_LEVEL_WARN}, {FUSE3_LOG_LEVEL_WARN}, {FUSE3_LOG_LEVEL_WARN}
+};
+
+static const char *const kLevelNames[] = { "trace", "debug", "info", "warn", "error", "off" };
+static const char *const kSubsystemNames[] = { "core", "ops", "data" };
+
+static const size_t kSlotCount = 1024;  // Power of two
+static const size_t kMessageSize = 224;
+
+// Bounded multi-producer ring (Vyukov). Each slot's sequence says whether it
+// is free for the producer at position pos (sequence == pos) or holds a
+// message for the consumer (sequence == pos + 1). FUSE threads never block:
+// when the ring is full the message is counted as dropped.
+struct LogSlot {
+    std::atomic<size_t> sequence;
+    uint64_t timestampNs;
+    long tid;
+    uint8_t level;
+    uint8_t subsystem;
+    char message[kMessageSize];
+};
+
+static LogSlot g_slots[kSlotCount];
+static std::atomic<size_t> g_enqueuePos(0);
+static size_t g_dequeuePos = 0;            // Only touched under g_drainMutex
+static std::mutex g_drainMutex;
+static std::atomic<unsigned long long> g_dropped(0);
+static unsigned long long g_droppedReported = 0;  // Under g_drainMutex
+static std::once_flag g_startOnce;
+
+static void DrainLocked() {
+    char line[kMessageSize + 96];
+    bool wrote = false;
+
+    for (;;) {
+        LogSlot& slot = g_slots[g_dequeuePos & (kSlotCount - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != g_dequeuePos + 1) {
+            break;
+        }
+
+        time_t seconds = static_cast<time_t>(slot.timestampNs / 1000000000ULL);
+        struct tm tm;
+        localtime_r(&seconds, &tm);
+        int len = snprintf(line, sizeof(line), "[fuse3 %02d:%02d:%02d.%06u %s %s %ld] %s\n",
+                           tm.tm_hour, tm.tm_min, tm.tm_sec,
+                           static_cast<unsigned>((slot.timestampNs / 1000) % 1000000),
+                           kLevelNames[slot.level], kSubsystemNames[slot.subsystem],
+                           slot.tid, slot.message);
+        fwrite(line, 1, std::min(static_cast<size_t>(len), sizeof(line) - 1), stderr);
+        wrote = true;
+
+        slot.sequence.store(g_dequeuePos + kSlotCount, std::memory_order_release);
+        g_dequeuePos++;
+    }
+
+    unsigned long long dropped = g_dropped.load(std::memory_order_relaxed);
+    if (dropped > g_droppedReported) {
+        fprintf(stderr, "[fuse3] %llu log messages dropped (ring buffer full)\n", dropped - g_droppedReported);
+        g_droppedReported = dropped;
+        wrote = true;
+    }
+    if (wrote) {
+        fflush(stderr);
+    }
+}
+
+static void DrainThread() {
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(g_drainMutex);
+            DrainLocked();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+static void StartDrain() {
+    for (size_t i = 0; i < kSlotCount; i++) {
+        g_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    std::thread(DrainThread).detach();
+    atexit(LogFlush);
+}
+
+void LogWrite(int level, LogSubsystem subsystem, const char *format, ...) {
+    std::call_once(g_startOnce, StartDrain);
+
+    size_t pos = g_enqueuePos.load(std::memory_order_relaxed);
+    LogSlot *slot;
+    for (;;) {
+        slot = &g_slots[pos & (kSlotCount - 1)];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (g_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            g_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = g_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    slot->timestampNs = static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+    slot->tid = syscall(SYS_gettid);
+    slot->level = static_cast<uint8_t>(level);
+    slot->subsystem = static_cast<uint8_t>(subsystem);
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(slot->message, kMessageSize, format, args);
+    va_end(args);
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void LogSetLevel(LogSubsystem subsystem, int level) {
+    if (subsystem == kLogSubsystemCount) {
+        for (auto& entry : g_logLevels) {
+            entry.store(level, std::memory_order_relaxed);
+        }
+        return;
+    }
+    g_logLevels[subsystem].store(level, std::memory_order_relaxed);
+}
+
+int LogLevelFromName(const char *name) {
+    for (int i = 0; i <= FUSE3_LOG_LEVEL_OFF; i++) {
+        if (strcasecmp(name, kLevelNames[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+LogSubsystem LogSubsystemFromName(const char *name) {
+    for (int i = 0; i < kLogSubsystemCount; i++) {
+        if (strcasecmp(name, kSubsystemNames[i]) == 0) {
+            return static_cast<LogSubsystem>(i);
+        }
+    }
+    return kLogSubsystemCount;
+}
+
+bool LogConfigure(const char *spec) {
+    std::string rest(spec);
+    bool ok = true;
+
+    size_t start = 0;
+    while (start <= rest.size()) {
+        size_t end = rest.find(',', start);
+        if (end == std::string::npos) {
+            end = rest.size();
+        }
+        std::string item = rest.substr(start, end - start);
+        start = end + 1;
+        if (item.empty()) {
+            continue;
+        }
+
+        LogSubsystem subsystem = kLogSubsystemCount;
+        size_t eq = item.find('=');
+        if (eq != std::string::npos) {
+            subsystem = LogSubsystemFromName(item.substr(0, eq).c_str());
+            if (subsystem == kLogSubsystemCount) {
+                ok = false;
+                continue;
+            }
+            item = item.substr(eq + 1);
+        }
+
+        int level = LogLevelFromName(item.c_str());
+        if (level < 0) {
+            ok = false;
+            continue;
+        }
+        LogSetLevel(subsystem, level);
+    }
+    return ok;
+}
+
+std::string LogDescribeLevels() {
+    std::string spec;
+    for (int i = 0; i < kLogSubsystemCount; i++) {
+        if (i > 0) {
+            spec += ',';
+        }
+        spec += kSubsystemNames[i];
+        spec += '=';
+        spec += kLevelNames[g_logLevels[i].load(std::memory_order_relaxed)];
+    }
+    return spec;
+}
+
+void LogFlush() {
+    std::lock_guard<std::mutex> lock(g_drainMutex);
+    DrainLocked();
+}
+
+unsigned long long LogDroppedCount() {
+    return g_dropped.load(std::memory_order_relaxed);
+}
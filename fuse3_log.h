@@ -0,0 +1,73 @@
+#ifndef FUSE3_LOG_H
+#define FUSE3_LOG_H
+
+#include <atomic>
+#include <string>
+
+// Log levels. Messages below FUSE3_LOG_MIN_LEVEL are compiled out entirely;
+// the rest cost one relaxed load and a branch unless their subsystem is
+// enabled at runtime.
+#define FUSE3_LOG_LEVEL_TRACE 0
+#define FUSE3_LOG_LEVEL_DEBUG 1
+#define FUSE3_LOG_LEVEL_INFO  2
+#define FUSE3_LOG_LEVEL_WARN  3
+#define FUSE3_LOG_LEVEL_ERROR 4
+#define FUSE3_LOG_LEVEL_OFF   5
+
+#ifndef FUSE3_LOG_MIN_LEVEL
+#define FUSE3_LOG_MIN_LEVEL FUSE3_LOG_LEVEL_DEBUG
+#endif
+
+enum LogSubsystem {
+    kLogCore,   // Addon lifecycle, mount/unmount
+    kLogOps,    // FUSE operation dispatch
+    kLogData,   // Native inode data, caches, write commits
+    kLogSubsystemCount
+};
+
+extern std::atomic<int> g_logLevels[kLogSubsystemCount];
+
+static inline bool LogEnabled(int level, LogSubsystem subsystem) {
+    return level >= g_logLevels[subsystem].load(std::memory_order_relaxed);
+}
+
+// Format into the ring buffer; a background thread writes it to stderr
+void LogWrite(int level, LogSubsystem subsystem, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+// Runtime level for one subsystem, or all of them with kLogSubsystemCount
+void LogSetLevel(LogSubsystem subsystem, int level);
+
+// Parse "trace", "debug", ... "off"; -1 if unknown
+int LogLevelFromName(const char *name);
+
+// Parse a subsystem name ("core", "ops", "data"); kLogSubsystemCount if unknown
+LogSubsystem LogSubsystemFromName(const char *name);
+
+// Apply a level spec such as "debug" or "ops=trace,data=debug" (FUSE3_LOG).
+// Returns false if any part was not understood; the rest is still applied.
+bool LogConfigure(const char *spec);
+
+// Current levels in the form LogConfigure accepts ("core=warn,ops=debug,data=warn")
+std::string LogDescribeLevels();
+
+// Write out everything queued so far (used at exit and unmount)
+void LogFlush();
+
+// Messages lost because the ring buffer was full
+unsigned long long LogDroppedCount();
+
+#define FUSE3_LOG(level, subsystem, ...) \
+    do { \
+        if ((level) >= FUSE3_LOG_MIN_LEVEL && LogEnabled((level), (subsystem))) { \
+            LogWrite((level), (subsystem), __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_TRACE(subsystem, ...) FUSE3_LOG(FUSE3_LOG_LEVEL_TRACE, subsystem, __VA_ARGS__)
+#define LOG_DEBUG(subsystem, ...) FUSE3_LOG(FUSE3_LOG_LEVEL_DEBUG, subsystem, __VA_ARGS__)
+#define LOG_INFO(subsystem, ...)  FUSE3_LOG(FUSE3_LOG_LEVEL_INFO, subsystem, __VA_ARGS__)
+#define LOG_WARN(subsystem, ...)  FUSE3_LOG(FUSE3_LOG_LEVEL_WARN, subsystem, __VA_ARGS__)
+#define LOG_ERROR(subsystem, ...) FUSE3_LOG(FUSE3_LOG_LEVEL_ERROR, subsystem, __VA_ARGS__)
+
+#endif // FUSE3_LOG_H
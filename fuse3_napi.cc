@@ -4,8 +4,11 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <malloc.h>
 #include <memory>
 #include <thread>
 #include <mutex>
@@ -13,20 +16,17 @@
 #include <queue>
 #include <unordered_map>
 #include <future>
+#include <algorithm>
 
-// FUSE operation callback context
-struct FuseContext {
-    Napi::ThreadSafeFunction tsfn;
-    Napi::ObjectReference operations;
-    std::string mountPoint;
-    struct fuse *fuse;
-    std::thread *fuseThread;
-    bool mounted;
-};
+#include "fuse3_context.h"
+#include "fuse3_bench.h"
+#include "fuse3_log.h"
+#include "fuse3_probes.h"
 
 // Global map to store contexts by mount point
-std::unordered_map<std::string, std::unique_ptr<FuseContext>> g_contexts;
+std::unordered_map<std::string, std::shared_ptr<FuseContext>> g_contexts;
 std::mutex g_contexts_mutex;
+thread_local struct fuse_context *t_requestContext = nullptr;
 
 // Forward declarations - these are defined in fuse3_operations.cc
 extern int fuse3_getattr(const char *path, struct stat *stbuf, struct fuse_file_info *fi);
@@ -51,43 +51,198 @@ extern int fuse3_fsync(const char *path, int isdatasync, struct fuse_file_info *
 extern int fuse3_flush(const char *path, struct fuse_file_info *fi);
 extern int fuse3_access(const char *path, int mask);
 extern int fuse3_statfs(const char *path, struct statvfs *stbuf);
+extern void *fuse3_init(struct fuse_conn_info *conn, struct fuse_config *cfg);
+extern int fuse3_write_buf(const char *path, struct fuse_bufvec *buf, off_t offset,
+                           struct fuse_file_info *fi);
+extern ssize_t fuse3_copy_file_range(const char *path_in, struct fuse_file_info *fi_in, off_t offset_in,
+                                     const char *path_out, struct fuse_file_info *fi_out, off_t offset_out,
+                                     size_t size, int flags);
 
 // FUSE operations structure - initialize all fields to NULL first
 static struct fuse_operations fuse3_ops = {};
 
+// Every timed operation takes its path first
+template <typename... Rest>
+static const char *RequestPath(const char *path, Rest...) {
+    return path;
+}
+
+// What the recorder keeps beyond op and path, per operation signature.
+// Operations without an overload record neither offset nor size.
+template <typename... Args>
+static void DescribeRequest(RecordedRequest *, Args...) {
+}
+
+// read
+static void DescribeRequest(RecordedRequest *request, const char *, char *, size_t size, off_t offset,
+                            struct fuse_file_info *) {
+    request->offset = static_cast<uint64_t>(offset);
+    request->size = size;
+}
+
+// write
+static void DescribeRequest(RecordedRequest *request, const char *, const char *, size_t size, off_t offset,
+                            struct fuse_file_info *) {
+    request->offset = static_cast<uint64_t>(offset);
+    request->size = size;
+}
+
+// write_buf
+static void DescribeRequest(RecordedRequest *request, const char *, struct fuse_bufvec *buf, off_t offset,
+                            struct fuse_file_info *) {
+    request->offset = static_cast<uint64_t>(offset);
+    request->size = fuse_buf_size(buf);
+}
+
+// open, release, flush
+static void DescribeRequest(RecordedRequest *request, const char *, struct fuse_file_info *fi) {
+    request->flags = fi ? static_cast<uint32_t>(fi->flags) : 0;
+}
+
+// create, chmod
+static void DescribeRequest(RecordedRequest *request, const char *, mode_t mode, struct fuse_file_info *) {
+    request->flags = mode;
+}
+
+// mkdir
+static void DescribeRequest(RecordedRequest *request, const char *, mode_t mode) {
+    request->flags = mode;
+}
+
+// access
+static void DescribeRequest(RecordedRequest *request, const char *, int mask) {
+    request->flags = static_cast<uint32_t>(mask);
+}
+
+// truncate
+static void DescribeRequest(RecordedRequest *request, const char *, off_t size, struct fuse_file_info *) {
+    request->offset = static_cast<uint64_t>(size);
+}
+
+// rename
+static void DescribeRequest(RecordedRequest *request, const char *, const char *to, unsigned int flags) {
+    request->path2 = to;
+    request->flags = flags;
+}
+
+// copy_file_range
+static void DescribeRequest(RecordedRequest *request, const char *, struct fuse_file_info *, off_t offsetIn,
+                            const char *pathOut, struct fuse_file_info *, off_t, size_t size, int) {
+    request->path2 = pathOut;
+    request->offset = static_cast<uint64_t>(offsetIn);
+    request->size = size;
+}
+
+// Time an operation end to end and record it in the mount's stats. The
+// context is the one fuse3_init returned, so this works for every mount.
+template <FuseOp op, auto fn, typename R, typename... Args>
+static R TimedOperation(Args... args) {
+    FuseContext* ctx = static_cast<FuseContext*>(RequestContext()->private_data);
+    FUSE3_ALLOC_SCOPE(ctx ? ctx->allocs.For(op) : nullptr);
+
+    if (ctx) {
+        ctx->gauges.inflight.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    RequestTimes times = {};
+    times.dequeueNs = MonotonicNs();
+    t_currentRequest = &times;
+    FUSE3_PROBE_REQUEST_START(OpName(op), RequestPath(args...), RequestContext()->pid, &times);
+
+    InflightRequest inflight;
+    bool watched = ctx && ctx->watchdog.Enabled();
+    if (watched) {
+        inflight.op = op;
+        inflight.path = RequestPath(args...);
+        inflight.pid = RequestContext()->pid;
+        inflight.startNs = times.dequeueNs;
+        ctx->watchdog.Begin(&inflight);
+    }
+
+    R result = fn(args...);
+
+    if (watched) {
+        ctx->watchdog.End(&inflight, times);
+    }
+    t_currentRequest = nullptr;
+    times.replyNs = MonotonicNs();
+    FUSE3_PROBE_REQUEST_END(OpName(op), RequestPath(args...), static_cast<int64_t>(result),
+                            times.replyNs - times.dequeueNs, &times);
+
+    if (ctx) {
+        ctx->gauges.inflight.fetch_sub(1, std::memory_order_relaxed);
+
+        int error = static_cast<int>(result < 0 ? result : 0);
+        uint64_t bytes = result > 0 ? static_cast<uint64_t>(result) : 0;
+        ctx->stats.Record(op, times, error, bytes);
+        if (ctx->options.hotPaths) {
+            ctx->hotPaths.Record(op, RequestPath(args...), RequestContext()->pid, bytes);
+        }
+
+        if (ctx->trace.Enabled()) {
+            TraceRecord record = {};
+            record.times = times;
+            record.pathHash = HashPath(RequestPath(args...));
+            record.bytes = bytes;
+            record.callerPid = RequestContext()->pid;
+            record.tid = CurrentThreadId();
+            record.error = -error;
+            record.op = op;
+            ctx->trace.Record(record);
+        }
+
+        if (ctx->recorder.Enabled()) {
+            RecordedRequest request = {};
+            request.startNs = times.dequeueNs;
+            request.durationNs = times.replyNs - times.dequeueNs;
+            request.path = RequestPath(args...);
+            request.pid = static_cast<uint32_t>(RequestContext()->pid);
+            request.result = static_cast<int32_t>(result);
+            request.op = op;
+            DescribeRequest(&request, args...);
+            ctx->recorder.Record(request);
+        }
+    }
+    return result;
+}
+
+template <FuseOp op, auto fn, typename R, typename... Args>
+static constexpr auto Timed(R (*)(Args...)) {
+    return &TimedOperation<op, fn, R, Args...>;
+}
+
+#define TIMED(op, fn) Timed<op, fn>(fn)
+
 // Initialize operations in a function to avoid initialization order issues
 static void init_fuse_operations() {
-    fuse3_ops.getattr = fuse3_getattr;
-    fuse3_ops.readdir = fuse3_readdir;
-    fuse3_ops.open = fuse3_open;
-    fuse3_ops.read = fuse3_read;
-    fuse3_ops.write = fuse3_write;
-    fuse3_ops.create = fuse3_create;
-    fuse3_ops.unlink = fuse3_unlink;
-    fuse3_ops.mkdir = fuse3_mkdir;
-    fuse3_ops.rmdir = fuse3_rmdir;
-    fuse3_ops.rename = fuse3_rename;
-    fuse3_ops.chmod = fuse3_chmod;
-    fuse3_ops.chown = fuse3_chown;
-    fuse3_ops.truncate = fuse3_truncate;
-    fuse3_ops.utimens = fuse3_utimens;
-    fuse3_ops.release = fuse3_release;
-    fuse3_ops.fsync = fuse3_fsync;
-    fuse3_ops.flush = fuse3_flush;
-    fuse3_ops.access = fuse3_access;
-    fuse3_ops.statfs = fuse3_statfs;
-}
-
-// Helper to get context from path
-FuseContext* GetContextFromPath(const char* path) {
-    std::lock_guard<std::mutex> lock(g_contexts_mutex);
-    
-    // For now, we'll use a simple approach - return the first context
-    // In a real implementation, you might want to match based on mount point
-    if (!g_contexts.empty()) {
-        return g_contexts.begin()->second.get();
-    }
-    return nullptr;
+    fuse3_ops.init = fuse3_init;
+    fuse3_ops.getattr = TIMED(kOpGetattr, fuse3_getattr);
+    fuse3_ops.readdir = TIMED(kOpReaddir, fuse3_readdir);
+    fuse3_ops.open = TIMED(kOpOpen, fuse3_open);
+    fuse3_ops.read = TIMED(kOpRead, fuse3_read);
+    fuse3_ops.write = TIMED(kOpWrite, fuse3_write);
+    fuse3_ops.write_buf = TIMED(kOpWriteBuf, fuse3_write_buf);
+    fuse3_ops.create = TIMED(kOpCreate, fuse3_create);
+    fuse3_ops.unlink = TIMED(kOpUnlink, fuse3_unlink);
+    fuse3_ops.mkdir = TIMED(kOpMkdir, fuse3_mkdir);
+    fuse3_ops.rmdir = TIMED(kOpRmdir, fuse3_rmdir);
+    fuse3_ops.rename = TIMED(kOpRename, fuse3_rename);
+    fuse3_ops.chmod = TIMED(kOpChmod, fuse3_chmod);
+    fuse3_ops.chown = TIMED(kOpChown, fuse3_chown);
+    fuse3_ops.truncate = TIMED(kOpTruncate, fuse3_truncate);
+    fuse3_ops.utimens = TIMED(kOpUtimens, fuse3_utimens);
+    fuse3_ops.release = TIMED(kOpRelease, fuse3_release);
+    fuse3_ops.fsync = TIMED(kOpFsync, fuse3_fsync);
+    fuse3_ops.flush = TIMED(kOpFlush, fuse3_flush);
+    fuse3_ops.access = TIMED(kOpAccess, fuse3_access);
+    fuse3_ops.statfs = TIMED(kOpStatfs, fuse3_statfs);
+    fuse3_ops.copy_file_range = TIMED(kOpCopyFileRange, fuse3_copy_file_range);
+}
+
+// Context of the mount serving the request on this thread. fuse_new() was
+// given it as user data; benchmark threads carry their own.
+FuseContext* CurrentContext() {
+    return static_cast<FuseContext*>(RequestContext()->private_data);
 }
 
 // JavaScript callback structure
@@ -98,6 +253,66 @@ struct JsCallback {
     Napi::Reference<Napi::Object> dataRef;
 };
 
+// Deliver a watchdog report to options.onEvent('slow', info) on the JS thread.
+// The queued call holds the context, which unmount may drop before it runs.
+static void EmitSlowRequest(FuseContext* ctx, const SlowRequest& slow) {
+    ctx->tsfn.NonBlockingCall([ctx = ctx->shared_from_this(), slow](Napi::Env env, Napi::Function jsCallback) {
+        if (ctx->onEvent.IsEmpty()) {
+            return;
+        }
+
+        Napi::Object info = Napi::Object::New(env);
+        info.Set("op", Napi::String::New(env, OpName(slow.op)));
+        info.Set("path", Napi::String::New(env, slow.path));
+        info.Set("pid", Napi::Number::New(env, slow.pid));
+        info.Set("comm", Napi::String::New(env, slow.comm));
+        info.Set("stage", Napi::String::New(env, StageName(slow.stage)));
+        info.Set("elapsedMs", Napi::Number::New(env, static_cast<double>(slow.elapsedNs) / 1e6));
+        info.Set("completed", Napi::Boolean::New(env, slow.completed));
+
+        ctx->onEvent.Value().Call({Napi::String::New(env, "slow"), info});
+    });
+}
+
+// Deliver lag degradation start/end to options.onEvent('lag', info). Queued
+// behind whatever is holding up the loop, so it arrives once the loop runs,
+// possibly after unmount: the queued call holds the context until then.
+static void EmitLagEvent(FuseContext* ctx, const LagEvent& event) {
+    ctx->tsfn.NonBlockingCall([ctx = ctx->shared_from_this(), event](Napi::Env env, Napi::Function jsCallback) {
+        if (ctx->onEvent.IsEmpty()) {
+            return;
+        }
+
+        Napi::Object info = Napi::Object::New(env);
+        info.Set("state", Napi::String::New(env, event.degraded ? "degraded" : "recovered"));
+        info.Set("lagMs", Napi::Number::New(env, static_cast<double>(event.lagNs) / 1e6));
+        if (!event.degraded) {
+            info.Set("durationMs", Napi::Number::New(env, static_cast<double>(event.durationNs) / 1e6));
+            info.Set("staleAttrs", Napi::Number::New(env, static_cast<double>(event.staleAttrs)));
+        }
+
+        ctx->onEvent.Value().Call({Napi::String::New(env, "lag"), info});
+    });
+}
+
+// allocatorStats(): the C heap of the whole process, as malloc sees it
+static Napi::Value AllocatorStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 heap = mallinfo2();
+#elif defined(__GLIBC__)
+    struct mallinfo heap = mallinfo();  // int fields, wrap past 2 GiB
+#endif
+#if defined(__GLIBC__)
+    result.Set("arenaBytes", Napi::Number::New(env, static_cast<double>(heap.arena)));
+    result.Set("mmapBytes", Napi::Number::New(env, static_cast<double>(heap.hblkhd)));
+    result.Set("inUseBytes", Napi::Number::New(env, static_cast<double>(heap.uordblks) + static_cast<double>(heap.hblkhd)));
+    result.Set("freeBytes", Napi::Number::New(env, static_cast<double>(heap.fordblks)));
+#endif
+    return result;
+}
+
 // Main FUSE class
 class Fuse3 : public Napi::ObjectWrap<Fuse3> {
 public:
@@ -106,27 +321,44 @@ public:
     ~Fuse3();
 
 private:
-    static Napi::FunctionReference constructor;
-    
     Napi::Value Mount(const Napi::CallbackInfo& info);
     Napi::Value Unmount(const Napi::CallbackInfo& info);
     Napi::Value IsMounted(const Napi::CallbackInfo& info);
+    Napi::Value GetStats(const Napi::CallbackInfo& info);
+    Napi::Value ResetStats(const Napi::CallbackInfo& info);
+    Napi::Value GetHotPaths(const Napi::CallbackInfo& info);
+    Napi::Value ResetHotPaths(const Napi::CallbackInfo& info);
+    Napi::Value StartTrace(const Napi::CallbackInfo& info);
+    Napi::Value StopTrace(const Napi::CallbackInfo& info);
+    Napi::Value StartRecording(const Napi::CallbackInfo& info);
+    Napi::Value StopRecording(const Napi::CallbackInfo& info);
+    Napi::Value BenchDispatch(const Napi::CallbackInfo& info);
+    static Napi::Value SetLogLevel(const Napi::CallbackInfo& info);
+
+    FuseContext* Context();
+    void Reclaim();
     
-    std::unique_ptr<FuseContext> context_;
+    std::shared_ptr<FuseContext> context_;
+    std::string mountPoint_;
+    bool benchRunning_ = false;  // benchDispatch() owns context_->tsfn (JS thread only)
 };
 
-Napi::FunctionReference Fuse3::constructor;
-
 Napi::Object Fuse3::Init(Napi::Env env, Napi::Object exports) {
     Napi::Function func = DefineClass(env, "Fuse3", {
         InstanceMethod("mount", &Fuse3::Mount),
         InstanceMethod("unmount", &Fuse3::Unmount),
         InstanceMethod("isMounted", &Fuse3::IsMounted),
+        InstanceMethod("getStats", &Fuse3::GetStats),
+        InstanceMethod("resetStats", &Fuse3::ResetStats),
+        InstanceMethod("getHotPaths", &Fuse3::GetHotPaths),
+        InstanceMethod("resetHotPaths", &Fuse3::ResetHotPaths),
+        InstanceMethod("startTrace", &Fuse3::StartTrace),
+        InstanceMethod("stopTrace", &Fuse3::StopTrace),
+        InstanceMethod("startRecording", &Fuse3::StartRecording),
+        InstanceMethod("stopRecording", &Fuse3::StopRecording),
+        InstanceMethod("benchDispatch", &Fuse3::BenchDispatch),
     });
 
-    constructor = Napi::Persistent(func);
-    constructor.SuppressDestruct();
-
     exports.Set("Fuse3", func);
     
     // Export error constants
@@ -142,25 +374,150 @@ Napi::Object Fuse3::Init(Napi::Env env, Napi::Object exports) {
     exports.Set("EROFS", Napi::Number::New(env, -EROFS));
     exports.Set("EBUSY", Napi::Number::New(env, -EBUSY));
     exports.Set("ENOTEMPTY", Napi::Number::New(env, -ENOTEMPTY));
+    exports.Set("EOPNOTSUPP", Napi::Number::New(env, -EOPNOTSUPP));
+
+    exports.Set("setLogLevel", Napi::Function::New(env, SetLogLevel));
+    exports.Set("allocatorStats", Napi::Function::New(env, AllocatorStats));
+#ifdef FUSE3_ALLOC_STATS
+    exports.Set("allocationStats", Napi::Boolean::New(env, true));
+#else
+    exports.Set("allocationStats", Napi::Boolean::New(env, false));
+#endif
 
     return exports;
 }
 
+// setLogLevel(level: string, subsystem?: string). Levels are process-wide.
+Napi::Value Fuse3::SetLogLevel(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Arguments: (level: string, subsystem?: string)")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    int level = LogLevelFromName(info[0].As<Napi::String>().Utf8Value().c_str());
+    if (level < 0) {
+        Napi::TypeError::New(env, "Unknown log level").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    LogSubsystem subsystem = kLogSubsystemCount;
+    if (info.Length() > 1 && info[1].IsString()) {
+        subsystem = LogSubsystemFromName(info[1].As<Napi::String>().Utf8Value().c_str());
+        if (subsystem == kLogSubsystemCount) {
+            Napi::TypeError::New(env, "Unknown log subsystem").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+    }
+
+    LogSetLevel(subsystem, level);
+    return env.Undefined();
+}
+
 Fuse3::Fuse3(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Fuse3>(info) {
     Napi::Env env = info.Env();
     
     if (info.Length() < 2 || !info[0].IsString() || !info[1].IsObject()) {
-        Napi::TypeError::New(env, "Arguments: (mountPoint: string, operations: object)")
+        Napi::TypeError::New(env, "Arguments: (mountPoint: string, operations: object, options?: object)")
             .ThrowAsJavaScriptException();
         return;
     }
     
-    context_ = std::make_unique<FuseContext>();
+    context_ = std::make_shared<FuseContext>();
     context_->mountPoint = info[0].As<Napi::String>().Utf8Value();
+    mountPoint_ = context_->mountPoint;
     context_->operations = Napi::Persistent(info[1].As<Napi::Object>());
     context_->mounted = false;
     context_->fuse = nullptr;
     context_->fuseThread = nullptr;
+
+    if (info.Length() > 2 && info[2].IsObject()) {
+        Napi::Object options = info[2].As<Napi::Object>();
+        if (options.Has("splice")) {
+            context_->options.splice = options.Get("splice").ToBoolean();
+        }
+        if (options.Has("multithreaded")) {
+            context_->options.multithreaded = options.Get("multithreaded").ToBoolean();
+        }
+        if (options.Has("parallelDirectWrites")) {
+            context_->options.parallelDirectWrites = options.Get("parallelDirectWrites").ToBoolean();
+        }
+        if (options.Has("writeback")) {
+            context_->options.writeback = options.Get("writeback").ToBoolean();
+        }
+        if (options.Has("maxDirtyBytes") && options.Get("maxDirtyBytes").IsNumber()) {
+            double bytes = options.Get("maxDirtyBytes").As<Napi::Number>().DoubleValue();
+            context_->options.maxDirtyBytes = bytes > 0 ? static_cast<size_t>(bytes) : 0;
+        }
+        if (options.Has("maxFileDirtyBytes") && options.Get("maxFileDirtyBytes").IsNumber()) {
+            double bytes = options.Get("maxFileDirtyBytes").As<Napi::Number>().DoubleValue();
+            context_->options.maxFileDirtyBytes = bytes > 0 ? static_cast<size_t>(bytes) : 0;
+        }
+        if (options.Has("openCache")) {
+            std::string policy = options.Get("openCache").ToString().Utf8Value();
+            if (policy == "direct") {
+                context_->options.openCache = kOpenCacheDirect;
+            } else if (policy == "page") {
+                context_->options.openCache = kOpenCachePage;
+            } else if (policy == "keep") {
+                context_->options.openCache = kOpenCacheKeep;
+            } else {
+                Napi::TypeError::New(env, "openCache must be 'direct', 'page' or 'keep'").ThrowAsJavaScriptException();
+                return;
+            }
+        }
+        if (options.Has("controlDir")) {
+            // true for the default name, or a name of its own
+            Napi::Value controlDir = options.Get("controlDir");
+            if (controlDir.IsString()) {
+                context_->options.controlDir = controlDir.As<Napi::String>().Utf8Value();
+            } else if (controlDir.ToBoolean()) {
+                context_->options.controlDir = ".fuse3";
+            }
+            const std::string& name = context_->options.controlDir;
+            if (name.find('/') != std::string::npos || name == "." || name == "..") {
+                Napi::TypeError::New(env, "controlDir must be a single name").ThrowAsJavaScriptException();
+                return;
+            }
+        }
+        if (options.Has("hotPaths")) {
+            context_->options.hotPaths = options.Get("hotPaths").ToBoolean();
+        }
+        if (options.Has("slowThresholds") && options.Get("slowThresholds").IsObject()) {
+            // { default?: ms, [op]: ms }; an op's own entry wins over default
+            Napi::Object thresholds = options.Get("slowThresholds").As<Napi::Object>();
+            uint64_t fallbackNs = 0;
+            if (thresholds.Has("default") && thresholds.Get("default").IsNumber()) {
+                fallbackNs = static_cast<uint64_t>(thresholds.Get("default").As<Napi::Number>().DoubleValue() * 1e6);
+            }
+            for (int op = 0; op < kOpCount; op++) {
+                context_->options.slowThresholdNs[op] = fallbackNs;
+            }
+
+            Napi::Array names = thresholds.GetPropertyNames();
+            for (uint32_t i = 0; i < names.Length(); i++) {
+                std::string name = names.Get(i).As<Napi::String>().Utf8Value();
+                FuseOp op = OpFromName(name.c_str());
+                Napi::Value value = thresholds.Get(name);
+                if (op != kOpCount && value.IsNumber()) {
+                    context_->options.slowThresholdNs[op] =
+                        static_cast<uint64_t>(value.As<Napi::Number>().DoubleValue() * 1e6);
+                }
+            }
+        }
+        if (options.Has("lagThresholdMs") && options.Get("lagThresholdMs").IsNumber()) {
+            double ms = options.Get("lagThresholdMs").As<Napi::Number>().DoubleValue();
+            context_->options.lagThresholdNs = ms > 0 ? static_cast<uint64_t>(ms * 1e6) : 0;
+        }
+        if (options.Has("onEvent") && options.Get("onEvent").IsFunction()) {
+            context_->onEvent = Napi::Persistent(options.Get("onEvent").As<Napi::Function>());
+        }
+    }
+
+    context_->watchdog.Configure(context_->options.slowThresholdNs);
+    context_->loopLag.Configure(context_->options.lagThresholdNs);
 }
 
 Fuse3::~Fuse3() {
@@ -171,10 +528,14 @@ Fuse3::~Fuse3() {
 Napi::Value Fuse3::Mount(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (context_->mounted) {
+    if (!context_ || context_->mounted) {
         Napi::Error::New(env, "Already mounted").ThrowAsJavaScriptException();
         return env.Undefined();
     }
+    if (benchRunning_) {
+        Napi::Error::New(env, "benchDispatch() is running").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
     
     // Create thread-safe function for callbacks
     context_->tsfn = Napi::ThreadSafeFunction::New(
@@ -187,10 +548,16 @@ Napi::Value Fuse3::Mount(const Napi::CallbackInfo& info) {
 
     // Save mount point before moving context
     std::string mountPoint = context_->mountPoint;
+    context_->loopExited = false;
 
     // Store context in global map
     {
         std::lock_guard<std::mutex> lock(g_contexts_mutex);
+        if (g_contexts.count(mountPoint)) {
+            context_->tsfn.Release();
+            Napi::Error::New(env, "Another instance is mounted at " + mountPoint).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
         g_contexts[mountPoint] = std::move(context_);
     }
 
@@ -201,19 +568,23 @@ Napi::Value Fuse3::Mount(const Napi::CallbackInfo& info) {
         ctx = g_contexts[mountPoint].get();
     }
     
+    Ref();  // Until the thread reports whether the mount worked
+
     // Create FUSE thread
-    ctx->fuseThread = new std::thread([ctx]() {
-        // Initialize FUSE operations
-        init_fuse_operations();
-        
+    ctx->fuseThread = new std::thread([this, ctx]() {
         // FUSE arguments - minimal setup for FUSE3
         struct fuse_args args = FUSE_ARGS_INIT(0, nullptr);
         fuse_opt_add_arg(&args, "fuse3_napi"); // Program name
+        fuse_opt_add_arg(&args, "-osubtype=fuse3_napi");  // Shows up as fuse.fuse3_napi in /proc/mounts
         
         // Create FUSE instance
-        ctx->fuse = fuse_new(&args, &fuse3_ops, sizeof(fuse3_ops), nullptr);
+        ctx->fuse = fuse_new(&args, &fuse3_ops, sizeof(fuse3_ops), ctx);
         if (!ctx->fuse) {
-            ctx->tsfn.BlockingCall([](Napi::Env env, Napi::Function callback) {
+            LOG_ERROR(kLogCore, "fuse_new failed for %s", ctx->mountPoint.c_str());
+            ctx->fuse = nullptr;
+            ctx->tsfn.BlockingCall([this](Napi::Env env, Napi::Function callback) {
+                Reclaim();
+                Unref();
                 callback.Call({Napi::String::New(env, "Failed to create FUSE instance")});
             });
             fuse_opt_free_args(&args);
@@ -222,30 +593,53 @@ Napi::Value Fuse3::Mount(const Napi::CallbackInfo& info) {
         
         // Mount
         if (fuse_mount(ctx->fuse, ctx->mountPoint.c_str()) != 0) {
-            ctx->tsfn.BlockingCall([](Napi::Env env, Napi::Function callback) {
-                callback.Call({Napi::String::New(env, "Failed to mount FUSE filesystem")});
-            });
+            LOG_ERROR(kLogCore, "fuse_mount failed for %s", ctx->mountPoint.c_str());
             fuse_destroy(ctx->fuse);
+            ctx->fuse = nullptr;
             fuse_opt_free_args(&args);
+            ctx->tsfn.BlockingCall([this](Napi::Env env, Napi::Function callback) {
+                Reclaim();
+                Unref();
+                callback.Call({Napi::String::New(env, "Failed to mount FUSE filesystem")});
+            });
             return;
         }
         
         ctx->mounted = true;
+        LOG_INFO(kLogCore, "mounted %s", ctx->mountPoint.c_str());
         
         // Notify mount success
-        ctx->tsfn.BlockingCall([](Napi::Env env, Napi::Function callback) {
+        ctx->tsfn.BlockingCall([this](Napi::Env env, Napi::Function callback) {
+            Unref();
             callback.Call({env.Null()});
         });
         
-        // Run FUSE main loop
-        fuse_loop(ctx->fuse);
+        ctx->watchdog.Start([ctx](const SlowRequest& slow) {
+            EmitSlowRequest(ctx, slow);
+        });
+        ctx->loopLag.SetReporter([ctx](const LagEvent& event) {
+            EmitLagEvent(ctx, event);
+        });
+
+        // Run FUSE main loop; concurrent writes need more than one request thread
+        if (ctx->options.multithreaded || ctx->options.parallelDirectWrites) {
+            fuse_loop_mt(ctx->fuse, 0);
+        } else {
+            fuse_loop(ctx->fuse);
+        }
+
+        ctx->watchdog.Stop();
         
         // Cleanup
         fuse_unmount(ctx->fuse);
         fuse_destroy(ctx->fuse);
+        ctx->fuse = nullptr;
         fuse_opt_free_args(&args);
         
         ctx->mounted = false;
+        ctx->loopExited = true;
+        LOG_INFO(kLogCore, "unmounted %s", ctx->mountPoint.c_str());
+        LogFlush();
     });
     
     return env.Undefined();
@@ -254,29 +648,38 @@ Napi::Value Fuse3::Mount(const Napi::CallbackInfo& info) {
 Napi::Value Fuse3::Unmount(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    // Find context in global map - need to iterate since context_ was moved
-    FuseContext* ctx = nullptr;
-    std::string mountPoint;
-    {
-        std::lock_guard<std::mutex> lock(g_contexts_mutex);
-        // Since we only expect one mounted filesystem, get the first one
-        if (!g_contexts.empty()) {
-            auto it = g_contexts.begin();
-            ctx = it->second.get();
-            mountPoint = it->first;
-        }
-    }
-
-    if (!ctx || !ctx->mounted) {
+    // A loop that already exited was unmounted from outside (fusermount -u)
+    // and still needs its context cleaned up
+    FuseContext* ctx = context_ ? nullptr : Context();
+    if (!ctx || (!ctx->mounted && !ctx->loopExited)) {
         Napi::Error::New(env, "Not mounted").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
     // Signal FUSE to exit
-    if (ctx->fuse) {
+    if (ctx->mounted && ctx->fuse) {
         fuse_exit(ctx->fuse);
     }
 
+    Reclaim();
+    return env.Undefined();
+}
+
+// Take this instance's context back from g_contexts once its FUSE thread
+// is done, or about to be: after unmount or a failed mount. The mount point
+// is free again and the instance can mount again.
+void Fuse3::Reclaim() {
+    std::shared_ptr<FuseContext> ctx;
+    {
+        std::lock_guard<std::mutex> lock(g_contexts_mutex);
+        auto it = g_contexts.find(mountPoint_);
+        if (it == g_contexts.end()) {
+            return;
+        }
+        ctx = std::move(it->second);
+        g_contexts.erase(it);
+    }
+
     // Wait for thread to finish
     if (ctx->fuseThread) {
         ctx->fuseThread->join();
@@ -284,31 +687,397 @@ Napi::Value Fuse3::Unmount(const Napi::CallbackInfo& info) {
         ctx->fuseThread = nullptr;
     }
 
-    // Remove from global map
-    {
-        std::lock_guard<std::mutex> lock(g_contexts_mutex);
-        g_contexts.erase(mountPoint);
+    // Queued calls still run; the next mount creates its own function
+    ctx->tsfn.Release();
+    context_ = std::move(ctx);
+}
+
+Napi::Value Fuse3::IsMounted(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    // context_ is only held here while not mounted
+    FuseContext* ctx = context_ ? nullptr : Context();
+    return Napi::Boolean::New(env, ctx && ctx->mounted);
+}
+
+// This instance's context: owned until mount, then held by g_contexts until unmount
+FuseContext* Fuse3::Context() {
+    if (context_) {
+        return context_.get();
+    }
+
+    std::lock_guard<std::mutex> lock(g_contexts_mutex);
+    auto it = g_contexts.find(mountPoint_);
+    return it != g_contexts.end() ? it->second.get() : nullptr;
+}
+
+static Napi::Object HistogramToObject(Napi::Env env, const HistogramSnapshot& histogram) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("count", Napi::Number::New(env, static_cast<double>(histogram.count)));
+    result.Set("meanUs", Napi::Number::New(env, histogram.MeanUs()));
+    result.Set("p50Us", Napi::Number::New(env, histogram.PercentileUs(0.5)));
+    result.Set("p90Us", Napi::Number::New(env, histogram.PercentileUs(0.9)));
+    result.Set("p99Us", Napi::Number::New(env, histogram.PercentileUs(0.99)));
+    result.Set("p999Us", Napi::Number::New(env, histogram.PercentileUs(0.999)));
+    result.Set("maxUs", Napi::Number::New(env, static_cast<double>(histogram.maxNs) / 1000.0));
+    return result;
+}
+
+// getStats(): { ops: { [op]: { count, errors, bytes, jsCalls, meanUs, p50Us, ..., errnos, stages,
+//                              allocations (FUSE3_ALLOC_STATS builds) } },
+//              cache: { attr: { hits, misses }, data: { hits, misses } },
+//              dirty: { bytes, limitBytes, fileLimitBytes, limitCommits },
+//              eventLoopLag: { count, meanUs, p50Us, ..., currentUs, degraded, episodes, staleAttrs },
+//              memory: { [structure]: { entries?, bytes }, totalBytes } }
+// Operations that never ran are left out.
+Napi::Value Fuse3::GetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+    Napi::Object ops = Napi::Object::New(env);
+    result.Set("ops", ops);
+
+    FuseContext* ctx = Context();
+    if (!ctx) {
+        return result;
+    }
+
+    for (int op = 0; op < kOpCount; op++) {
+        OpSnapshot snapshot;
+        ctx->stats.Snapshot(static_cast<FuseOp>(op), &snapshot);
+        if (snapshot.latency.count == 0) {
+            continue;
+        }
+
+        Napi::Object entry = HistogramToObject(env, snapshot.latency);
+        entry.Set("errors", Napi::Number::New(env, static_cast<double>(snapshot.errors)));
+        entry.Set("bytes", Napi::Number::New(env, static_cast<double>(snapshot.bytes)));
+        entry.Set("jsCalls", Napi::Number::New(env, static_cast<double>(snapshot.jsCalls)));
+
+        Napi::Object errnos = Napi::Object::New(env);
+        for (int err = 1; err < kErrnoSlots; err++) {
+            if (snapshot.errnos[err] == 0) {
+                continue;
+            }
+            const char *name = err == kErrnoSlots - 1 ? "other" : ErrnoName(err);
+            std::string key = name ? name : std::to_string(err);
+            errnos.Set(key, Napi::Number::New(env, static_cast<double>(snapshot.errnos[err])));
+        }
+        entry.Set("errnos", errnos);
+
+        Napi::Object stages = Napi::Object::New(env);
+        for (int stage = 0; stage < kStageCount; stage++) {
+            if (snapshot.stages[stage].count > 0) {
+                stages.Set(StageName(static_cast<RequestStage>(stage)), HistogramToObject(env, snapshot.stages[stage]));
+            }
+        }
+        entry.Set("stages", stages);
+
+#ifdef FUSE3_ALLOC_STATS
+        AllocSnapshot allocs;
+        ctx->allocs.Snapshot(static_cast<FuseOp>(op), &allocs);
+        Napi::Object allocations = Napi::Object::New(env);
+        allocations.Set("count", Napi::Number::New(env, static_cast<double>(allocs.allocations)));
+        allocations.Set("bytes", Napi::Number::New(env, static_cast<double>(allocs.bytes)));
+        allocations.Set("jsValues", Napi::Number::New(env, static_cast<double>(allocs.jsValues)));
+        allocations.Set("jsBytes", Napi::Number::New(env, static_cast<double>(allocs.jsBytes)));
+        entry.Set("allocations", allocations);
+#endif
+
+        ops.Set(OpName(static_cast<FuseOp>(op)), entry);
+    }
+
+    CacheSnapshot cacheSnapshot;
+    ctx->stats.Snapshot(&cacheSnapshot);
+    Napi::Object cache = Napi::Object::New(env);
+    for (int kind = 0; kind < kCacheKindCount; kind++) {
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("hits", Napi::Number::New(env, static_cast<double>(cacheSnapshot.hits[kind])));
+        entry.Set("misses", Napi::Number::New(env, static_cast<double>(cacheSnapshot.misses[kind])));
+        cache.Set(CacheKindName(static_cast<CacheKind>(kind)), entry);
+    }
+    result.Set("cache", cache);
+
+    Napi::Object dirty = Napi::Object::New(env);
+    dirty.Set("bytes", Napi::Number::New(env, static_cast<double>(ctx->inodes.DirtyBytes())));
+    dirty.Set("limitBytes", Napi::Number::New(env, static_cast<double>(ctx->options.maxDirtyBytes)));
+    dirty.Set("fileLimitBytes", Napi::Number::New(env, static_cast<double>(ctx->options.maxFileDirtyBytes)));
+    dirty.Set("limitCommits", Napi::Number::New(env, static_cast<double>(
+        ctx->gauges.dirtyLimitCommits.load(std::memory_order_relaxed))));
+    result.Set("dirty", dirty);
+
+    LagSnapshot lagSnapshot;
+    ctx->loopLag.Snapshot(&lagSnapshot, ctx->gauges.queued.load(std::memory_order_relaxed));
+    Napi::Object lag = HistogramToObject(env, lagSnapshot.lag);
+    lag.Set("currentUs", Napi::Number::New(env, static_cast<double>(lagSnapshot.currentNs) / 1000.0));
+    lag.Set("degraded", Napi::Boolean::New(env, lagSnapshot.degraded));
+    lag.Set("episodes", Napi::Number::New(env, static_cast<double>(lagSnapshot.episodes)));
+    lag.Set("staleAttrs", Napi::Number::New(env, static_cast<double>(lagSnapshot.staleAttrs)));
+    result.Set("eventLoopLag", lag);
+
+    // Native structures of this mount; libfuse's own node table is not included
+    size_t total = 0;
+    Napi::Object memory = Napi::Object::New(env);
+    auto addMemory = [&](const char *name, size_t bytes, size_t entries, bool counted) {
+        Napi::Object entry = Napi::Object::New(env);
+        if (counted) {
+            entry.Set("entries", Napi::Number::New(env, static_cast<double>(entries)));
+        }
+        entry.Set("bytes", Napi::Number::New(env, static_cast<double>(bytes)));
+        memory.Set(name, entry);
+        total += bytes;
+    };
+    addMemory("inodes", ctx->inodes.MemoryUsage(), ctx->inodes.Count(), true);
+    addMemory("staleAttrs", ctx->staleAttrs.MemoryUsage(), ctx->staleAttrs.Count(), true);
+    addMemory("hotPaths", ctx->options.hotPaths ? ctx->hotPaths.MemoryUsage() : 0, 0, false);
+    addMemory("trace", ctx->trace.MemoryUsage(), 0, false);
+    addMemory("recorder", ctx->recorder.MemoryUsage(), 0, false);
+    // Per mount: opStats grows with the operations and threads seen, the rest is fixed
+    addMemory("opStats", ctx->stats.MemoryUsage(), 0, false);
+    addMemory("loopLag", sizeof(ctx->loopLag), 0, false);
+    addMemory("allocStats", sizeof(ctx->allocs), 0, false);
+    memory.Set("totalBytes", Napi::Number::New(env, static_cast<double>(total)));
+    result.Set("memory", memory);
+
+    return result;
+}
+
+Napi::Value Fuse3::ResetStats(const Napi::CallbackInfo& info) {
+    FuseContext* ctx = Context();
+    if (ctx) {
+        ctx->stats.Reset();
+        ctx->allocs.Reset();
+        ctx->loopLag.Reset();
+    }
+    return info.Env().Undefined();
+}
+
+// Entries keyed by path, or by pid for the pid lists
+static Napi::Array HotEntriesToArray(Napi::Env env, const std::vector<TopK::Entry>& entries, bool pids = false) {
+    Napi::Array result = Napi::Array::New(env, entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        const TopK::Entry& entry = entries[i];
+        Napi::Object item = Napi::Object::New(env);
+        if (pids) {
+            item.Set("pid", Napi::Number::New(env, atoi(entry.key.c_str())));
+        } else {
+            item.Set("path", Napi::String::New(env, entry.key));
+        }
+        item.Set("count", Napi::Number::New(env, static_cast<double>(entry.count)));
+        item.Set("bytes", Napi::Number::New(env, static_cast<double>(entry.bytes)));
+
+        Napi::Object ops = Napi::Object::New(env);
+        for (int op = 0; op < kOpCount; op++) {
+            if (entry.ops[op] > 0) {
+                ops.Set(OpName(static_cast<FuseOp>(op)), Napi::Number::New(env, static_cast<double>(entry.ops[op])));
+            }
+        }
+        item.Set("ops", ops);
+        result.Set(static_cast<uint32_t>(i), item);
+    }
+    return result;
+}
+
+// getHotPaths(): { paths, dirs, pids }, each { byCount, byBytes }
+Napi::Value Fuse3::GetHotPaths(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+    Napi::Object paths = Napi::Object::New(env);
+    Napi::Object dirs = Napi::Object::New(env);
+    Napi::Object pids = Napi::Object::New(env);
+    result.Set("paths", paths);
+    result.Set("dirs", dirs);
+    result.Set("pids", pids);
+
+    FuseContext* ctx = Context();
+    std::vector<TopK::Entry> none;
+    paths.Set("byCount", HotEntriesToArray(env, ctx ? ctx->hotPaths.PathsByCount() : none));
+    paths.Set("byBytes", HotEntriesToArray(env, ctx ? ctx->hotPaths.PathsByBytes() : none));
+    dirs.Set("byCount", HotEntriesToArray(env, ctx ? ctx->hotPaths.DirsByCount() : none));
+    dirs.Set("byBytes", HotEntriesToArray(env, ctx ? ctx->hotPaths.DirsByBytes() : none));
+    pids.Set("byCount", HotEntriesToArray(env, ctx ? ctx->hotPaths.PidsByCount() : none, true));
+    pids.Set("byBytes", HotEntriesToArray(env, ctx ? ctx->hotPaths.PidsByBytes() : none, true));
+    return result;
+}
+
+Napi::Value Fuse3::ResetHotPaths(const Napi::CallbackInfo& info) {
+    FuseContext* ctx = Context();
+    if (ctx) {
+        ctx->hotPaths.Reset();
+    }
+    return info.Env().Undefined();
+}
+
+// startTrace(capacity?: number): record every request into a ring of capacity entries
+Napi::Value Fuse3::StartTrace(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    FuseContext* ctx = Context();
+    if (!ctx) {
+        Napi::Error::New(env, "Not mounted").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    size_t capacity = TraceBuffer::kDefaultCapacity;
+    if (info.Length() > 0 && info[0].IsNumber()) {
+        int64_t requested = info[0].As<Napi::Number>().Int64Value();
+        if (requested > 0) {
+            capacity = static_cast<size_t>(requested);
+        }
     }
 
+    ctx->trace.Start(capacity);
     return env.Undefined();
 }
 
-Napi::Value Fuse3::IsMounted(const Napi::CallbackInfo& info) {
+// stopTrace(): Chrome trace-event JSON of the recorded requests
+Napi::Value Fuse3::StopTrace(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    
-    std::lock_guard<std::mutex> lock(g_contexts_mutex);
-    auto it = g_contexts.find(context_->mountPoint);
-    if (it != g_contexts.end() && it->second->mounted) {
-        return Napi::Boolean::New(env, true);
+
+    FuseContext* ctx = Context();
+    if (!ctx || !ctx->trace.Enabled()) {
+        Napi::Error::New(env, "Tracing is not active").ThrowAsJavaScriptException();
+        return env.Undefined();
     }
-    
-    return Napi::Boolean::New(env, false);
+
+    return Napi::String::New(env, ctx->trace.Stop());
+}
+
+// startRecording(file: string, hashPaths: boolean)
+Napi::Value Fuse3::StartRecording(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Arguments: (file: string, hashPaths?: boolean)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    FuseContext* ctx = Context();
+    if (!ctx) {
+        Napi::Error::New(env, "Not mounted").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    bool hashPaths = info.Length() > 1 && info[1].ToBoolean();
+    std::string error = ctx->recorder.Start(info[0].As<Napi::String>().Utf8Value(), hashPaths);
+    if (!error.empty()) {
+        Napi::Error::New(env, "startRecording: " + error).ThrowAsJavaScriptException();
+    }
+    return env.Undefined();
+}
+
+// stopRecording(): { records, bytes } written to the file, { dropped } for a full ring
+Napi::Value Fuse3::StopRecording(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    FuseContext* ctx = Context();
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t dropped = 0;
+    if (!ctx || !ctx->recorder.Stop(&records, &bytes, &dropped)) {
+        Napi::Error::New(env, "Recording is not active").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("records", Napi::Number::New(env, static_cast<double>(records)));
+    result.Set("bytes", Napi::Number::New(env, static_cast<double>(bytes)));
+    result.Set("dropped", Napi::Number::New(env, static_cast<double>(dropped)));
+    return result;
+}
+
+// benchDispatch({ threads, durationMs, ops, path, size }, callback(err, result)).
+// Native threads call the operation table directly against this instance's
+// handlers; only on an instance that is not mounted.
+Napi::Value Fuse3::BenchDispatch(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Arguments: (options: object, callback: function)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (!context_ || context_->mounted || benchRunning_) {
+        Napi::Error::New(env, "benchDispatch() needs an idle, unmounted instance").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    DispatchBenchConfig config;
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (options.Has("threads") && options.Get("threads").IsNumber()) {
+        config.threads = std::max(1, options.Get("threads").As<Napi::Number>().Int32Value());
+    }
+    if (options.Has("durationMs") && options.Get("durationMs").IsNumber()) {
+        config.durationNs = static_cast<uint64_t>(options.Get("durationMs").As<Napi::Number>().DoubleValue() * 1e6);
+    }
+    if (options.Has("path") && options.Get("path").IsString()) {
+        config.path = options.Get("path").As<Napi::String>().Utf8Value();
+    }
+    if (options.Has("size") && options.Get("size").IsNumber()) {
+        config.size = static_cast<size_t>(std::max<int64_t>(1, options.Get("size").As<Napi::Number>().Int64Value()));
+    }
+    if (options.Has("ops") && options.Get("ops").IsArray()) {
+        Napi::Array ops = options.Get("ops").As<Napi::Array>();
+        for (uint32_t i = 0; i < ops.Length(); i++) {
+            std::string name = ops.Get(i).ToString().Utf8Value();
+            FuseOp op = OpFromName(name.c_str());
+            if (op == kOpCount || !DispatchBenchSupports(op)) {
+                Napi::TypeError::New(env, "benchDispatch() cannot issue " + name).ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            config.ops.push_back(op);
+        }
+    }
+    if (config.ops.empty()) {
+        config.ops.push_back(kOpGetattr);
+    }
+
+    // The worker threads' calls come through this function's queue, like a mount's
+    FuseContext* ctx = context_.get();
+    ctx->tsfn = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Function>(), "FUSE3Bench", 0, 1);
+    benchRunning_ = true;
+    Ref();  // context_ must outlive the threads
+
+    std::thread([this, ctx, config]() {
+        auto result = std::make_shared<DispatchBenchResult>();
+        RunDispatchBench(ctx, fuse3_ops, config, result.get());
+
+        ctx->tsfn.BlockingCall([this, result](Napi::Env env, Napi::Function callback) {
+            benchRunning_ = false;
+            Unref();
+
+            Napi::Object summary = Napi::Object::New(env);
+            double seconds = static_cast<double>(result->elapsedNs) / 1e9;
+            summary.Set("elapsedMs", Napi::Number::New(env, static_cast<double>(result->elapsedNs) / 1e6));
+            Napi::Object ops = Napi::Object::New(env);
+            for (int op = 0; op < kOpCount; op++) {
+                const HistogramSnapshot& latency = result->latency[op];
+                if (latency.count == 0) {
+                    continue;
+                }
+                Napi::Object entry = HistogramToObject(env, latency);
+                entry.Set("errors", Napi::Number::New(env, static_cast<double>(result->errors[op])));
+                entry.Set("opsPerSec", Napi::Number::New(env, static_cast<double>(latency.count) / seconds));
+                ops.Set(OpName(static_cast<FuseOp>(op)), entry);
+            }
+            summary.Set("ops", ops);
+            callback.Call({env.Null(), summary});
+        });
+        ctx->tsfn.Release();
+    }).detach();
+
+    return env.Undefined();
 }
 
 // Initialize the addon
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
-    // Initialize FUSE operations structure
-    init_fuse_operations();
+    // Initialize FUSE operations structure, once for all environments (worker threads load the addon again)
+    static std::once_flag opsInitialized;
+    std::call_once(opsInitialized, init_fuse_operations);
+
+    const char *logSpec = getenv("FUSE3_LOG");
+    if (logSpec && !LogConfigure(logSpec)) {
+        fprintf(stderr, "[fuse3] ignoring unknown parts of FUSE3_LOG=%s\n", logSpec);
+    }
+
     return Fuse3::Init(env, exports);
 }
 
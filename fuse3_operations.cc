@@ -2,34 +2,174 @@
 #include <fuse3/fuse.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <mutex>
 #include <condition_variable>
 #include <future>
 #include <unordered_map>
 #include <memory>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
 
-// External context
-struct FuseContext {
-    Napi::ThreadSafeFunction tsfn;
-    Napi::ObjectReference operations;
-    std::string mountPoint;
-    struct fuse *fuse;
-    std::thread *fuseThread;
-    bool mounted;
+#include "fuse3_context.h"
+#include "fuse3_log.h"
+#include "fuse3_probes.h"
+
+// Native data of the file behind fi, or of the open file at path
+static std::shared_ptr<InodeData> FindInode(FuseContext* ctx, const char *path, struct fuse_file_info *fi) {
+    FileHandle* handle = GetFileHandle(fi);
+    if (handle && handle->inode) {
+        return handle->inode;
+    }
+    return ctx->inodes.Find(path);
+}
+
+// Attributes kept for lag degradation no longer describe the path
+static void ForgetStaleAttr(FuseContext* ctx, const char *path) {
+    if (ctx && ctx->loopLag.Enabled()) {
+        ctx->staleAttrs.Forget(path);
+    }
+}
+
+// Create JS values for a request. Each is counted against the request's
+// operation in builds with allocation counting, Buffers with their size.
+static Napi::String JsString(Napi::Env env, const char* value) {
+    FUSE3_ALLOC_JS_VALUE(0);
+    return Napi::String::New(env, value);
+}
+
+static Napi::String JsString(Napi::Env env, const std::string& value) {
+    FUSE3_ALLOC_JS_VALUE(0);
+    return Napi::String::New(env, value);
+}
+
+template<typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+static Napi::Number JsNumber(Napi::Env env, T value) {
+    FUSE3_ALLOC_JS_VALUE(0);
+    return Napi::Number::New(env, static_cast<double>(value));
+}
+
+static Napi::Buffer<char> JsBuffer(Napi::Env env, size_t size) {
+    FUSE3_ALLOC_JS_VALUE(size);
+    return Napi::Buffer<char>::New(env, size);
+}
+
+static Napi::Buffer<char> JsBufferCopy(Napi::Env env, const char* data, size_t size) {
+    FUSE3_ALLOC_JS_VALUE(size);
+    return Napi::Buffer<char>::Copy(env, data, size);
+}
+
+// Convert operation arguments for JS: strings stay strings, everything else is a number
+static napi_value ToJsValue(Napi::Env env, const char* value) {
+    return JsString(env, value);
+}
+
+template<typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+static napi_value ToJsValue(Napi::Env env, T value) {
+    return JsNumber(env, value);
+}
+
+// A utimens time in seconds, or null for one the caller leaves unchanged
+struct JsTime {
+    bool omit;
+    time_t seconds;
 };
 
-extern std::unordered_map<std::string, std::unique_ptr<FuseContext>> g_contexts;
-extern std::mutex g_contexts_mutex;
-extern FuseContext* GetContextFromPath(const char* path);
+static napi_value ToJsValue(Napi::Env env, const JsTime& time) {
+    if (time.omit) {
+        return env.Null();
+    }
+    return JsNumber(env, time.seconds);
+}
+
+// Call a JS operation handler with the values built for it
+static Napi::Value CallHandler(const Napi::Value& handler, const Napi::Object& ops,
+                               std::initializer_list<napi_value> args) {
+    return handler.As<Napi::Function>().Call(ops, args);
+}
+
+static Napi::Value CallHandler(const Napi::Value& handler, const Napi::Object& ops,
+                               const std::vector<napi_value>& args) {
+    return handler.As<Napi::Function>().Call(ops, args);
+}
+
+// Callback a JS handler reports its result through. Allocations it makes
+// are charged to the request's operation while the mount's context lives;
+// a handler calling back after unmount is not counted.
+template <typename Callback>
+static Napi::Function ResultCallback(FuseContext* ctx, Napi::Env env, Callback callback) {
+#ifdef FUSE3_ALLOC_STATS
+    AllocCounters *allocs = FUSE3_ALLOC_CURRENT();
+    std::weak_ptr<FuseContext> owner = ctx->shared_from_this();
+    FUSE3_ALLOC_JS_VALUE(0);
+    return Napi::Function::New(env, [owner, allocs, callback](const Napi::CallbackInfo& info) {
+        std::shared_ptr<FuseContext> alive = owner.lock();  // allocs points into it
+        FUSE3_ALLOC_SCOPE(alive ? allocs : nullptr);
+        callback(info);
+    });
+#else
+    return Napi::Function::New(env, callback);
+#endif
+}
+
+// Result of one JS round trip. Setting the value also stamps when the JS
+// result callback ran, for the request's stage times.
+template <typename T>
+class JsResult : public JsCallState {
+public:
+    void set_value(T value) {
+        jsCallbackNs = MonotonicNs();
+        stage.store(kStageWake, std::memory_order_relaxed);
+        FUSE3_PROBE_JS_END(this, jsCallbackNs - jsStartNs);
+        promise_.set_value(value);
+    }
+
+    std::future<T> get_future() {
+        return promise_.get_future();
+    }
+
+private:
+    std::promise<T> promise_;
+};
+
+// Run callback on the JS thread and block until it sets result
+template <typename T, typename Callback>
+static T CallJsAndWait(FuseContext* ctx, const std::shared_ptr<JsResult<T>>& result, Callback callback) {
+    std::future<T> future = result->get_future();
+    uint64_t enqueueNs = MonotonicNs();
+    AllocCounters *allocs = FUSE3_ALLOC_CURRENT();  // ctx outlives the call: this thread waits for it
+    FUSE3_PROBE_QUEUE_ENQUEUE(t_currentRequest, result.get());
+    RequestWatchdog::SetCall(result);
+    ctx->gauges.waiting.fetch_add(1, std::memory_order_relaxed);
+    ctx->loopLag.Enqueued(enqueueNs, ctx->gauges.queued.fetch_add(1, std::memory_order_relaxed));
+
+    ctx->tsfn.BlockingCall([ctx, result, callback, enqueueNs, allocs](Napi::Env env, Napi::Function jsCallback) {
+        FUSE3_ALLOC_SCOPE(allocs);  // The JS thread's part of the request
+        ctx->gauges.queued.fetch_sub(1, std::memory_order_relaxed);
+        result->jsStartNs = MonotonicNs();
+        ctx->loopLag.Dequeued(enqueueNs, result->jsStartNs);
+        result->stage.store(kStageJs, std::memory_order_relaxed);
+        FUSE3_PROBE_QUEUE_DEQUEUE(result.get(), result->jsStartNs - enqueueNs);
+        FUSE3_PROBE_JS_START(result.get());
+        callback(env, jsCallback);
+    });
+
+    T value = future.get();
+    ctx->gauges.waiting.fetch_sub(1, std::memory_order_relaxed);
+    RequestWatchdog::SetCall(nullptr);
+    NoteJsRoundTrip(enqueueNs, result->jsStartNs, result->jsCallbackNs, MonotonicNs());
+    return value;
+}
 
 // Helper to call JavaScript operation
 template<typename... Args>
 static int CallJsOperation(const std::string& opName, const char* path, Args&&... args) {
-    FuseContext* ctx = GetContextFromPath(path);
+    FuseContext* ctx = CurrentContext();
     if (!ctx) return -EIO;
     
-    auto promise = std::make_shared<std::promise<int>>();
-    std::future<int> future = promise->get_future();
+    auto promise = std::make_shared<JsResult<int>>();
     
     auto callback = [opName, path, promise, ctx, &args...](Napi::Env env, Napi::Function jsCallback) {
         try {
@@ -41,15 +181,13 @@ static int CallJsOperation(const std::string& opName, const char* path, Args&&..
                 return;
             }
             
-            // Create arguments array
+            // Create arguments array: path, operation arguments, result callback
             std::vector<napi_value> jsArgs;
-            jsArgs.push_back(Napi::String::New(env, path));
-            
-            // Add additional arguments based on operation
-            // This is a simplified version - real implementation would handle each operation's specific args
+            jsArgs.push_back(JsString(env, path));
+            (jsArgs.push_back(ToJsValue(env, args)), ...);
             
             // Create callback for async result
-            auto resultCallback = Napi::Function::New(env, [promise](const Napi::CallbackInfo& info) {
+            auto resultCallback = ResultCallback(ctx, env, [promise](const Napi::CallbackInfo& info) {
                 if (info.Length() > 0 && info[0].IsNumber()) {
                     promise->set_value(info[0].As<Napi::Number>().Int32Value());
                 } else {
@@ -60,37 +198,80 @@ static int CallJsOperation(const std::string& opName, const char* path, Args&&..
             jsArgs.push_back(resultCallback);
             
             // Call the JavaScript function
-            opFunc.As<Napi::Function>().Call(ops, jsArgs);
+            CallHandler(opFunc, ops, jsArgs);
             
         } catch (...) {
             promise->set_value(-EIO);
         }
     };
     
-    ctx->tsfn.BlockingCall(callback);
-    return future.get();
+    return CallJsAndWait(ctx, promise, callback);
+}
+
+// Path in the control directory of the mount serving the current request
+static bool IsControlRequest(const char *path) {
+    FuseContext* ctx = CurrentContext();
+    return ctx && IsControlPath(ctx->options.controlDir, path);
 }
 
 // FUSE operation implementations
+void *fuse3_init(struct fuse_conn_info *conn, struct fuse_config *cfg) {
+    // fuse_new() was given the mount's context as user data
+    FuseContext* ctx = static_cast<FuseContext*>(fuse_get_context()->private_data);
+
+    if (ctx && ctx->options.splice) {
+        // Receive write payloads through a pipe so write_buf can splice them into staging files
+        if (conn->capable & FUSE_CAP_SPLICE_READ) {
+            conn->want |= FUSE_CAP_SPLICE_READ;
+        }
+        if (conn->capable & FUSE_CAP_SPLICE_MOVE) {
+            conn->want |= FUSE_CAP_SPLICE_MOVE;
+        }
+    }
+
+    if (ctx) {
+        ControlNoteConnection(ctx, conn);
+    }
+    return ctx;
+}
+
 int fuse3_getattr(const char *path, struct stat *stbuf, struct fuse_file_info *fi) {
-    fprintf(stderr, "[C++] fuse3_getattr called for path: %s\n", path);
-    fflush(stderr);
+    LOG_DEBUG(kLogOps, "getattr %s", path);
 
-    FuseContext* ctx = GetContextFromPath(path);
+    FuseContext* ctx = CurrentContext();
     if (!ctx) {
-        fprintf(stderr, "[C++] fuse3_getattr: no context found!\n");
-        fflush(stderr);
+        LOG_ERROR(kLogOps, "getattr %s: no mount context", path);
         return -EIO;
     }
+    if (IsControlPath(ctx->options.controlDir, path)) {
+        return ControlGetattr(ctx, path, stbuf);
+    }
 
     memset(stbuf, 0, sizeof(struct stat));
 
-    auto promise = std::make_shared<std::promise<int>>();
-    std::future<int> future = promise->get_future();
+    // Files open for writing are answered from native size tracking
+    std::shared_ptr<InodeData> inode = FindInode(ctx, path, fi);
+    if (inode && inode->GetAttr(stbuf)) {
+        FUSE3_PROBE_CACHE_HIT("attr", path);
+        ctx->stats.RecordCache(kCacheAttr, true);
+        return 0;
+    }
+    if (inode) {
+        FUSE3_PROBE_CACHE_MISS("attr", path);
+        ctx->stats.RecordCache(kCacheAttr, false);
+    }
+
+    // The event loop is stuck: the last attributes JS gave beat waiting on it
+    if (ctx->loopLag.Enabled() &&
+        ctx->loopLag.ShouldDegrade(MonotonicNs(), ctx->gauges.queued.load(std::memory_order_relaxed)) &&
+        ctx->staleAttrs.Lookup(path, stbuf)) {
+        LOG_DEBUG(kLogOps, "getattr %s: served stale while the event loop lags", path);
+        ctx->loopLag.NoteStaleAttr();
+        return 0;
+    }
+
+    auto promise = std::make_shared<JsResult<int>>();
 
-    fprintf(stderr, "[C++] fuse3_getattr: calling ThreadSafeFunction\n");
-    fflush(stderr);
-    
     auto callback = [path, stbuf, promise, ctx](Napi::Env env, Napi::Function jsCallback) {
         try {
             Napi::Object ops = ctx->operations.Value();
@@ -109,7 +290,7 @@ int fuse3_getattr(const char *path, struct stat *stbuf, struct fuse_file_info *f
             }
             
             // Create callback for result
-            auto resultCb = Napi::Function::New(env, [stbuf, promise](const Napi::CallbackInfo& info) {
+            auto resultCb = ResultCallback(ctx, env, [stbuf, promise](const Napi::CallbackInfo& info) {
                 if (info.Length() < 2) {
                     promise->set_value(-EINVAL);
                     return;
@@ -149,35 +330,40 @@ int fuse3_getattr(const char *path, struct stat *stbuf, struct fuse_file_info *f
                 promise->set_value(0);
             });
             
-            getattr.As<Napi::Function>().Call(ops, {Napi::String::New(env, path), resultCb});
+            CallHandler(getattr, ops, {JsString(env, path), resultCb});
             
         } catch (...) {
             promise->set_value(-EIO);
         }
     };
     
-    ctx->tsfn.BlockingCall(callback);
-    return future.get();
+    int result = CallJsAndWait(ctx, promise, callback);
+
+    // An open file's size and mtime include writes JS has not seen yet
+    if (result == 0 && inode) {
+        inode->UpdateAttr(stbuf);
+    }
+    if (result == 0 && ctx->loopLag.Enabled()) {
+        ctx->staleAttrs.Remember(path, *stbuf);
+    }
+    return result;
 }
 
 int fuse3_readdir(const char *path, void *buf, fuse_fill_dir_t filler,
                   off_t offset, struct fuse_file_info *fi, enum fuse_readdir_flags flags) {
-    fprintf(stderr, "[C++] fuse3_readdir called for path: %s\n", path);
-    fflush(stderr);
+    LOG_DEBUG(kLogOps, "readdir %s", path);
 
-    FuseContext* ctx = GetContextFromPath(path);
+    FuseContext* ctx = CurrentContext();
     if (!ctx) {
-        fprintf(stderr, "[C++] fuse3_readdir: no context!\n");
-        fflush(stderr);
+        LOG_ERROR(kLogOps, "readdir %s: no mount context", path);
         return -EIO;
     }
+    if (IsControlPath(ctx->options.controlDir, path)) {
+        return ControlReaddir(ctx, path, buf, filler);
+    }
 
-    auto promise = std::make_shared<std::promise<int>>();
-    std::future<int> future = promise->get_future();
+    auto promise = std::make_shared<JsResult<int>>();
 
-    fprintf(stderr, "[C++] fuse3_readdir: calling ThreadSafeFunction\n");
-    fflush(stderr);
-    
     auto callback = [path, buf, filler, promise, ctx](Napi::Env env, Napi::Function jsCallback) {
         try {
             Napi::Object ops = ctx->operations.Value();
@@ -188,7 +374,7 @@ int fuse3_readdir(const char *path, void *buf, fuse_fill_dir_t filler,
                 return;
             }
             
-            auto resultCb = Napi::Function::New(env, [buf, filler, promise](const Napi::CallbackInfo& info) {
+            auto resultCb = ResultCallback(ctx, env, [buf, filler, promise](const Napi::CallbackInfo& info) {
                 if (info.Length() < 2) {
                     promise->set_value(-EINVAL);
                     return;
@@ -215,126 +401,140 @@ int fuse3_readdir(const char *path, void *buf, fuse_fill_dir_t filler,
                 promise->set_value(0);
             });
             
-            readdir.As<Napi::Function>().Call(ops, {Napi::String::New(env, path), resultCb});
+            CallHandler(readdir, ops, {JsString(env, path), resultCb});
             
         } catch (...) {
             promise->set_value(-EIO);
         }
     };
     
-    ctx->tsfn.BlockingCall(callback);
-    return future.get();
+    return CallJsAndWait(ctx, promise, callback);
 }
 
 int fuse3_open(const char *path, struct fuse_file_info *fi) {
-    fprintf(stderr, "[C++] fuse3_open called for path: %s\n", path);
-    fflush(stderr);
+    LOG_DEBUG(kLogOps, "open %s", path);
 
-    FuseContext* ctx = GetContextFromPath(path);
+    FuseContext* ctx = CurrentContext();
     if (!ctx) {
-        fprintf(stderr, "[C++] fuse3_open: no context!\n");
-        fflush(stderr);
+        LOG_ERROR(kLogOps, "open %s: no mount context", path);
         return -EIO;
     }
+    if (IsControlPath(ctx->options.controlDir, path)) {
+        return ControlOpen(ctx, path, fi);
+    }
 
-    auto promise = std::make_shared<std::promise<int>>();
-    std::future<int> future = promise->get_future();
+    auto promise = std::make_shared<JsResult<int>>();
 
     int flags = fi->flags;
 
     auto callback = [path, flags, fi, promise, ctx](Napi::Env env, Napi::Function jsCallback) {
         try {
-            fprintf(stderr, "[C++] fuse3_open callback: getting operations object\n");
-            fflush(stderr);
-
             Napi::Object ops = ctx->operations.Value();
-            fprintf(stderr, "[C++] fuse3_open callback: got operations, getting open function\n");
-            fflush(stderr);
-
             Napi::Value open = ops.Get("open");
 
             if (!open.IsFunction()) {
-                fprintf(stderr, "[C++] fuse3_open callback: open is not a function!\n");
-                fflush(stderr);
                 promise->set_value(-ENOSYS);
                 return;
             }
 
-            fprintf(stderr, "[C++] fuse3_open callback: creating result callback\n");
-            fflush(stderr);
+            auto resultCb = ResultCallback(ctx, env, [promise, flags, fi, ctx](const Napi::CallbackInfo& info) {
+                int result = 0;
+                if (info.Length() > 0 && info[0].IsNumber()) {
+                    result = info[0].As<Napi::Number>().Int32Value();
+                }
 
-            auto resultCb = Napi::Function::New(env, [promise, fi](const Napi::CallbackInfo& info) {
-                fprintf(stderr, "[C++] fuse3_open resultCb called with %d args\n", (int)info.Length());
-                fflush(stderr);
+                // Bypass the page cache so read is always called, unless openCache lets
+                // the kernel cache files opened read-only
+                bool reader = (flags & O_ACCMODE) == O_RDONLY;
+                OpenCachePolicy cache = ctx->options.openCache;
+                fi->direct_io = !reader || cache == kOpenCacheDirect;
+                fi->keep_cache = reader && cache == kOpenCacheKeep;
 
-                if (info.Length() > 0 && info[0].IsNumber()) {
-                    int result = info[0].As<Napi::Number>().Int32Value();
-                    // Force direct_io to bypass caching and ensure read is called
-                    fi->direct_io = 1;
-                    fprintf(stderr, "[C++] fuse3_open: set direct_io=1, result=%d\n", result);
-                    fflush(stderr);
-                    promise->set_value(result);
-                } else {
-                    fi->direct_io = 1;
-                    fprintf(stderr, "[C++] fuse3_open: set direct_io=1 (default path)\n");
-                    fflush(stderr);
-                    promise->set_value(0);
+                if (result == 0) {
+                    // Remember the JS handle and an optional staging file for spliced writes
+                    uint64_t jsFh = 0;
+                    int stagingFd = -1;
+                    if (info.Length() > 1 && info[1].IsNumber()) {
+                        jsFh = static_cast<uint64_t>(info[1].As<Napi::Number>().Int64Value());
+                    }
+                    if (info.Length() > 2 && info[2].IsNumber()) {
+                        stagingFd = info[2].As<Napi::Number>().Int32Value();
+                    }
+                    fi->fh = reinterpret_cast<uint64_t>(new FileHandle(jsFh, stagingFd));
+
+#if FUSE_VERSION >= FUSE_MAKE_VERSION(3, 12)
+                    if (ctx->options.parallelDirectWrites) {
+                        fi->parallel_direct_writes = 1;
+                    }
+#endif
                 }
+                promise->set_value(result);
             });
 
-            fprintf(stderr, "[C++] fuse3_open callback: calling JS open function\n");
-            fflush(stderr);
-
-            open.As<Napi::Function>().Call(ops, {
-                Napi::String::New(env, path),
-                Napi::Number::New(env, flags),
+            CallHandler(open, ops, {
+                JsString(env, path),
+                JsNumber(env, flags),
                 resultCb
             });
-
-            fprintf(stderr, "[C++] fuse3_open callback: JS open function called\n");
-            fflush(stderr);
-
         } catch (const Napi::Error& e) {
             std::string msg = e.Message();
-            fprintf(stderr, "[C++] fuse3_open callback: Napi::Error: %s\n", msg.c_str());
-            fflush(stderr);
+            LOG_ERROR(kLogOps, "open %s: JS threw: %s", path, msg.c_str());
             promise->set_value(-EIO);
         } catch (const std::exception& e) {
-            fprintf(stderr, "[C++] fuse3_open callback: std::exception: %s\n", e.what());
-            fflush(stderr);
+            LOG_ERROR(kLogOps, "open %s: %s", path, e.what());
             promise->set_value(-EIO);
         } catch (...) {
-            fprintf(stderr, "[C++] fuse3_open callback: unknown exception\n");
-            fflush(stderr);
+            LOG_ERROR(kLogOps, "open %s: unknown exception", path);
             promise->set_value(-EIO);
         }
     };
 
-    ctx->tsfn.BlockingCall(callback);
-    int result = future.get();
-    fprintf(stderr, "[C++] fuse3_open: returning %d\n", result);
-    fflush(stderr);
+    int result = CallJsAndWait(ctx, promise, callback);
+
+    // Writers get native size tracking; in writeback mode every open file shares native data
+    FileHandle* handle = GetFileHandle(fi);
+    bool writer = (flags & O_ACCMODE) != O_RDONLY;
+    if (result == 0 && handle && (writer || ctx->options.writeback)) {
+        handle->writable = writer;
+        handle->inode = ctx->inodes.Acquire(path);
+        if (writer) {
+            handle->inode->AddWriter(handle->jsFh);
+        }
+    }
+
+    LOG_TRACE(kLogOps, "open %s -> %d", path, result);
     return result;
 }
 
 int fuse3_read(const char *path, char *buf, size_t size, off_t offset,
                struct fuse_file_info *fi) {
-    fprintf(stderr, "[C++] fuse3_read called for path: %s, size: %zu, offset: %ld\n", path, size, offset);
-    fflush(stderr);
+    LOG_DEBUG(kLogOps, "read %s size=%zu offset=%lld", path, size, static_cast<long long>(offset));
 
-    FuseContext* ctx = GetContextFromPath(path);
+    FuseContext* ctx = CurrentContext();
     if (!ctx) {
-        fprintf(stderr, "[C++] fuse3_read: no context!\n");
-        fflush(stderr);
+        LOG_ERROR(kLogOps, "read %s: no mount context", path);
         return -EIO;
     }
+    if (IsControlPath(ctx->options.controlDir, path)) {
+        return ControlRead(fi, buf, size, offset);
+    }
 
-    auto promise = std::make_shared<std::promise<int>>();
-    std::future<int> future = promise->get_future();
+    // Ranges fully covered by native data never reach JS
+    FileHandle* handle = GetFileHandle(fi);
+    std::shared_ptr<InodeData> inode = (handle && ctx->options.writeback) ? handle->inode : nullptr;
+    if (inode) {
+        ssize_t cached = inode->Read(offset, buf, size);
+        if (cached >= 0) {
+            FUSE3_PROBE_CACHE_HIT("data", path);
+            ctx->stats.RecordCache(kCacheData, true);
+            return static_cast<int>(cached);
+        }
+        FUSE3_PROBE_CACHE_MISS("data", path);
+        ctx->stats.RecordCache(kCacheData, false);
+    }
+
+    auto promise = std::make_shared<JsResult<int>>();
 
-    fprintf(stderr, "[C++] fuse3_read: calling ThreadSafeFunction\n");
-    fflush(stderr);
-    
     auto callback = [path, buf, size, offset, fi, promise, ctx](Napi::Env env, Napi::Function jsCallback) {
         try {
             Napi::Object ops = ctx->operations.Value();
@@ -345,7 +545,7 @@ int fuse3_read(const char *path, char *buf, size_t size, off_t offset,
                 return;
             }
             
-            auto resultCb = Napi::Function::New(env, [buf, size, promise](const Napi::CallbackInfo& info) {
+            auto resultCb = ResultCallback(ctx, env, [buf, size, promise](const Napi::CallbackInfo& info) {
                 if (info.Length() < 1) {
                     promise->set_value(-EINVAL);
                     return;
@@ -370,14 +570,14 @@ int fuse3_read(const char *path, char *buf, size_t size, off_t offset,
                 }
             });
             
-            Napi::Buffer<char> buffer = Napi::Buffer<char>::New(env, size);
+            Napi::Buffer<char> buffer = JsBuffer(env, size);
             
-            read.As<Napi::Function>().Call(ops, {
-                Napi::String::New(env, path),
-                Napi::Number::New(env, fi->fh),
+            CallHandler(read, ops, {
+                JsString(env, path),
+                JsNumber(env, GetJsFh(fi)),
                 buffer,
-                Napi::Number::New(env, size),
-                Napi::Number::New(env, offset),
+                JsNumber(env, size),
+                JsNumber(env, offset),
                 resultCb
             });
             
@@ -386,19 +586,22 @@ int fuse3_read(const char *path, char *buf, size_t size, off_t offset,
         }
     };
     
-    ctx->tsfn.BlockingCall(callback);
-    return future.get();
+    int result = CallJsAndWait(ctx, promise, callback);
+
+    if (result >= 0 && inode) {
+        // Keep what JS returned and lay unsaved writes from any handle over it
+        inode->Fill(offset, buf, static_cast<size_t>(result));
+        result = static_cast<int>(inode->Overlay(offset, buf, size, static_cast<size_t>(result)));
+    }
+    return result;
 }
 
-int fuse3_write(const char *path, const char *buf, size_t size, off_t offset,
-                struct fuse_file_info *fi) {
-    FuseContext* ctx = GetContextFromPath(path);
-    if (!ctx) return -EIO;
-    
-    auto promise = std::make_shared<std::promise<int>>();
-    std::future<int> future = promise->get_future();
+// Hand data to the JS write handler; returns bytes written or negative errno
+static int WriteToJs(FuseContext* ctx, const char *path, uint64_t fh, const char *buf, size_t size,
+                     off_t offset) {
+    auto promise = std::make_shared<JsResult<int>>();
     
-    auto callback = [path, buf, size, offset, fi, promise, ctx](Napi::Env env, Napi::Function jsCallback) {
+    auto callback = [path, fh, buf, size, offset, promise, ctx](Napi::Env env, Napi::Function jsCallback) {
         try {
             Napi::Object ops = ctx->operations.Value();
             Napi::Value write = ops.Get("write");
@@ -408,7 +611,7 @@ int fuse3_write(const char *path, const char *buf, size_t size, off_t offset,
                 return;
             }
             
-            auto resultCb = Napi::Function::New(env, [promise](const Napi::CallbackInfo& info) {
+            auto resultCb = ResultCallback(ctx, env, [promise](const Napi::CallbackInfo& info) {
                 if (info.Length() < 1) {
                     promise->set_value(-EINVAL);
                     return;
@@ -418,14 +621,14 @@ int fuse3_write(const char *path, const char *buf, size_t size, off_t offset,
                 promise->set_value(result);
             });
             
-            Napi::Buffer<char> buffer = Napi::Buffer<char>::Copy(env, buf, size);
+            Napi::Buffer<char> buffer = JsBufferCopy(env, buf, size);
             
-            write.As<Napi::Function>().Call(ops, {
-                Napi::String::New(env, path),
-                Napi::Number::New(env, fi->fh),
+            CallHandler(write, ops, {
+                JsString(env, path),
+                JsNumber(env, fh),
                 buffer,
-                Napi::Number::New(env, size),
-                Napi::Number::New(env, offset),
+                JsNumber(env, size),
+                JsNumber(env, offset),
                 resultCb
             });
             
@@ -434,55 +637,454 @@ int fuse3_write(const char *path, const char *buf, size_t size, off_t offset,
         }
     };
     
-    ctx->tsfn.BlockingCall(callback);
-    return future.get();
+    return CallJsAndWait(ctx, promise, callback);
+}
+
+static int CommitDirty(FuseContext* ctx, const char *path, FileHandle* handle);
+
+// A dirty limit of 0 means none
+static bool OverDirtyLimit(size_t dirtyBytes, size_t limit) {
+    return limit > 0 && dirtyBytes > limit;
+}
+
+int fuse3_write(const char *path, const char *buf, size_t size, off_t offset,
+                struct fuse_file_info *fi) {
+    FuseContext* ctx = CurrentContext();
+    if (!ctx) return -EIO;
+    if (IsControlPath(ctx->options.controlDir, path)) {
+        return ControlWrite(ctx, path, buf, size);
+    }
+
+    // Writeback: keep the data native until the file is flushed, or until
+    // the file or the mount holds more dirty data than its limit allows
+    FileHandle* handle = GetFileHandle(fi);
+    if (handle && handle->inode && ctx->options.writeback) {
+        size_t fileDirty = handle->inode->Write(offset, buf, size);
+        ForgetStaleAttr(ctx, path);
+        if (OverDirtyLimit(fileDirty, ctx->options.maxFileDirtyBytes) ||
+            OverDirtyLimit(ctx->inodes.DirtyBytes(), ctx->options.maxDirtyBytes)) {
+            ctx->gauges.dirtyLimitCommits.fetch_add(1, std::memory_order_relaxed);
+            int result = CommitDirty(ctx, path, handle);
+            if (result != 0) {
+                return result;  // Still buffered; close() retries the commit
+            }
+        }
+        return static_cast<int>(size);
+    }
+
+    int written = WriteToJs(ctx, path, GetJsFh(fi), buf, size, offset);
+    if (written > 0 && handle && handle->inode) {
+        handle->inode->NoteWrite(offset + written);
+    }
+    if (written > 0) {
+        ForgetStaleAttr(ctx, path);
+    }
+    return written;
+}
+
+// Largest piece of buffered data passed to a single JS write call
+static const size_t kCommitChunk = 1024 * 1024;
+
+// Push an inode's buffered writes to JS. Data that could not be written is
+// kept dirty so a later flush can retry it. Only a handle open for writing
+// can write to JS: a read-only handle commits through a writer of the same
+// inode, or leaves the data to that writer's close.
+static int CommitDirty(FuseContext* ctx, const char *path, FileHandle* handle) {
+    if (!handle || !handle->inode || !handle->inode->NeedsCommit()) {
+        return 0;
+    }
+    uint64_t fh = handle->jsFh;
+    if (!handle->writable && !handle->inode->WriterFh(&fh)) {
+        return 0;
+    }
+
+    // Replay deferred truncates first so the writes land on the right size
+    off_t minSize = 0;
+    off_t finalSize = 0;
+    if (handle->inode->TakePendingTruncate(&minSize, &finalSize)) {
+        int result = CallJsOperation("truncate", path, minSize);
+        if (result == 0 && finalSize != minSize) {
+            result = CallJsOperation("truncate", path, finalSize);
+        }
+        if (result != 0) {
+            LOG_WARN(kLogData, "commit %s: truncate failed (%d), will retry", path, result);
+            handle->inode->RestorePendingTruncate(minSize);
+            return result;
+        }
+        ForgetStaleAttr(ctx, path);
+    }
+
+    ExtentMap extents = handle->inode->TakeDirty();
+    LOG_DEBUG(kLogData, "commit %s: %zu extents", path, extents.size());
+    for (auto it = extents.begin(); it != extents.end(); ++it) {
+        const std::string& data = it->second;
+        for (size_t done = 0; done < data.size(); ) {
+            size_t chunk = std::min(kCommitChunk, data.size() - done);
+            int written = WriteToJs(ctx, path, fh, data.data() + done, chunk,
+                                    it->first + static_cast<off_t>(done));
+            if (written < 0 || static_cast<size_t>(written) != chunk) {
+                ExtentMap remaining(std::next(it), extents.end());
+                remaining.emplace(it->first + static_cast<off_t>(done), data.substr(done));
+                handle->inode->RestoreDirty(std::move(remaining));
+                LOG_WARN(kLogData, "commit %s: write at %lld failed (%d), will retry", path,
+                         static_cast<long long>(it->first) + static_cast<long long>(done), written);
+                return written < 0 ? written : -EIO;
+            }
+            done += chunk;
+        }
+    }
+    if (!extents.empty()) {
+        ForgetStaleAttr(ctx, path);
+    }
+    return 0;
+}
+
+// Tell JS which range of a staging file now holds spliced write data.
+// Fire-and-forget: the TSFN queue is FIFO, so these arrive before flush/release.
+// Nothing waits for the call, so it keeps the context alive past unmount.
+static void NotifyStagedWrite(FuseContext* ctx, const char *path, uint64_t fh, off_t offset, size_t size) {
+    std::string pathCopy(path);
+    AllocCounters *allocs = FUSE3_ALLOC_CURRENT();
+
+    ctx->tsfn.NonBlockingCall([ctx = ctx->shared_from_this(), pathCopy, fh, offset, size, allocs](
+            Napi::Env env, Napi::Function jsCallback) {
+        FUSE3_ALLOC_SCOPE(allocs);
+        try {
+            Napi::Object ops = ctx->operations.Value();
+            Napi::Value writeStaged = ops.Get("writeStaged");
+
+            if (!writeStaged.IsFunction()) {
+                return;
+            }
+
+            CallHandler(writeStaged, ops, {
+                JsString(env, pathCopy),
+                JsNumber(env, fh),
+                JsNumber(env, offset),
+                JsNumber(env, size)
+            });
+
+        } catch (...) {
+            // Nothing to report back to; the write itself already succeeded
+        }
+    });
+}
+
+int fuse3_write_buf(const char *path, struct fuse_bufvec *buf, off_t offset,
+                    struct fuse_file_info *fi) {
+    FuseContext* ctx = CurrentContext();
+    FileHandle* handle = GetFileHandle(fi);
+    size_t size = fuse_buf_size(buf);
+
+    // Parallel direct writes reach us concurrently; only overlapping ones wait
+    bool ordered = handle && ctx && ctx->options.parallelDirectWrites;
+    RangeGuard guard(ordered ? &handle->writeLock : nullptr, offset, size);
+
+    if (handle && handle->stagingFd >= 0) {
+        // Move the data from /dev/fuse (or the request pipe) into the staging file
+        struct fuse_bufvec dst = FUSE_BUFVEC_INIT(size);
+        dst.buf[0].flags = static_cast<enum fuse_buf_flags>(FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+        dst.buf[0].fd = handle->stagingFd;
+        dst.buf[0].pos = offset;
+
+        ssize_t copied = fuse_buf_copy(&dst, buf, FUSE_BUF_SPLICE_MOVE);
+        if (copied < 0) {
+            return static_cast<int>(copied);
+        }
+
+        if (ctx && copied > 0) {
+            NotifyStagedWrite(ctx, path, handle->jsFh, offset, static_cast<size_t>(copied));
+        }
+        // The staging file now holds the newest data for the range: native
+        // extents there, shared with the inode's other handles, are stale
+        if (handle->inode && copied > 0) {
+            handle->inode->Replaced(offset, static_cast<size_t>(copied));
+        }
+        if (copied > 0) {
+            ForgetStaleAttr(ctx, path);
+        }
+        return static_cast<int>(copied);
+    }
+
+    // No staging file: hand the data to JS as a Buffer like a plain write
+    if (buf->count == 1 && buf->idx == 0 && buf->off == 0 && !(buf->buf[0].flags & FUSE_BUF_IS_FD)) {
+        return fuse3_write(path, static_cast<const char*>(buf->buf[0].mem), size, offset, fi);
+    }
+
+    std::vector<char> data(size);
+    struct fuse_bufvec dst = FUSE_BUFVEC_INIT(size);
+    dst.buf[0].mem = data.data();
+
+    ssize_t copied = fuse_buf_copy(&dst, buf, FUSE_BUF_NO_SPLICE);
+    if (copied < 0) {
+        return static_cast<int>(copied);
+    }
+    return fuse3_write(path, data.data(), static_cast<size_t>(copied), offset, fi);
+}
+
+ssize_t fuse3_copy_file_range(const char *path_in, struct fuse_file_info *fi_in, off_t offset_in,
+                              const char *path_out, struct fuse_file_info *fi_out, off_t offset_out,
+                              size_t size, int flags) {
+    FuseContext* ctx = CurrentContext();
+    if (!ctx) return -EIO;
+    if (IsControlPath(ctx->options.controlDir, path_in) || IsControlPath(ctx->options.controlDir, path_out)) {
+        return -EXDEV;  // The kernel falls back to read+write
+    }
+
+    // JS copies what it has: buffered writes to either file must reach it first
+    int committed = CommitDirty(ctx, path_in, GetFileHandle(fi_in));
+    if (committed == 0) {
+        committed = CommitDirty(ctx, path_out, GetFileHandle(fi_out));
+    }
+    if (committed != 0) {
+        return committed;
+    }
+
+    auto promise = std::make_shared<JsResult<ssize_t>>();
+
+    uint64_t fh_in = GetJsFh(fi_in);
+    uint64_t fh_out = GetJsFh(fi_out);
+
+    auto callback = [path_in, fh_in, offset_in, path_out, fh_out, offset_out, size, flags, promise, ctx](
+                        Napi::Env env, Napi::Function jsCallback) {
+        try {
+            Napi::Object ops = ctx->operations.Value();
+            Napi::Value copyRange = ops.Get("copyRange");
+
+            if (!copyRange.IsFunction()) {
+                // ENOSYS makes the kernel stop asking and fall back to read+write
+                promise->set_value(-ENOSYS);
+                return;
+            }
+
+            auto resultCb = ResultCallback(ctx, env, [promise](const Napi::CallbackInfo& info) {
+                if (info.Length() < 1 || !info[0].IsNumber()) {
+                    promise->set_value(-EINVAL);
+                    return;
+                }
+
+                // Negative errno on failure, otherwise number of bytes copied
+                promise->set_value(static_cast<ssize_t>(info[0].As<Napi::Number>().Int64Value()));
+            });
+
+            CallHandler(copyRange, ops, {
+                JsString(env, path_in),
+                JsNumber(env, fh_in),
+                JsNumber(env, offset_in),
+                JsString(env, path_out),
+                JsNumber(env, fh_out),
+                JsNumber(env, offset_out),
+                JsNumber(env, size),
+                JsNumber(env, flags),
+                resultCb
+            });
+
+        } catch (...) {
+            promise->set_value(-EIO);
+        }
+    };
+
+    ssize_t copied = CallJsAndWait(ctx, promise, callback);
+
+    // The destination changed behind its native data and size
+    std::shared_ptr<InodeData> inode = copied > 0 ? FindInode(ctx, path_out, fi_out) : nullptr;
+    if (inode) {
+        inode->Replaced(offset_out, static_cast<size_t>(copied));
+    }
+    if (copied > 0) {
+        ForgetStaleAttr(ctx, path_out);
+    }
+    return copied;
 }
 
 // Simplified implementations for other operations
 int fuse3_create(const char *path, mode_t mode, struct fuse_file_info *fi) {
-    return CallJsOperation("create", path, mode);
+    if (IsControlRequest(path)) {
+        return -EPERM;
+    }
+
+    int result = CallJsOperation("create", path, mode);
+    if (result != 0) {
+        return result;
+    }
+
+    FuseContext* ctx = CurrentContext();
+    ForgetStaleAttr(ctx, path);
+    FileHandle* handle = new FileHandle(0, -1);
+    if (ctx) {
+        // A created file is open for writing: track its size natively
+        handle->writable = true;
+        handle->inode = ctx->inodes.Acquire(path);
+        handle->inode->AddWriter(handle->jsFh);
+        if (ctx->options.writeback || ctx->options.parallelDirectWrites) {
+            // Route the new file's data through the native layer like an opened one
+            fi->direct_io = 1;
+        }
+#if FUSE_VERSION >= FUSE_MAKE_VERSION(3, 12)
+        // O_CREAT opens (downloaders, databases) get concurrent writes too
+        if (ctx->options.parallelDirectWrites) {
+            fi->parallel_direct_writes = 1;
+        }
+#endif
+    }
+    fi->fh = reinterpret_cast<uint64_t>(handle);
+    return 0;
 }
 
 int fuse3_unlink(const char *path) {
-    return CallJsOperation("unlink", path);
+    if (IsControlRequest(path)) {
+        return -EPERM;
+    }
+
+    int result = CallJsOperation("unlink", path);
+    if (result == 0) {
+        FuseContext* ctx = CurrentContext();
+        if (ctx) {
+            ctx->inodes.Forget(path);
+        }
+        ForgetStaleAttr(ctx, path);
+    }
+    return result;
 }
 
 int fuse3_mkdir(const char *path, mode_t mode) {
+    if (IsControlRequest(path)) {
+        return -EPERM;
+    }
     return CallJsOperation("mkdir", path, mode);
 }
 
 int fuse3_rmdir(const char *path) {
-    return CallJsOperation("rmdir", path);
+    if (IsControlRequest(path)) {
+        return -EPERM;
+    }
+    int result = CallJsOperation("rmdir", path);
+    if (result == 0) {
+        ForgetStaleAttr(CurrentContext(), path);
+    }
+    return result;
 }
 
 int fuse3_rename(const char *from, const char *to, unsigned int flags) {
-    return CallJsOperation("rename", from, to);
+    if (IsControlRequest(from) || IsControlRequest(to)) {
+        return -EPERM;
+    }
+
+    int result = CallJsOperation("rename", from, to);
+    if (result == 0) {
+        FuseContext* ctx = CurrentContext();
+        if (ctx) {
+            ctx->inodes.Rename(from, to);
+        }
+        ForgetStaleAttr(ctx, from);
+        ForgetStaleAttr(ctx, to);
+    }
+    return result;
+}
+
+// Attributes of an open file changed in JS; stop answering getattr from the old copy.
+// Only called once JS reported success: a failed call changed nothing.
+static void InvalidateAttr(const char *path, struct fuse_file_info *fi) {
+    FuseContext* ctx = CurrentContext();
+    if (!ctx) return;
+
+    std::shared_ptr<InodeData> inode = FindInode(ctx, path, fi);
+    if (inode) {
+        inode->InvalidateAttr();
+    }
+    ForgetStaleAttr(ctx, path);
 }
 
 int fuse3_chmod(const char *path, mode_t mode, struct fuse_file_info *fi) {
-    return CallJsOperation("chmod", path, mode);
+    if (IsControlRequest(path)) {
+        return -EPERM;
+    }
+
+    int result = CallJsOperation("chmod", path, mode);
+    if (result == 0) {
+        InvalidateAttr(path, fi);
+    }
+    return result;
 }
 
 int fuse3_chown(const char *path, uid_t uid, gid_t gid, struct fuse_file_info *fi) {
-    return CallJsOperation("chown", path, uid, gid);
+    if (IsControlRequest(path)) {
+        return -EPERM;
+    }
+
+    int result = CallJsOperation("chown", path, uid, gid);
+    if (result == 0) {
+        InvalidateAttr(path, fi);
+    }
+    return result;
 }
 
 int fuse3_truncate(const char *path, off_t size, struct fuse_file_info *fi) {
-    return CallJsOperation("truncate", path, size);
+    FuseContext* ctx = CurrentContext();
+    if (!ctx) return -EIO;
+    if (IsControlPath(ctx->options.controlDir, path)) {
+        return ControlTruncate(ctx, path);
+    }
+
+    std::shared_ptr<InodeData> inode = FindInode(ctx, path, fi);
+    if (inode && ctx->options.writeback) {
+        // ftruncate of an open file: JS learns about it with the next commit
+        inode->Truncate(size, true);
+        ForgetStaleAttr(ctx, path);
+        return 0;
+    }
+
+    int result = CallJsOperation("truncate", path, size);
+    if (result == 0 && inode) {
+        inode->Truncate(size, false);
+    }
+    if (result == 0) {
+        ForgetStaleAttr(ctx, path);
+    }
+    return result;
+}
+
+// tv_sec means nothing for UTIME_NOW and UTIME_OMIT
+static JsTime UtimensTime(const struct timespec& ts) {
+    if (ts.tv_nsec == UTIME_OMIT) {
+        return {true, 0};
+    }
+    if (ts.tv_nsec == UTIME_NOW) {
+        return {false, time(nullptr)};
+    }
+    return {false, ts.tv_sec};
 }
 
 int fuse3_utimens(const char *path, const struct timespec ts[2], struct fuse_file_info *fi) {
-    return CallJsOperation("utimens", path, ts[0].tv_sec, ts[1].tv_sec);
+    if (IsControlRequest(path)) {
+        return -EPERM;
+    }
+
+    int result = CallJsOperation("utimens", path, UtimensTime(ts[0]), UtimensTime(ts[1]));
+    if (result == 0) {
+        InvalidateAttr(path, fi);
+    }
+    return result;
 }
 
 int fuse3_release(const char *path, struct fuse_file_info *fi) {
-    FuseContext* ctx = GetContextFromPath(path);
-    if (!ctx) return -EIO;
+    FileHandle* handle = GetFileHandle(fi);
+    uint64_t fh = handle ? handle->jsFh : 0;
+
+    FuseContext* ctx = CurrentContext();
+    if (!ctx) {
+        delete handle;
+        fi->fh = 0;
+        return -EIO;
+    }
+    if (IsControlPath(ctx->options.controlDir, path)) {
+        return ControlRelease(fi);
+    }
 
-    auto promise = std::make_shared<std::promise<int>>();
-    std::future<int> future = promise->get_future();
+    // Normally flush already committed everything; this catches the rest
+    int commitResult = CommitDirty(ctx, path, handle);
 
-    uint64_t fh = fi->fh;
+    auto promise = std::make_shared<JsResult<int>>();
 
     auto callback = [path, fh, promise, ctx](Napi::Env env, Napi::Function jsCallback) {
         try {
@@ -494,7 +1096,7 @@ int fuse3_release(const char *path, struct fuse_file_info *fi) {
                 return;
             }
 
-            auto resultCb = Napi::Function::New(env, [promise](const Napi::CallbackInfo& info) {
+            auto resultCb = ResultCallback(ctx, env, [promise](const Napi::CallbackInfo& info) {
                 if (info.Length() > 0 && info[0].IsNumber()) {
                     promise->set_value(info[0].As<Napi::Number>().Int32Value());
                 } else {
@@ -502,9 +1104,9 @@ int fuse3_release(const char *path, struct fuse_file_info *fi) {
                 }
             });
 
-            release.As<Napi::Function>().Call(ops, {
-                Napi::String::New(env, path),
-                Napi::Number::New(env, static_cast<double>(fh)),
+            CallHandler(release, ops, {
+                JsString(env, path),
+                JsNumber(env, fh),
                 resultCb
             });
 
@@ -513,19 +1115,57 @@ int fuse3_release(const char *path, struct fuse_file_info *fi) {
         }
     };
 
-    ctx->tsfn.BlockingCall(callback);
-    return future.get();
+    int result = CallJsAndWait(ctx, promise, callback);
+
+    // JS may settle a written file's attributes only now, e.g. after an upload
+    if (handle && handle->writable) {
+        ForgetStaleAttr(ctx, path);
+    }
+    if (handle && handle->inode) {
+        if (handle->writable) {
+            handle->inode->RemoveWriter(handle->jsFh);
+        }
+        ctx->inodes.Release(path, handle->inode);
+    }
+    delete handle;
+    fi->fh = 0;
+    return commitResult != 0 ? commitResult : result;
 }
 
 int fuse3_fsync(const char *path, int isdatasync, struct fuse_file_info *fi) {
-    return CallJsOperation("fsync", path, isdatasync, fi->fh);
+    FuseContext* ctx = CurrentContext();
+    if (!ctx) return -EIO;
+    if (IsControlPath(ctx->options.controlDir, path)) {
+        return 0;
+    }
+
+    int result = CommitDirty(ctx, path, GetFileHandle(fi));
+    if (result != 0) {
+        return result;
+    }
+    return CallJsOperation("fsync", path, isdatasync, GetJsFh(fi));
 }
 
 int fuse3_flush(const char *path, struct fuse_file_info *fi) {
-    return CallJsOperation("flush", path, fi->fh);
+    FuseContext* ctx = CurrentContext();
+    if (!ctx) return -EIO;
+    if (IsControlPath(ctx->options.controlDir, path)) {
+        return 0;
+    }
+
+    // close() is the commit point for buffered writes
+    int result = CommitDirty(ctx, path, GetFileHandle(fi));
+    if (result != 0) {
+        return result;
+    }
+    return CallJsOperation("flush", path, GetJsFh(fi));
 }
 
 int fuse3_access(const char *path, int mask) {
+    FuseContext* ctx = CurrentContext();
+    if (ctx && IsControlPath(ctx->options.controlDir, path)) {
+        return ControlAccess(ctx, path, mask);
+    }
     return CallJsOperation("access", path, mask);
 }
 
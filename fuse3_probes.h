@@ -0,0 +1,59 @@
+#ifndef FUSE3_PROBES_H
+#define FUSE3_PROBES_H
+
+// USDT probes for bpftrace, perf and SystemTap (provider "fuse3"). With
+// <sys/sdt.h> available each probe is a single nop plus a note section
+// entry; otherwise, or with FUSE3_NO_USDT defined, they compile to nothing
+// and their arguments are not evaluated.
+//
+// Request ids are the address of the request's RequestTimes, call ids the
+// address of the JS round trip's JsResult; both are only meaningful while
+// the request or call is in flight.
+
+#if !defined(FUSE3_NO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define FUSE3_HAVE_USDT 1
+#endif
+#endif
+
+#ifdef FUSE3_HAVE_USDT
+
+// FUSE thread entered / left an operation handler
+#define FUSE3_PROBE_REQUEST_START(op, path, callerPid, requestId) \
+    DTRACE_PROBE4(fuse3, request__start, op, path, callerPid, requestId)
+#define FUSE3_PROBE_REQUEST_END(op, path, result, latencyNs, requestId) \
+    DTRACE_PROBE5(fuse3, request__end, op, path, result, latencyNs, requestId)
+
+// A JS call was queued on the FUSE thread / picked up on the JS thread
+#define FUSE3_PROBE_QUEUE_ENQUEUE(requestId, callId) \
+    DTRACE_PROBE2(fuse3, queue__enqueue, requestId, callId)
+#define FUSE3_PROBE_QUEUE_DEQUEUE(callId, queuedNs) \
+    DTRACE_PROBE2(fuse3, queue__dequeue, callId, queuedNs)
+
+// JS handler invoked / its result callback ran (both on the JS thread)
+#define FUSE3_PROBE_JS_START(callId) \
+    DTRACE_PROBE1(fuse3, js__start, callId)
+#define FUSE3_PROBE_JS_END(callId, handlerNs) \
+    DTRACE_PROBE2(fuse3, js__end, callId, handlerNs)
+
+// Request answered from native data or sent on to JS; kind is "attr" or "data"
+#define FUSE3_PROBE_CACHE_HIT(kind, path) \
+    DTRACE_PROBE2(fuse3, cache__hit, kind, path)
+#define FUSE3_PROBE_CACHE_MISS(kind, path) \
+    DTRACE_PROBE2(fuse3, cache__miss, kind, path)
+
+#else
+
+#define FUSE3_PROBE_REQUEST_START(op, path, callerPid, requestId) do {} while (0)
+#define FUSE3_PROBE_REQUEST_END(op, path, result, latencyNs, requestId) do {} while (0)
+#define FUSE3_PROBE_QUEUE_ENQUEUE(requestId, callId) do {} while (0)
+#define FUSE3_PROBE_QUEUE_DEQUEUE(callId, queuedNs) do {} while (0)
+#define FUSE3_PROBE_JS_START(callId) do {} while (0)
+#define FUSE3_PROBE_JS_END(callId, handlerNs) do {} while (0)
+#define FUSE3_PROBE_CACHE_HIT(kind, path) do {} while (0)
+#define FUSE3_PROBE_CACHE_MISS(kind, path) do {} while (0)
+
+#endif
+
+#endif // FUSE3_PROBES_H
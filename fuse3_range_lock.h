@@ -0,0 +1,74 @@
+#ifndef FUSE3_RANGE_LOCK_H
+#define FUSE3_RANGE_LOCK_H
+
+#include <sys/types.h>
+#include <stddef.h>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <algorithm>
+
+// Byte-range lock: overlapping ranges are serialized, disjoint ranges proceed
+// concurrently. Used to order parallel direct writes on one file handle.
+class RangeLock {
+public:
+    void Lock(off_t offset, size_t size) {
+        off_t end = offset + static_cast<off_t>(size);
+        std::unique_lock<std::mutex> lock(mutex_);
+        released_.wait(lock, [this, offset, end]() { return !Overlaps(offset, end); });
+        held_.emplace_back(offset, end);
+    }
+
+    void Unlock(off_t offset, size_t size) {
+        off_t end = offset + static_cast<off_t>(size);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = std::find(held_.begin(), held_.end(), std::make_pair(offset, end));
+            if (it != held_.end()) {
+                held_.erase(it);
+            }
+        }
+        released_.notify_all();
+    }
+
+private:
+    bool Overlaps(off_t start, off_t end) const {
+        for (const auto& range : held_) {
+            if (start < range.second && range.first < end) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::mutex mutex_;
+    std::condition_variable released_;
+    std::vector<std::pair<off_t, off_t>> held_;  // [start, end) of ranges in flight
+};
+
+// Holds a range for the lifetime of the guard; a null lock makes it a no-op
+class RangeGuard {
+public:
+    RangeGuard(RangeLock* lock, off_t offset, size_t size)
+        : lock_(lock), offset_(offset), size_(size) {
+        if (lock_) {
+            lock_->Lock(offset_, size_);
+        }
+    }
+
+    ~RangeGuard() {
+        if (lock_) {
+            lock_->Unlock(offset_, size_);
+        }
+    }
+
+    RangeGuard(const RangeGuard&) = delete;
+    RangeGuard& operator=(const RangeGuard&) = delete;
+
+private:
+    RangeLock* lock_;
+    off_t offset_;
+    size_t size_;
+};
+
+#endif // FUSE3_RANGE_LOCK_H
@@ -0,0 +1,272 @@
+#include "fuse3_record.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/random.h>
+#include <chrono>
+
+#include "fuse3_log.h"
+#include "fuse3_stats.h"
+
+static const size_t kRecordBufferSize = 1 << 20;
+static const size_t kRecordSlots = 1 << 14;  // Power of two; ~160 ms of 100k requests/s
+static const size_t kMaxPathLength = 0xffff;
+
+RequestRecorder::RequestRecorder()
+    : enabled_(false), producers_(0), file_(nullptr), hashPaths_(false), hashKey_(), startNs_(0),
+      enqueuePos_(0), pathBytes_(0), dropped_(0), stopping_(false), dequeuePos_(0), failed_(false),
+      records_(0), bytes_(0) {
+}
+
+RequestRecorder::~RequestRecorder() {
+    uint64_t records;
+    uint64_t bytes;
+    uint64_t dropped;
+    Stop(&records, &bytes, &dropped);
+}
+
+std::string RequestRecorder::Start(const std::string& file, bool hashPaths) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+        return "already recording";
+    }
+
+    // A fresh key per recording, never written out: hashed names cannot be
+    // looked up in a dictionary or matched across recordings
+    if (hashPaths && getrandom(hashKey_, sizeof(hashKey_), 0) != sizeof(hashKey_)) {
+        return std::string("no random key for hashed paths: ") + strerror(errno);
+    }
+
+    FILE *out = fopen(file.c_str(), "wb");
+    if (!out) {
+        return file + ": " + strerror(errno);
+    }
+    setvbuf(out, nullptr, _IOFBF, kRecordBufferSize);
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    RecordFileHeader header = {};
+    memcpy(header.magic, kRecordMagic, sizeof(header.magic));
+    header.version = kRecordVersion;
+    header.flags = hashPaths ? kRecordHashedPaths : 0;
+    header.startRealtimeNs = static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+    if (fwrite(&header, sizeof(header), 1, out) != 1) {
+        fclose(out);
+        return file + ": write failed";
+    }
+
+    slots_.reset(new Slot[kRecordSlots]);
+    for (size_t i = 0; i < kRecordSlots; i++) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePos_.store(0, std::memory_order_relaxed);
+    pathBytes_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+    dequeuePos_ = 0;
+    failed_ = false;
+    records_ = 0;
+    bytes_ = sizeof(header);
+
+    file_ = out;
+    hashPaths_ = hashPaths;
+    startNs_ = MonotonicNs();
+    stopping_.store(false, std::memory_order_relaxed);
+    writer_ = std::thread(&RequestRecorder::WriterLoop, this);
+    enabled_.store(true);
+    LOG_INFO(kLogCore, "recording requests to %s%s", file.c_str(), hashPaths ? " (hashed paths)" : "");
+    return "";
+}
+
+bool RequestRecorder::Stop(uint64_t *records, uint64_t *bytes, uint64_t *dropped) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_.store(false);
+    if (!file_) {
+        return false;
+    }
+
+    // Producers that saw the recorder enabled finish their slot, then the
+    // writer drains what is left
+    while (producers_.load() != 0) {
+        std::this_thread::yield();
+    }
+    stopping_.store(true, std::memory_order_release);
+    writer_.join();
+
+    fclose(file_);
+    file_ = nullptr;
+    slots_.reset();
+    *records = records_;
+    *bytes = bytes_;
+    *dropped = dropped_.load(std::memory_order_relaxed);
+    LOG_INFO(kLogCore, "recorded %llu requests, %llu dropped", static_cast<unsigned long long>(*records),
+             static_cast<unsigned long long>(*dropped));
+    return true;
+}
+
+static inline uint64_t RotateLeft(uint64_t x, int b) {
+    return (x << b) | (x >> (64 - b));
+}
+
+static inline void SipRound(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3) {
+    v0 += v1; v1 = RotateLeft(v1, 13); v1 ^= v0; v0 = RotateLeft(v0, 32);
+    v2 += v3; v3 = RotateLeft(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = RotateLeft(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = RotateLeft(v1, 17); v1 ^= v2; v2 = RotateLeft(v2, 32);
+}
+
+// SipHash-2-4 of one path component under the recording's key
+static uint64_t HashComponent(const uint64_t key[2], const char *name, size_t length) {
+    uint64_t v0 = key[0] ^ 0x736f6d6570736575ULL;
+    uint64_t v1 = key[1] ^ 0x646f72616e646f6dULL;
+    uint64_t v2 = key[0] ^ 0x6c7967656e657261ULL;
+    uint64_t v3 = key[1] ^ 0x7465646279746573ULL;
+    const unsigned char *in = reinterpret_cast<const unsigned char *>(name);
+
+    size_t full = length & ~static_cast<size_t>(7);
+    for (size_t i = 0; i < full; i += 8) {
+        uint64_t m;
+        memcpy(&m, in + i, sizeof(m));  // Little-endian hosts, see fuse3_record.h
+        v3 ^= m;
+        SipRound(v0, v1, v2, v3);
+        SipRound(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    uint64_t last = static_cast<uint64_t>(length) << 56;
+    for (size_t i = full; i < length; i++) {
+        last |= static_cast<uint64_t>(in[i]) << (8 * (i - full));
+    }
+    v3 ^= last;
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    v0 ^= last;
+
+    v2 ^= 0xff;
+    for (int i = 0; i < 4; i++) {
+        SipRound(v0, v1, v2, v3);
+    }
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+size_t RequestRecorder::MemoryUsage() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) {
+        return 0;
+    }
+    return kRecordBufferSize + kRecordSlots * sizeof(Slot) + pathBytes_.load(std::memory_order_relaxed);
+}
+
+void RequestRecorder::WritePath(const char *path, std::string *out) const {
+    if (!hashPaths_) {
+        out->append(path, strnlen(path, kMaxPathLength));
+        return;
+    }
+
+    size_t start = out->size();
+    const char *p = path;
+    while (*p) {
+        if (*p == '/') {
+            out->push_back(*p++);
+            continue;
+        }
+        size_t length = strcspn(p, "/");
+        char hashed[18];
+        snprintf(hashed, sizeof(hashed), "h%016llx", static_cast<unsigned long long>(HashComponent(hashKey_, p, length)));
+        out->append(hashed);
+        p += length;
+    }
+    if (out->size() - start > kMaxPathLength) {
+        out->resize(start + kMaxPathLength);
+    }
+}
+
+void RequestRecorder::Record(const RecordedRequest& request) {
+    // Announce this thread before checking enabled_, so Stop() either sees
+    // it here or this thread sees the recorder stopped
+    producers_.fetch_add(1);
+    if (!enabled_.load()) {
+        producers_.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;) {
+        slot = &slots_[pos & (kRecordSlots - 1)];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            producers_.fetch_sub(1, std::memory_order_release);
+            return;
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::string& paths = slot->paths;
+    size_t capacity = paths.capacity();
+    paths.clear();
+    WritePath(request.path ? request.path : "", &paths);
+    size_t pathLength = paths.size();
+    if (request.path2) {
+        WritePath(request.path2, &paths);
+    }
+    if (paths.capacity() != capacity) {
+        pathBytes_.fetch_add(paths.capacity() - capacity, std::memory_order_relaxed);
+    }
+
+    RecordEntry& entry = slot->entry;
+    entry = RecordEntry();
+    entry.startNs = request.startNs > startNs_ ? request.startNs - startNs_ : 0;
+    entry.offset = request.offset;
+    entry.size = static_cast<uint32_t>(request.size > UINT32_MAX ? UINT32_MAX : request.size);
+    entry.durationUs = static_cast<uint32_t>(request.durationNs / 1000 > UINT32_MAX ? UINT32_MAX : request.durationNs / 1000);
+    entry.pid = request.pid;
+    entry.result = request.result;
+    entry.flags = request.flags;
+    entry.op = request.op;
+    entry.pathLength = static_cast<uint16_t>(pathLength);
+    entry.path2Length = static_cast<uint16_t>(paths.size() - pathLength);
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    producers_.fetch_sub(1, std::memory_order_release);
+}
+
+// Write every full slot, in ring order, to the file (writer thread)
+void RequestRecorder::Drain() {
+    for (;;) {
+        Slot& slot = slots_[dequeuePos_ & (kRecordSlots - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePos_ + 1) {
+            break;
+        }
+
+        if (!failed_) {
+            if (fwrite(&slot.entry, sizeof(slot.entry), 1, file_) != 1 ||
+                fwrite(slot.paths.data(), 1, slot.paths.size(), file_) != slot.paths.size()) {
+                LOG_ERROR(kLogCore, "request recording stopped: write failed");
+                failed_ = true;
+                enabled_.store(false, std::memory_order_relaxed);
+            } else {
+                records_++;
+                bytes_ += sizeof(slot.entry) + slot.paths.size();
+            }
+        }
+
+        slot.sequence.store(dequeuePos_ + kRecordSlots, std::memory_order_release);
+        dequeuePos_++;
+    }
+}
+
+void RequestRecorder::WriterLoop() {
+    while (!stopping_.load(std::memory_order_acquire)) {
+        Drain();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    Drain();
+}
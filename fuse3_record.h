@@ -0,0 +1,121 @@
+#ifndef FUSE3_RECORD_H
+#define FUSE3_RECORD_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Request recording file, read back by tools/fuse3replay. Host byte order
+// (little-endian on every platform the addon builds for):
+//
+//   RecordFileHeader
+//   RecordEntry, path bytes, path2 bytes    (repeated, no padding)
+//
+// Paths are not NUL-terminated. With hashed paths every component is
+// replaced by 'h' and 16 hex digits of its SipHash under a random key that
+// lives only as long as the recording, so the tree's shape and repeated
+// names survive while the names themselves do not.
+
+static const char kRecordMagic[8] = { 'F', '3', 'R', 'E', 'C', 'O', 'R', 'D' };
+static const uint32_t kRecordVersion = 1;
+static const uint32_t kRecordHashedPaths = 1;  // RecordFileHeader::flags
+
+struct __attribute__((packed)) RecordFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t startRealtimeNs;  // Wall clock when recording started
+};
+
+struct __attribute__((packed)) RecordEntry {
+    uint64_t startNs;     // Since recording started
+    uint64_t offset;      // read/write/copy_file_range offset, truncate size
+    uint32_t size;        // Bytes requested by read/write/copy_file_range
+    uint32_t durationUs;
+    uint32_t pid;         // Calling process
+    int32_t result;       // What the operation returned
+    uint32_t flags;       // open flags, create/mkdir/chmod mode, access mask
+    uint8_t op;           // FuseOp
+    uint8_t reserved;
+    uint16_t pathLength;
+    uint16_t path2Length; // rename target, copy_file_range destination
+    uint16_t reserved2;
+};
+
+// One request as the operation wrapper sees it
+struct RecordedRequest {
+    uint64_t startNs;     // MonotonicNs() at dispatch
+    uint64_t durationNs;
+    const char *path;
+    const char *path2;    // nullptr unless the op has a second path
+    uint64_t offset;
+    uint64_t size;
+    uint32_t flags;
+    uint32_t pid;
+    int32_t result;
+    uint8_t op;
+};
+
+// Streams every request of a mount to a file while started. FUSE threads
+// claim a slot in a bounded multi-producer ring (the logger's design, see
+// fuse3_log.cc) and a writer thread drains it to the file, so a request
+// never waits on a lock or on disk. When the ring is full the record is
+// dropped and counted. Stopped, recording costs one relaxed load.
+class RequestRecorder {
+public:
+    RequestRecorder();
+    ~RequestRecorder();
+
+    bool Enabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // Empty on success, else why the file could not be started
+    std::string Start(const std::string& file, bool hashPaths);
+
+    // Drain the ring, flush and close; false if nothing was recording
+    bool Stop(uint64_t *records, uint64_t *bytes, uint64_t *dropped);
+
+    void Record(const RecordedRequest& request);
+
+    // Ring, path storage and output buffer while recording
+    size_t MemoryUsage();
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;  // pos: free for the producer at pos, pos + 1: full
+        RecordEntry entry;
+        std::string paths;             // path then path2, hashed if requested
+    };
+
+    void WritePath(const char *path, std::string *out) const;
+    void Drain();
+    void WriterLoop();
+
+    std::atomic<bool> enabled_;
+    std::atomic<int> producers_;  // Threads inside Record()
+    std::mutex mutex_;            // Start, Stop and MemoryUsage
+    FILE *file_;
+    bool hashPaths_;
+    uint64_t hashKey_[2];  // Per recording, never written to the file
+    uint64_t startNs_;
+
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<size_t> enqueuePos_;
+    std::atomic<size_t> pathBytes_;  // Capacity of the slots' path strings
+    std::atomic<uint64_t> dropped_;
+    std::thread writer_;
+    std::atomic<bool> stopping_;
+
+    // Writer thread only, read by Stop() once it has joined
+    size_t dequeuePos_;
+    bool failed_;
+    uint64_t records_;
+    uint64_t bytes_;
+};
+
+#endif // FUSE3_RECORD_H
@@ -0,0 +1,365 @@
+#include "fuse3_stats.h"
+#include "fuse3_alloc.h"
+
+#include <errno.h>
+#include <string.h>
+#include <math.h>
+
+static const char *const kOpNames[kOpCount] = {
+    "getattr", "readdir", "open", "read", "write", "write_buf", "create", "unlink",
+    "mkdir", "rmdir", "rename", "chmod", "chown", "truncate", "utimens", "release",
+    "fsync", "flush", "access", "statfs", "copy_file_range"
+};
+
+const char *OpName(FuseOp op) {
+    return op < kOpCount ? kOpNames[op] : "unknown";
+}
+
+static const char *const kStageNames[kStageCount] = { "native", "queue", "js", "wake" };
+
+const char *StageName(RequestStage stage) {
+    return stage < kStageCount ? kStageNames[stage] : "unknown";
+}
+
+static const char *const kCacheKindNames[kCacheKindCount] = { "attr", "data" };
+
+const char *CacheKindName(CacheKind kind) {
+    return kind < kCacheKindCount ? kCacheKindNames[kind] : "unknown";
+}
+
+thread_local RequestTimes *t_currentRequest = nullptr;
+
+static uint64_t Elapsed(uint64_t from, uint64_t to) {
+    return to > from ? to - from : 0;
+}
+
+void NoteJsRoundTrip(uint64_t enqueueNs, uint64_t jsStartNs, uint64_t jsCallbackNs, uint64_t resumeNs) {
+    RequestTimes *times = t_currentRequest;
+    if (!times) {
+        return;
+    }
+
+    if (times->jsCalls == 0) {
+        times->enqueueNs = enqueueNs;
+        times->jsStartNs = jsStartNs;
+        times->jsCallbackNs = jsCallbackNs;
+        times->resumeNs = resumeNs;
+    }
+    times->queueNs += Elapsed(enqueueNs, jsStartNs);
+    times->jsNs += Elapsed(jsStartNs, jsCallbackNs);
+    times->wakeNs += Elapsed(jsCallbackNs, resumeNs);
+    times->jsCalls++;
+}
+
+FuseOp OpFromName(const char *name) {
+    for (int op = 0; op < kOpCount; op++) {
+        if (strcmp(name, kOpNames[op]) == 0) {
+            return static_cast<FuseOp>(op);
+        }
+    }
+    return kOpCount;
+}
+
+RequestStage DominantStage(const RequestTimes& times, uint64_t now) {
+    uint64_t inJs = times.queueNs + times.jsNs + times.wakeNs;
+    uint64_t total = Elapsed(times.dequeueNs, now);
+    uint64_t native = total > inJs ? total - inJs : 0;
+
+    RequestStage stage = kStageNative;
+    uint64_t longest = native;
+    if (times.queueNs > longest) {
+        stage = kStageQueue;
+        longest = times.queueNs;
+    }
+    if (times.jsNs > longest) {
+        stage = kStageJs;
+        longest = times.jsNs;
+    }
+    if (times.wakeNs > longest) {
+        stage = kStageWake;
+    }
+    return stage;
+}
+
+const char *ErrnoName(int err) {
+    switch (err) {
+        case EPERM: return "EPERM";
+        case ENOENT: return "ENOENT";
+        case EINTR: return "EINTR";
+        case EIO: return "EIO";
+        case EBADF: return "EBADF";
+        case EAGAIN: return "EAGAIN";
+        case ENOMEM: return "ENOMEM";
+        case EACCES: return "EACCES";
+        case EBUSY: return "EBUSY";
+        case EEXIST: return "EEXIST";
+        case EXDEV: return "EXDEV";
+        case ENOTDIR: return "ENOTDIR";
+        case EISDIR: return "EISDIR";
+        case EINVAL: return "EINVAL";
+        case EFBIG: return "EFBIG";
+        case ENOSPC: return "ENOSPC";
+        case EROFS: return "EROFS";
+        case ENAMETOOLONG: return "ENAMETOOLONG";
+        case ENOSYS: return "ENOSYS";
+        case ENOTEMPTY: return "ENOTEMPTY";
+        case ENODATA: return "ENODATA";
+        case EOPNOTSUPP: return "EOPNOTSUPP";
+        case ETIMEDOUT: return "ETIMEDOUT";
+        default: return nullptr;
+    }
+}
+
+static int BucketIndex(uint64_t ns) {
+    if (ns < (1ULL << kHistogramSubBits)) {
+        return static_cast<int>(ns);
+    }
+    int exponent = 63 - __builtin_clzll(ns);
+    if (exponent > kHistogramMaxExponent) {
+        return kHistogramBuckets - 1;
+    }
+    int sub = static_cast<int>((ns >> (exponent - kHistogramSubBits)) & ((1 << kHistogramSubBits) - 1));
+    return ((exponent - kHistogramSubBits + 1) << kHistogramSubBits) + sub;
+}
+
+// Midpoint of a bucket in nanoseconds
+static double BucketValue(int index) {
+    if (index < (1 << kHistogramSubBits)) {
+        return index;
+    }
+    int exponent = (index >> kHistogramSubBits) + kHistogramSubBits - 1;
+    int sub = index & ((1 << kHistogramSubBits) - 1);
+    double width = ldexp(1.0, exponent - kHistogramSubBits);
+    double low = ((1 << kHistogramSubBits) + sub) * width;
+    return low + width / 2;
+}
+
+uint64_t HistogramBucketLimitNs(int index) {
+    if (index < (1 << kHistogramSubBits)) {
+        return static_cast<uint64_t>(index) + 1;
+    }
+    int exponent = (index >> kHistogramSubBits) + kHistogramSubBits - 1;
+    int sub = index & ((1 << kHistogramSubBits) - 1);
+    uint64_t width = 1ULL << (exponent - kHistogramSubBits);
+    return ((1ULL << kHistogramSubBits) + sub + 1) * width;
+}
+
+HistogramSnapshot::HistogramSnapshot() : count(0), sumNs(0), maxNs(0) {
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void HistogramSnapshot::Merge(const HistogramSnapshot& other) {
+    for (int i = 0; i < kHistogramBuckets; i++) {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    sumNs += other.sumNs;
+    if (other.maxNs > maxNs) {
+        maxNs = other.maxNs;
+    }
+}
+
+double HistogramSnapshot::PercentileUs(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(ceil(q * static_cast<double>(count)));
+    if (target == 0) {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kHistogramBuckets; i++) {
+        seen += buckets[i];
+        if (seen >= target) {
+            // Never report more than the largest value actually seen
+            return fmin(BucketValue(i), static_cast<double>(maxNs)) / 1000.0;
+        }
+    }
+    return static_cast<double>(maxNs) / 1000.0;
+}
+
+double HistogramSnapshot::MeanUs() const {
+    return count ? static_cast<double>(sumNs) / static_cast<double>(count) / 1000.0 : 0;
+}
+
+Histogram::Histogram() {
+    Reset();
+}
+
+void Histogram::Record(uint64_t ns) {
+    buckets_[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sumNs_.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t max = maxNs_.load(std::memory_order_relaxed);
+    while (ns > max && !maxNs_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::AddTo(HistogramSnapshot *out) const {
+    for (int i = 0; i < kHistogramBuckets; i++) {
+        out->buckets[i] += buckets_[i].load(std::memory_order_relaxed);
+    }
+    out->count += count_.load(std::memory_order_relaxed);
+    out->sumNs += sumNs_.load(std::memory_order_relaxed);
+    uint64_t max = maxNs_.load(std::memory_order_relaxed);
+    if (max > out->maxNs) {
+        out->maxNs = max;
+    }
+}
+
+void Histogram::Reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sumNs_.store(0, std::memory_order_relaxed);
+    maxNs_.store(0, std::memory_order_relaxed);
+}
+
+OpSnapshot::OpSnapshot() : errors(0), bytes(0), jsCalls(0) {
+    memset(errnos, 0, sizeof(errnos));
+}
+
+OpStats::Counters::Counters() : errors(0), bytes(0), jsCalls(0) {
+    for (auto& slot : errnos) {
+        slot.store(0, std::memory_order_relaxed);
+    }
+}
+
+int StatsShard() {
+    static std::atomic<unsigned> nextThread(0);
+    static thread_local int shard = static_cast<int>(nextThread.fetch_add(1, std::memory_order_relaxed));
+    return shard;
+}
+
+OpStats::OpStats() {
+    for (auto& op : counters_) {
+        for (auto& counters : op) {
+            counters.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+}
+
+OpStats::~OpStats() {
+    for (auto& op : counters_) {
+        for (auto& counters : op) {
+            delete counters.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// This thread's shard of op, allocated on first use
+OpStats::Counters *OpStats::ForRecord(FuseOp op) {
+    std::atomic<Counters *>& slot = counters_[op][StatsShard() % kStatsShards];
+    Counters *counters = slot.load(std::memory_order_acquire);
+    if (counters) {
+        return counters;
+    }
+
+    Counters *created;
+    {
+        FUSE3_ALLOC_SCOPE(nullptr);  // The mount's bookkeeping, not the request's
+        created = new Counters();
+    }
+    if (slot.compare_exchange_strong(counters, created, std::memory_order_acq_rel)) {
+        allocated_.fetch_add(1, std::memory_order_relaxed);
+        return created;
+    }
+    delete created;  // Another thread on the same shard got there first
+    return counters;
+}
+
+void OpStats::Record(FuseOp op, const RequestTimes& times, int result, uint64_t bytes) {
+    Counters& counters = *ForRecord(op);
+
+    uint64_t total = Elapsed(times.dequeueNs, times.replyNs);
+    counters.latency.Record(total);
+
+    uint64_t inJs = times.queueNs + times.jsNs + times.wakeNs;
+    counters.stages[kStageNative].Record(total > inJs ? total - inJs : 0);
+    if (times.jsCalls > 0) {
+        counters.jsCalls.fetch_add(times.jsCalls, std::memory_order_relaxed);
+        counters.stages[kStageQueue].Record(times.queueNs);
+        counters.stages[kStageJs].Record(times.jsNs);
+        counters.stages[kStageWake].Record(times.wakeNs);
+    }
+
+    if (result < 0) {
+        int err = -result;
+        counters.errors.fetch_add(1, std::memory_order_relaxed);
+        counters.errnos[err < kErrnoSlots - 1 ? err : kErrnoSlots - 1].fetch_add(1, std::memory_order_relaxed);
+    } else if (bytes > 0) {
+        counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+void OpStats::Snapshot(FuseOp op, OpSnapshot *out) const {
+    for (int shard = 0; shard < kStatsShards; shard++) {
+        const Counters *allocated = counters_[op][shard].load(std::memory_order_acquire);
+        if (!allocated) {
+            continue;
+        }
+        const Counters& counters = *allocated;
+
+        counters.latency.AddTo(&out->latency);
+        for (int stage = 0; stage < kStageCount; stage++) {
+            counters.stages[stage].AddTo(&out->stages[stage]);
+        }
+        out->errors += counters.errors.load(std::memory_order_relaxed);
+        out->bytes += counters.bytes.load(std::memory_order_relaxed);
+        out->jsCalls += counters.jsCalls.load(std::memory_order_relaxed);
+        for (int i = 0; i < kErrnoSlots; i++) {
+            out->errnos[i] += counters.errnos[i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void OpStats::RecordCache(CacheKind kind, bool hit) {
+    CacheCounters& counters = cache_[StatsShard() % kStatsShards];
+    (hit ? counters.hits : counters.misses)[kind].fetch_add(1, std::memory_order_relaxed);
+}
+
+void OpStats::Snapshot(CacheSnapshot *out) const {
+    memset(out, 0, sizeof(*out));
+    for (const CacheCounters& counters : cache_) {
+        for (int kind = 0; kind < kCacheKindCount; kind++) {
+            out->hits[kind] += counters.hits[kind].load(std::memory_order_relaxed);
+            out->misses[kind] += counters.misses[kind].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void OpStats::Reset() {
+    // Counters stay allocated: the same operations are likely to run again
+    for (auto& op : counters_) {
+        for (auto& slot : op) {
+            Counters *counters = slot.load(std::memory_order_acquire);
+            if (!counters) {
+                continue;
+            }
+            counters->latency.Reset();
+            for (auto& stage : counters->stages) {
+                stage.Reset();
+            }
+            counters->errors.store(0, std::memory_order_relaxed);
+            counters->bytes.store(0, std::memory_order_relaxed);
+            counters->jsCalls.store(0, std::memory_order_relaxed);
+            for (auto& errnoSlot : counters->errnos) {
+                errnoSlot.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+    for (auto& counters : cache_) {
+        for (int kind = 0; kind < kCacheKindCount; kind++) {
+            counters.hits[kind].store(0, std::memory_order_relaxed);
+            counters.misses[kind].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t OpStats::MemoryUsage() const {
+    return sizeof(*this) + allocated_.load(std::memory_order_relaxed) * sizeof(Counters);
+}
@@ -0,0 +1,218 @@
+#ifndef FUSE3_STATS_H
+#define FUSE3_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+
+// Operations with their own counters. Keep in step with kOpNames.
+enum FuseOp {
+    kOpGetattr,
+    kOpReaddir,
+    kOpOpen,
+    kOpRead,
+    kOpWrite,
+    kOpWriteBuf,
+    kOpCreate,
+    kOpUnlink,
+    kOpMkdir,
+    kOpRmdir,
+    kOpRename,
+    kOpChmod,
+    kOpChown,
+    kOpTruncate,
+    kOpUtimens,
+    kOpRelease,
+    kOpFsync,
+    kOpFlush,
+    kOpAccess,
+    kOpStatfs,
+    kOpCopyFileRange,
+    kOpCount
+};
+
+const char *OpName(FuseOp op);
+
+// Operation for a name from OpName, kOpCount if unknown
+FuseOp OpFromName(const char *name);
+
+// Symbolic name of a positive errno ("ENOENT"), nullptr if not known
+const char *ErrnoName(int err);
+
+static inline uint64_t MonotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Log-linear buckets over nanoseconds: 8 sub-buckets per power of two
+// (at most 12.5% relative error) from 0 to 2^40 ns (~18 minutes).
+static const int kHistogramSubBits = 3;
+static const int kHistogramMaxExponent = 39;
+static const int kHistogramBuckets = (kHistogramMaxExponent - kHistogramSubBits + 2) << kHistogramSubBits;
+
+// Plain copy of one or more histograms, merged for reporting
+struct HistogramSnapshot {
+    HistogramSnapshot();
+
+    void Merge(const HistogramSnapshot& other);
+
+    // Latency at quantile q (0..1) in microseconds, 0 if empty
+    double PercentileUs(double q) const;
+    double MeanUs() const;
+
+    uint64_t buckets[kHistogramBuckets];
+    uint64_t count;
+    uint64_t sumNs;
+    uint64_t maxNs;
+};
+
+// Recording side: relaxed atomic increments only, safe from any thread
+class Histogram {
+public:
+    Histogram();
+
+    void Record(uint64_t ns);
+    void AddTo(HistogramSnapshot *out) const;
+    void Reset();
+
+private:
+    std::atomic<uint64_t> buckets_[kHistogramBuckets];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sumNs_;
+    std::atomic<uint64_t> maxNs_;
+};
+
+// Exclusive upper bound of a histogram bucket in nanoseconds
+uint64_t HistogramBucketLimitNs(int index);
+
+// Requests in progress right now. Shared by every FUSE thread, so each
+// request touches it only on entry, exit and around its JS round trips.
+struct RequestGauges {
+    std::atomic<int64_t> inflight{0};   // Inside a FUSE handler
+    std::atomic<int64_t> waiting{0};    // Blocked on a JS round trip
+    std::atomic<int64_t> queued{0};     // Of those, not yet taken by the JS thread
+    std::atomic<uint64_t> dirtyLimitCommits{0};  // Writes that committed past a dirty limit
+};
+
+// Where a request's time went. Queue, js and wake are summed over every JS
+// round trip the request made; native is the rest of the handler time.
+enum RequestStage {
+    kStageNative,   // FUSE thread work outside JS round trips
+    kStageQueue,    // Waiting in the TSFN queue for the JS thread
+    kStageJs,       // JS handler running until it called back
+    kStageWake,     // From the JS callback until the FUSE thread resumed
+    kStageCount
+};
+
+const char *StageName(RequestStage stage);
+
+// Lifecycle of the request a FUSE thread is serving. Timestamps are
+// CLOCK_MONOTONIC ns of the first JS round trip; 0 if it never reached JS.
+struct RequestTimes {
+    uint64_t dequeueNs;     // Handler entered on a FUSE thread
+    uint64_t enqueueNs;     // Queued to the JS thread
+    uint64_t jsStartNs;     // JS thread started the call
+    uint64_t jsCallbackNs;  // JS result callback ran
+    uint64_t resumeNs;      // FUSE thread resumed after the callback
+    uint64_t replyNs;       // Handler returned its reply
+    uint64_t queueNs;
+    uint64_t jsNs;
+    uint64_t wakeNs;
+    unsigned jsCalls;
+};
+
+// Request the calling FUSE thread is serving, nullptr outside a handler
+extern thread_local RequestTimes *t_currentRequest;
+
+// Account one JS round trip to the current request (FUSE thread, after it resumed)
+void NoteJsRoundTrip(uint64_t enqueueNs, uint64_t jsStartNs, uint64_t jsCallbackNs, uint64_t resumeNs);
+
+// Stage the request spent most of its time in up to now
+RequestStage DominantStage(const RequestTimes& times, uint64_t now);
+
+// Result codes tracked individually; larger errnos share the last slot
+static const int kErrnoSlots = 134;
+
+// Aggregated view of one operation
+struct OpSnapshot {
+    OpSnapshot();
+
+    HistogramSnapshot latency;
+    HistogramSnapshot stages[kStageCount];
+    uint64_t errors;
+    uint64_t bytes;
+    uint64_t jsCalls;   // JS round trips, summed over requests (stages count requests)
+    uint64_t errnos[kErrnoSlots];   // errnos[0] is unused, errnos[kErrnoSlots - 1] is "other"
+};
+
+// Native caches that can answer a request without JS
+enum CacheKind {
+    kCacheAttr,     // getattr of an open file from native size tracking
+    kCacheData,     // read from native data (writeback mode)
+    kCacheKindCount
+};
+
+const char *CacheKindName(CacheKind kind);
+
+struct CacheSnapshot {
+    uint64_t hits[kCacheKindCount];
+    uint64_t misses[kCacheKindCount];
+};
+
+// Per-mount operation statistics. Each recording thread is pinned to one of
+// kStatsShards copies, so concurrent FUSE threads do not share cache lines;
+// Snapshot() sums the shards. A shard's counters for an operation (about
+// 13 KB of histograms) are allocated when that shard first records it, so
+// a mount pays only for the operations and threads it actually sees.
+class OpStats {
+public:
+    OpStats();
+    ~OpStats();
+
+    OpStats(const OpStats&) = delete;
+    OpStats& operator=(const OpStats&) = delete;
+
+    void Record(FuseOp op, const RequestTimes& times, int result, uint64_t bytes);
+    void Snapshot(FuseOp op, OpSnapshot *out) const;
+
+    // A request looked in a native cache; misses went on to JS
+    void RecordCache(CacheKind kind, bool hit);
+    void Snapshot(CacheSnapshot *out) const;
+
+    void Reset();
+
+    // Bytes held, counters allocated so far included
+    size_t MemoryUsage() const;
+
+private:
+    static const int kStatsShards = 4;
+
+    struct alignas(64) CacheCounters {
+        std::atomic<uint64_t> hits[kCacheKindCount];
+        std::atomic<uint64_t> misses[kCacheKindCount];
+    };
+
+    struct alignas(64) Counters {
+        Counters();
+
+        Histogram latency;
+        Histogram stages[kStageCount];
+        std::atomic<uint64_t> errors;
+        std::atomic<uint64_t> bytes;
+        std::atomic<uint64_t> jsCalls;
+        std::atomic<uint64_t> errnos[kErrnoSlots];
+    };
+
+    Counters *ForRecord(FuseOp op);
+
+    std::atomic<Counters *> counters_[kOpCount][kStatsShards];
+    std::atomic<size_t> allocated_{0};
+    CacheCounters cache_[kStatsShards] = {};
+};
+
+// Small per-thread index for picking a shard (first thread 0, then 1, ...)
+int StatsShard();
+
+#endif // FUSE3_STATS_H
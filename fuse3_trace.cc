@@ -0,0 +1,155 @@
+#include "fuse3_trace.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <thread>
+
+// Track the JS main thread is drawn on in exported traces
+static const int kJsThreadTrack = 0;
+
+uint64_t HashPath(const char *path) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *p = reinterpret_cast<const unsigned char *>(path); *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+int32_t CurrentThreadId() {
+    static thread_local int32_t tid = static_cast<int32_t>(syscall(SYS_gettid));
+    return tid;
+}
+
+TraceBuffer::TraceBuffer() : enabled_(false), writers_(0), next_(0), capacity_(0) {
+}
+
+void TraceBuffer::Start(size_t capacity) {
+    enabled_.store(false);
+    WaitForWriters();
+
+    capacity_ = capacity > 0 ? capacity : kDefaultCapacity;
+    slots_.reset(new Slot[capacity_]);
+    for (size_t i = 0; i < capacity_; i++) {
+        slots_[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    next_.store(0, std::memory_order_relaxed);
+
+    enabled_.store(true);
+}
+
+std::string TraceBuffer::Stop() {
+    enabled_.store(false);
+    WaitForWriters();
+
+    std::string json = ExportChromeJson();
+    slots_.reset();
+    capacity_ = 0;
+    return json;
+}
+
+void TraceBuffer::WaitForWriters() {
+    while (writers_.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void TraceBuffer::Record(const TraceRecord& record) {
+    // Stop() flips enabled_ and then waits for writers_, so once a writer is
+    // counted and still sees enabled_, slots_ stays valid until it leaves
+    writers_.fetch_add(1);
+    if (!enabled_.load()) {
+        writers_.fetch_sub(1);
+        return;
+    }
+
+    uint64_t pos = next_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[pos % capacity_];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    slot.record = record;
+    slot.record.id = pos + 1;
+    slot.sequence.store(pos + 1, std::memory_order_release);
+
+    writers_.fetch_sub(1);
+}
+
+size_t TraceBuffer::MemoryUsage() const {
+    return capacity_ * sizeof(Slot);
+}
+
+static void AppendF(std::string& out, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+static void AppendF(std::string& out, const char *format, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len > 0) {
+        out.append(buf, std::min(static_cast<size_t>(len), sizeof(buf) - 1));
+    }
+}
+
+// Complete ("X") event; timestamps in microseconds
+static void AppendSpan(std::string& out, const char *name, const char *category, int pid, int tid,
+                       uint64_t startNs, uint64_t endNs, uint64_t id) {
+    AppendF(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                 "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"id\":%llu}}",
+            name, category, pid, tid, startNs / 1000.0, (endNs > startNs ? endNs - startNs : 0) / 1000.0,
+            static_cast<unsigned long long>(id));
+}
+
+std::string TraceBuffer::ExportChromeJson() const {
+    int pid = static_cast<int>(getpid());
+    std::string out;
+    out.reserve(256 + capacity_ * 64);
+
+    out += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    AppendF(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"fuse3\"}}", pid);
+    AppendF(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"JS main thread\"}}",
+            pid, kJsThreadTrack);
+
+    uint64_t end = next_.load(std::memory_order_acquire);
+    uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+    for (uint64_t pos = begin; pos < end; pos++) {
+        const Slot& slot = slots_[pos % capacity_];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            continue;
+        }
+
+        const TraceRecord& r = slot.record;
+        const RequestTimes& t = r.times;
+        const char *name = OpName(static_cast<FuseOp>(r.op));
+
+        // The request on the FUSE thread that served it
+        AppendF(out, ",\n{\"name\":\"%s\",\"cat\":\"fuse\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                     "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"id\":%llu,\"path\":\"%016llx\",\"callerPid\":%d,"
+                     "\"bytes\":%llu,\"errno\":%d,\"jsCalls\":%u}}",
+                name, pid, r.tid, t.dequeueNs / 1000.0,
+                (t.replyNs > t.dequeueNs ? t.replyNs - t.dequeueNs : 0) / 1000.0,
+                static_cast<unsigned long long>(r.id), static_cast<unsigned long long>(r.pathHash),
+                r.callerPid, static_cast<unsigned long long>(r.bytes), r.error, t.jsCalls);
+
+        if (t.jsCalls == 0) {
+            continue;
+        }
+
+        // Stages of the first JS round trip, nested under the request
+        AppendSpan(out, "queue", "stage", pid, r.tid, t.enqueueNs, t.jsStartNs, r.id);
+        AppendSpan(out, "js", "stage", pid, r.tid, t.jsStartNs, t.jsCallbackNs, r.id);
+        AppendSpan(out, "wake", "stage", pid, r.tid, t.jsCallbackNs, t.resumeNs, r.id);
+
+        // The JS handler on the main thread. Handlers overlap while they wait
+        // on async work, so they are async events keyed by request id.
+        AppendF(out, ",\n{\"name\":\"%s\",\"cat\":\"js\",\"ph\":\"b\",\"id\":%llu,\"pid\":%d,\"tid\":%d,\"ts\":%.3f}",
+                name, static_cast<unsigned long long>(r.id), pid, kJsThreadTrack, t.jsStartNs / 1000.0);
+        AppendF(out, ",\n{\"name\":\"%s\",\"cat\":\"js\",\"ph\":\"e\",\"id\":%llu,\"pid\":%d,\"tid\":%d,\"ts\":%.3f}",
+                name, static_cast<unsigned long long>(r.id), pid, kJsThreadTrack, t.jsCallbackNs / 1000.0);
+    }
+
+    out += "\n]}\n";
+    return out;
+}
@@ -0,0 +1,70 @@
+#ifndef FUSE3_TRACE_H
+#define FUSE3_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "fuse3_stats.h"
+
+// One finished request as kept by the trace buffer
+struct TraceRecord {
+    uint64_t id;            // Assigned by TraceBuffer::Record
+    RequestTimes times;
+    uint64_t pathHash;      // FNV-1a of the path, so traces do not carry names
+    uint64_t bytes;
+    int32_t callerPid;      // Process that issued the request
+    int32_t tid;            // FUSE thread that served it
+    int32_t error;          // Positive errno, 0 on success
+    uint16_t op;
+};
+
+// On-demand request tracing for one mount. While started, every request is
+// written to a fixed ring (oldest records are overwritten); Stop() turns
+// the retained records into Chrome trace-event JSON, which chrome://tracing,
+// Perfetto UI and speedscope load directly. Costs one relaxed load per
+// request while stopped.
+class TraceBuffer {
+public:
+    static const size_t kDefaultCapacity = 16384;
+
+    TraceBuffer();
+
+    bool Enabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // Start recording into a fresh ring of capacity records
+    void Start(size_t capacity);
+
+    // Stop recording and export what was kept
+    std::string Stop();
+
+    void Record(const TraceRecord& record);
+
+    size_t MemoryUsage() const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;  // Position + 1 once the record is complete
+        TraceRecord record;
+    };
+
+    void WaitForWriters();
+    std::string ExportChromeJson() const;
+
+    std::atomic<bool> enabled_;
+    std::atomic<int> writers_;     // Record() calls past the enabled check
+    std::atomic<uint64_t> next_;
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_;
+};
+
+uint64_t HashPath(const char *path);
+
+// Kernel thread id of the caller, cached per thread
+int32_t CurrentThreadId();
+
+#endif // FUSE3_TRACE_H
@@ -0,0 +1,204 @@
+#include "fuse3_watchdog.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "fuse3_log.h"
+
+// Request the calling FUSE thread has registered, nullptr if unwatched
+static thread_local InflightRequest *t_inflight = nullptr;
+
+static const uint64_t kMinIntervalNs = 10ULL * 1000 * 1000;
+static const uint64_t kMaxIntervalNs = 1000ULL * 1000 * 1000;
+
+RequestWatchdog::RequestWatchdog()
+    : intervalNs_(kMaxIntervalNs), enabled_(false), head_(nullptr), count_(0), running_(false) {
+    memset(thresholdNs_, 0, sizeof(thresholdNs_));
+}
+
+RequestWatchdog::~RequestWatchdog() {
+    Stop();
+}
+
+void RequestWatchdog::Configure(const uint64_t thresholdNs[kOpCount]) {
+    uint64_t smallest = 0;
+    enabled_ = false;
+    for (int op = 0; op < kOpCount; op++) {
+        thresholdNs_[op] = thresholdNs[op];
+        if (thresholdNs[op] > 0) {
+            enabled_ = true;
+            smallest = smallest ? std::min(smallest, thresholdNs[op]) : thresholdNs[op];
+        }
+    }
+
+    // Scan often enough to report a request within a quarter threshold of crossing it
+    intervalNs_ = std::min(std::max(smallest / 4, kMinIntervalNs), kMaxIntervalNs);
+}
+
+void RequestWatchdog::Start(Reporter reporter) {
+    if (!enabled_) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    reporter_ = reporter;
+    running_ = true;
+    thread_ = std::thread(&RequestWatchdog::Run, this);
+}
+
+void RequestWatchdog::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    wake_.notify_all();
+    thread_.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    reporter_ = nullptr;
+}
+
+void RequestWatchdog::Begin(InflightRequest *request) {
+    request->owner = this;
+    request->reported = false;
+    request->prev = nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    request->next = head_;
+    if (head_) {
+        head_->prev = request;
+    }
+    head_ = request;
+    count_++;
+    t_inflight = request;
+}
+
+void RequestWatchdog::End(InflightRequest *request, const RequestTimes& times) {
+    uint64_t now = MonotonicNs();
+    bool report = false;
+    SlowRequest slow;
+    Reporter reporter;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (request->prev) {
+            request->prev->next = request->next;
+        } else {
+            head_ = request->next;
+        }
+        if (request->next) {
+            request->next->prev = request->prev;
+        }
+        count_--;
+        t_inflight = nullptr;
+
+        // Finished over the threshold before a scan caught it
+        uint64_t threshold = thresholdNs_[request->op];
+        if (!request->reported && threshold > 0 && now - request->startNs >= threshold && reporter_) {
+            slow = Describe(request, now);
+            slow.stage = DominantStage(times, now);
+            slow.completed = true;
+            reporter = reporter_;
+            report = true;
+        }
+        request->call.reset();
+    }
+
+    if (report) {
+        FillComm(&slow);
+        reporter(slow);
+    }
+}
+
+void RequestWatchdog::SetCall(const std::shared_ptr<JsCallState>& call) {
+    InflightRequest *request = t_inflight;
+    if (!request) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(request->owner->mutex_);
+    request->call = call;
+}
+
+size_t RequestWatchdog::InflightCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+SlowRequest RequestWatchdog::Describe(const InflightRequest *request, uint64_t now) {
+    SlowRequest slow;
+    slow.op = request->op;
+    slow.path = request->path ? request->path : "";
+    slow.pid = request->pid;
+    slow.stage = request->call ? static_cast<RequestStage>(request->call->stage.load()) : kStageNative;
+    slow.elapsedNs = now - request->startNs;
+    slow.completed = false;
+    return slow;
+}
+
+void RequestWatchdog::FillComm(SlowRequest *slow) {
+    char procPath[64];
+    snprintf(procPath, sizeof(procPath), "/proc/%d/comm", static_cast<int>(slow->pid));
+
+    FILE *file = fopen(procPath, "r");
+    if (!file) {
+        return;
+    }
+    char comm[64] = "";
+    if (fgets(comm, sizeof(comm), file)) {
+        comm[strcspn(comm, "\n")] = '\0';
+        slow->comm = comm;
+    }
+    fclose(file);
+}
+
+void RequestWatchdog::Scan() {
+    std::vector<SlowRequest> found;
+    Reporter reporter;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t now = MonotonicNs();  // Under the lock, so no request started after it
+        for (InflightRequest *request = head_; request; request = request->next) {
+            uint64_t threshold = thresholdNs_[request->op];
+            if (request->reported || threshold == 0 || now - request->startNs < threshold) {
+                continue;
+            }
+            request->reported = true;
+            found.push_back(Describe(request, now));
+        }
+        reporter = reporter_;
+    }
+
+    for (SlowRequest& slow : found) {
+        FillComm(&slow);
+        LOG_WARN(kLogOps, "slow %s %s: %llu ms in %s (pid %d %s)", OpName(slow.op), slow.path.c_str(),
+                 static_cast<unsigned long long>(slow.elapsedNs / 1000000), StageName(slow.stage),
+                 static_cast<int>(slow.pid), slow.comm.c_str());
+        if (reporter) {
+            reporter(slow);
+        }
+    }
+}
+
+void RequestWatchdog::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        wake_.wait_for(lock, std::chrono::nanoseconds(intervalNs_));
+        if (!running_) {
+            break;
+        }
+        lock.unlock();
+        Scan();
+        lock.lock();
+    }
+}
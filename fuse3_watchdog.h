@@ -0,0 +1,98 @@
+#ifndef FUSE3_WATCHDOG_H
+#define FUSE3_WATCHDOG_H
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "fuse3_stats.h"
+
+// Progress of one JS round trip, readable from the watchdog thread
+struct JsCallState {
+    std::atomic<int> stage{kStageQueue};  // kStageQueue, then kStageJs, then kStageWake
+    uint64_t jsStartNs = 0;     // Written on the JS thread before the result is set
+    uint64_t jsCallbackNs = 0;
+};
+
+class RequestWatchdog;
+
+// A request being served, on the serving FUSE thread's stack while registered
+struct InflightRequest {
+    RequestWatchdog *owner;
+    FuseOp op;
+    const char *path;       // Owned by libfuse, valid while registered
+    pid_t pid;
+    uint64_t startNs;
+    std::shared_ptr<JsCallState> call;  // Current JS round trip, if any
+    bool reported;
+    InflightRequest *prev;
+    InflightRequest *next;
+};
+
+// What the watchdog reports about a request over its threshold
+struct SlowRequest {
+    FuseOp op;
+    std::string path;
+    pid_t pid;
+    std::string comm;       // Process name of pid, empty if it already exited
+    RequestStage stage;     // Where it is stuck; for completed requests where most time went
+    uint64_t elapsedNs;
+    bool completed;         // Reported at completion rather than while in flight
+};
+
+// Finds requests running longer than a per-operation threshold. Requests
+// register for their lifetime; a background thread scans them and reports
+// each slow request once while it is still in flight. Requests that finish
+// over the threshold between scans are reported on completion. With no
+// thresholds configured nothing registers and the cost is one branch.
+class RequestWatchdog {
+public:
+    typedef std::function<void(const SlowRequest&)> Reporter;
+
+    RequestWatchdog();
+    ~RequestWatchdog();
+
+    // Thresholds in ns per operation, 0 to leave an operation unwatched
+    void Configure(const uint64_t thresholdNs[kOpCount]);
+
+    bool Enabled() const {
+        return enabled_;
+    }
+
+    void Start(Reporter reporter);
+    void Stop();
+
+    void Begin(InflightRequest *request);
+    void End(InflightRequest *request, const RequestTimes& times);
+
+    // Attach the calling FUSE thread's current JS round trip to its request
+    static void SetCall(const std::shared_ptr<JsCallState>& call);
+
+    size_t InflightCount();
+
+private:
+    void Run();
+    void Scan();
+    static SlowRequest Describe(const InflightRequest *request, uint64_t now);
+    static void FillComm(SlowRequest *slow);
+
+    uint64_t thresholdNs_[kOpCount];
+    uint64_t intervalNs_;
+    bool enabled_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    InflightRequest *head_;
+    size_t count_;
+    bool running_;
+    Reporter reporter_;
+    std::thread thread_;
+};
+
+#endif // FUSE3_WATCHDOG_H
@@ -2,8 +2,6 @@
  * JavaScript interface for FUSE3 N-API addon
  */
 
-console.log('[index.js] MODULE LOADING');
-
 import { createRequire } from 'module';
 import { fileURLToPath } from 'url';
 import { dirname } from 'path';
@@ -67,6 +65,7 @@ export const ENOSPC = fuse3_napi.ENOSPC;
 export const EROFS = fuse3_napi.EROFS;
 export const EBUSY = fuse3_napi.EBUSY;
 export const ENOTEMPTY = fuse3_napi.ENOTEMPTY;
+export const EOPNOTSUPP = fuse3_napi.EOPNOTSUPP;
 
 /**
  * FUSE3 class - JavaScript wrapper around N-API addon
@@ -91,11 +90,10 @@ class Fuse extends EventEmitter {
         // Wrap operations to handle errors properly
         this._wrappedOps = this._wrapOperations(operations);
 
-        console.log('[Fuse constructor] Wrapped operations:', Object.keys(this._wrappedOps));
-        console.log('[Fuse constructor] wrapped.open type:', typeof this._wrappedOps.open);
-
         // Create native FUSE instance
-        this._fuse = new fuse3_napi.Fuse3(this.mountPath, this._wrappedOps);
+        // Native events (e.g. 'slow' from options.slowThresholds) are emitted on this instance
+        const nativeOptions = { ...options, onEvent: (type, info) => this.emit(type, info) };
+        this._fuse = new fuse3_napi.Fuse3(this.mountPath, this._wrappedOps, nativeOptions);
     }
     
     /**
@@ -103,6 +101,7 @@ class Fuse extends EventEmitter {
      */
     _wrapOperations(ops) {
         const wrapped = {};
+        const debug = !!this.options.debug;
         
         // Helper to convert error codes
         const errnoToCode = (errno) => {
@@ -172,21 +171,17 @@ class Fuse extends EventEmitter {
 
         if (ops.open) {
             wrapped.open = (path, flags, cb) => {
-                console.log('[index.js wrapped.open] called with args:', {
-                    path,
-                    flags_type: typeof flags,
-                    flags_value: flags,
-                    cb_type: typeof cb,
-                    num_args: arguments.length
-                });
-                console.trace('[index.js wrapped.open] Call stack:');
                 try {
-                    ops.open(path, flags, (err, fd) => {
-                        console.log('[index.js wrapped.open] callback: err=', err, 'fd=', fd);
-                        cb(errnoToCode(err ? (err.errno || err) : 0), fd || 0);
+                    ops.open(path, flags, (err, fd, handleOptions) => {
+                        // handleOptions.stagingFd: an fd JS keeps open for this handle.
+                        // With options.splice, write data is spliced into it natively.
+                        const stagingFd = handleOptions && typeof handleOptions.stagingFd === 'number'
+                            ? handleOptions.stagingFd
+                            : -1;
+                        cb(errnoToCode(err ? (err.errno || err) : 0), fd || 0, stagingFd);
                     });
                 } catch (e) {
-                    console.log('[index.js wrapped.open] exception:', e);
+                    if (debug) console.error('[fuse3] open handler threw:', e);
                     cb(errnoToCode(e.errno || EIO), 0);
                 }
             };
@@ -224,9 +219,36 @@ class Fuse extends EventEmitter {
             };
         }
 
+        if (ops.writeStaged) {
+            // Notification only: data for [offset, offset + length) is already in the staging fd
+            wrapped.writeStaged = (path, fd, offset, length) => {
+                try {
+                    ops.writeStaged(path, fd, offset, length);
+                } catch (e) {
+                    console.error('[index.js] writeStaged handler threw:', e);
+                }
+            };
+        }
+
+        if (ops.copyRange) {
+            wrapped.copyRange = (pathIn, fdIn, offsetIn, pathOut, fdOut, offsetOut, length, flags, cb) => {
+                try {
+                    // Node.js style: callback(err, bytesCopied). A copy that only needs to
+                    // reference existing content can be answered without moving any data.
+                    ops.copyRange(pathIn, fdIn, offsetIn, pathOut, fdOut, offsetOut, length, flags, (err, bytesCopied) => {
+                        cb(errnoToCode(err ? (err.errno || err) : 0) || bytesCopied || 0);
+                    });
+                } catch (e) {
+                    cb(errnoToCode(e.errno || EIO));
+                }
+            };
+        }
+
         // Add more operation wrappers as needed
+        // Called with the operation's arguments followed by cb, e.g. truncate(path, size, cb),
+        // rename(from, to, cb), chown(path, uid, gid, cb), utimens(path, atime, mtime, cb)
         const simpleOps = ['create', 'unlink', 'mkdir', 'rmdir', 'rename', 'chmod',
-                          'chown', 'truncate', 'release', 'fsync', 'flush'];
+                          'chown', 'truncate', 'utimens', 'access', 'release', 'fsync', 'flush'];
 
         for (const op of simpleOps) {
             if (ops[op]) {
@@ -302,6 +324,98 @@ class Fuse extends EventEmitter {
     isMounted() {
         return this._fuse.isMounted();
     }
+
+    /**
+     * Per-operation statistics since mount (or the last resetStats()).
+     * Returns { ops: { [op]: { count, errors, bytes, jsCalls, meanUs, p50Us, p90Us,
+     * p99Us, p999Us, maxUs, errnos } } } with latencies in microseconds.
+     */
+    getStats() {
+        return this._fuse.getStats();
+    }
+
+    /**
+     * Clear the counters returned by getStats()
+     */
+    resetStats() {
+        this._fuse.resetStats();
+    }
+
+    /**
+     * Hottest paths, parent directories and calling processes since mount
+     * (or resetHotPaths()), ranked by request count and by bytes. Each entry
+     * is { path, count, bytes, ops } ({ pid, ... } under pids) where
+     * count/bytes are count-min estimates and ops counts requests per
+     * operation since the entry entered the list.
+     */
+    getHotPaths() {
+        return this._fuse.getHotPaths();
+    }
+
+    resetHotPaths() {
+        this._fuse.resetHotPaths();
+    }
+
+    /**
+     * Start recording every request (op, path hash, caller pid, stage
+     * timestamps, bytes, errno) into a native ring of `capacity` entries.
+     * The oldest entries are overwritten when it is full.
+     */
+    startTrace({ capacity } = {}) {
+        this._fuse.startTrace(capacity || 0);
+    }
+
+    /**
+     * Stop tracing and return the trace as Chrome trace-event JSON, loadable
+     * in chrome://tracing or ui.perfetto.dev. With a file path the JSON is
+     * written there instead and the path is returned.
+     */
+    stopTrace(filePath) {
+        const json = this._fuse.stopTrace();
+        if (filePath) {
+            fs.writeFileSync(filePath, json);
+            return filePath;
+        }
+        return json;
+    }
+
+    /**
+     * Write every request (op, path, offset, size, timing, caller pid,
+     * result) to a compact binary file until stopRecording(). With
+     * hashPaths, each path component is replaced by a hash keyed per
+     * recording, so names cannot be recovered from the file. Replay the
+     * file against a mount with tools/fuse3replay.
+     */
+    startRecording(filePath, { hashPaths = false } = {}) {
+        this._fuse.startRecording(path.resolve(filePath), hashPaths);
+    }
+
+    /**
+     * Stop recording; returns { records, bytes } written and the records
+     * dropped because the ring was full
+     */
+    stopRecording() {
+        return this._fuse.stopRecording();
+    }
+
+    /**
+     * Benchmark request dispatch without a kernel mount. `threads` native
+     * threads call the FUSE operations directly, as libfuse workers would,
+     * cycling through `ops` for `durationMs`. Resolves with { elapsedMs,
+     * ops: { [op]: { count, errors, opsPerSec, meanUs, p50Us, ..., maxUs } } }.
+     * Requests also land in getStats(). Only on an instance that is not mounted.
+     */
+    benchDispatch({ threads = 4, durationMs = 1000, ops = ['getattr'], path = '/bench', size = 4096 } = {}) {
+        return new Promise((resolve, reject) => {
+            this._fuse.benchDispatch({ threads, durationMs, ops, path, size }, (err, result) => {
+                if (err) {
+                    reject(new Error(err));
+                } else {
+                    resolve(result);
+                }
+            });
+        });
+    }
     
     /**
      * Static unmount method
@@ -323,6 +437,35 @@ class Fuse extends EventEmitter {
         });
     }
     
+    /**
+     * Set the native log level ('trace', 'debug', 'info', 'warn', 'error',
+     * 'off'), for one subsystem ('core', 'ops', 'data') or all of them.
+     * Levels are process-wide; FUSE3_LOG=ops=debug sets them at load time.
+     */
+    static setLogLevel(level, subsystem) {
+        if (subsystem === undefined) {
+            fuse3_napi.setLogLevel(level);
+        } else {
+            fuse3_napi.setLogLevel(level, subsystem);
+        }
+    }
+
+    /**
+     * C heap of the whole process from malloc: { arenaBytes, mmapBytes,
+     * inUseBytes, freeBytes }; empty where the C library does not report it
+     */
+    static allocatorStats() {
+        return fuse3_napi.allocatorStats();
+    }
+
+    /**
+     * Whether the addon was built with -Dfuse3_alloc_stats=1, so getStats()
+     * reports allocations per operation
+     */
+    static get allocationStatsEnabled() {
+        return fuse3_napi.allocationStats;
+    }
+
     /**
      * Configure FUSE (no-op for Linux)
      */
@@ -0,0 +1,108 @@
+#!/usr/bin/env node
+
+/**
+ * Allocation Counting Test for FUSE3
+ * Needs a build with allocation counting (node-gyp rebuild -- -Dfuse3_alloc_stats=1).
+ * Runs the dispatch benchmark per operation and checks that every request
+ * is charged the same non-zero number of allocations and JS values.
+ */
+
+import Fuse from './index.js';
+
+const OPS = ['getattr', 'access', 'readdir', 'open', 'read', 'write'];
+const SIZE = 4096;
+const DURATION_MS = 200;
+
+const now = Date.now();
+const handlers = {
+  getattr: (path, cb) => cb(null, { mode: 0o100644, size: 1 << 20, mtime: now, atime: now, ctime: now }),
+  access: (path, mode, cb) => cb(null),
+  readdir: (path, cb) => cb(null, ['a', 'b', 'c']),
+  open: (path, flags, cb) => cb(null, 3),
+  read: (path, fd, buffer, length, offset, cb) => cb(null, length),
+  write: (path, fd, buffer, length, offset, cb) => cb(null, length),
+  release: (path, fd, cb) => cb(null)
+};
+
+// Test state
+let testsPassed = 0;
+let testsFailed = 0;
+
+// Test assertion
+function assert(condition, message) {
+  if (!condition) {
+    throw new Error(`Assertion failed: ${message}`);
+  }
+}
+
+async function test(name, fn) {
+  try {
+    await fn();
+    console.log(`✓ ${name}`);
+    testsPassed++;
+  } catch (err) {
+    console.error(`✗ ${name}`);
+    console.error(`  ${err.message}`);
+    testsFailed++;
+  }
+}
+
+// Counts per request of one benchmark run of op
+async function measure(fuse, op) {
+  fuse.resetStats();
+  await fuse.benchDispatch({ threads: 1, durationMs: DURATION_MS, ops: [op], size: SIZE });
+  const stats = fuse.getStats().ops[op];
+  assert(stats && stats.count > 0, `no ${op} requests recorded`);
+  return {
+    count: stats.allocations.count / stats.count,
+    bytes: stats.allocations.bytes / stats.count,
+    jsValues: stats.allocations.jsValues / stats.count,
+    jsBytes: stats.allocations.jsBytes / stats.count
+  };
+}
+
+// Main test suite
+async function runTests() {
+  console.log('Starting FUSE3 Allocation Counting Tests...\n');
+
+  if (!Fuse.allocationStatsEnabled) {
+    console.log('Skipped: the addon was built without -Dfuse3_alloc_stats=1');
+    process.exit(0);
+  }
+
+  const fuse = new Fuse('/nonexistent/fuse3-alloc-test', handlers);
+
+  for (const op of OPS) {
+    await test(`${op}: non-zero counts, stable across runs`, async () => {
+      await measure(fuse, op);  // warm up one-time allocations
+      const first = await measure(fuse, op);
+      const second = await measure(fuse, op);
+
+      assert(first.count > 0, `${op} made no allocations`);
+      assert(first.jsValues > 0, `${op} created no JS values`);
+      // The same values are created for every request
+      assert(Number.isInteger(first.jsValues) && first.jsValues === second.jsValues,
+             `jsValues per request ${first.jsValues} then ${second.jsValues}`);
+      assert(Math.abs(first.count - second.count) <= Math.max(1, first.count * 0.1),
+             `allocations per request ${first.count.toFixed(2)} then ${second.count.toFixed(2)}`);
+      assert(Math.abs(first.bytes - second.bytes) <= Math.max(64, first.bytes * 0.1),
+             `bytes per request ${first.bytes.toFixed(1)} then ${second.bytes.toFixed(1)}`);
+
+      // Only read and write hand a Buffer to their handler
+      const expectedJsBytes = op === 'read' || op === 'write' ? SIZE : 0;
+      assert(first.jsBytes === expectedJsBytes && second.jsBytes === expectedJsBytes,
+             `jsBytes per request ${first.jsBytes} then ${second.jsBytes}, expected ${expectedJsBytes}`);
+    });
+  }
+
+  // Summary
+  console.log(`\n${'='.repeat(50)}`);
+  console.log(`Tests passed: ${testsPassed}`);
+  console.log(`Tests failed: ${testsFailed}`);
+  console.log(`Total: ${testsPassed + testsFailed}`);
+  console.log('='.repeat(50));
+
+  process.exit(testsFailed > 0 ? 1 : 0);
+}
+
+runTests();
@@ -0,0 +1,357 @@
+#!/usr/bin/env node
+
+/**
+ * Writeback Operations Test Suite for FUSE3
+ * With options.writeback, writes are buffered natively and committed to JS on
+ * flush, fsync or release. Covers read-your-writes across handles, commit on
+ * close, retrying a failed commit, and cp inside the mount through copyRange.
+ */
+
+import fs from 'fs';
+import path from 'path';
+import { fileURLToPath } from 'url';
+import { dirname } from 'path';
+import { exec } from 'child_process';
+import { promisify } from 'util';
+import Fuse, { ENOENT, EEXIST, EACCES, EIO } from './index.js';
+
+const execAsync = promisify(exec);
+
+const __filename = fileURLToPath(import.meta.url);
+const __dirname = dirname(__filename);
+
+const TMP_DIR = path.join(__dirname, '.tmp');
+const MOUNT_POINT = path.join(TMP_DIR, 'fuse-writeback-ops-test');
+const OLD_CONTENT = 'OLDCONTENTS-OLDCONTENTS\n';
+const COPY_SIZE = 256 * 1024;
+const COPY_CHUNK = 16 * 1024;
+
+/**
+ * Writable in-memory files, served through the plain Fuse API.
+ * Remembers which descriptors were opened for writing so a commit through a
+ * read-only handle is refused, and can fail the next writes on request.
+ */
+class InMemoryFileSystem {
+  constructor() {
+    this.files = new Map();
+    this.fds = new Map();
+    this.nextFd = 1;
+    this.writes = [];
+    this.failWrites = 0;
+    this.copyCalls = 0;
+    this.copyDelayMs = 0;
+    this.mtime = Date.now();
+  }
+
+  add(name, content) {
+    this.files.set(`/${name}`, { content: Buffer.from(content), mtime: Date.now() });
+  }
+
+  content(name) {
+    return this.files.get(`/${name}`).content;
+  }
+
+  handlers() {
+    return {
+      getattr: (p, cb) => {
+        const file = this.files.get(p);
+        if (p === '/') {
+          cb(null, { mode: 0o040755, size: 0, mtime: this.mtime, atime: this.mtime, ctime: this.mtime });
+        } else if (file) {
+          cb(null, { mode: 0o100644, size: file.content.length, mtime: file.mtime, atime: file.mtime, ctime: file.mtime });
+        } else {
+          cb(ENOENT);
+        }
+      },
+      readdir: (p, cb) => cb(p === '/' ? null : ENOENT, [...this.files.keys()].map(name => name.slice(1))),
+      open: (p, flags, cb) => {
+        if (!this.files.has(p)) {
+          cb(ENOENT);
+          return;
+        }
+        const fd = this.nextFd++;
+        this.fds.set(fd, { path: p, writable: (flags & fs.constants.O_ACCMODE) !== fs.constants.O_RDONLY });
+        cb(null, fd);
+      },
+      create: (p, mode, cb) => {
+        if (this.files.has(p)) {
+          cb(EEXIST);
+          return;
+        }
+        this.files.set(p, { content: Buffer.alloc(0), mtime: Date.now() });
+        cb(null);
+      },
+      read: (p, fd, buffer, length, offset, cb) => {
+        const content = this.files.get(p).content;
+        const end = Math.min(content.length, offset + length);
+        const bytesRead = Math.max(0, end - offset);
+        content.copy(buffer, 0, offset, offset + bytesRead);
+        cb(null, bytesRead);
+      },
+      write: (p, fd, buffer, length, offset, cb) => {
+        // Created files are committed through descriptor 0
+        if (fd !== 0 && !(this.fds.get(fd) && this.fds.get(fd).writable)) {
+          cb(EACCES);
+          return;
+        }
+        if (this.failWrites > 0) {
+          this.failWrites--;
+          cb(EIO);
+          return;
+        }
+        const file = this.files.get(p);
+        const end = offset + length;
+        if (end > file.content.length) {
+          file.content = Buffer.concat([file.content, Buffer.alloc(end - file.content.length)]);
+        }
+        buffer.copy(file.content, offset, 0, length);
+        file.mtime = Date.now();
+        this.writes.push({ path: p, fd, offset, length });
+        cb(null, length);
+      },
+      truncate: (p, size, cb) => {
+        const file = this.files.get(p);
+        const resized = Buffer.alloc(size);
+        file.content.copy(resized, 0, 0, Math.min(size, file.content.length));
+        file.content = resized;
+        cb(null);
+      },
+      copyRange: (pathIn, fdIn, offsetIn, pathOut, fdOut, offsetOut, length, flags, cb) => {
+        this.copyCalls++;
+        // Copy one chunk per call, slowly, so cp keeps the destination open
+        setTimeout(() => {
+          const source = this.files.get(pathIn).content;
+          const dest = this.files.get(pathOut);
+          const copied = Math.max(0, Math.min(length, COPY_CHUNK, source.length - offsetIn));
+          const end = offsetOut + copied;
+          if (end > dest.content.length) {
+            dest.content = Buffer.concat([dest.content, Buffer.alloc(end - dest.content.length)]);
+          }
+          source.copy(dest.content, offsetOut, offsetIn, offsetIn + copied);
+          dest.mtime = Date.now();
+          cb(null, copied);
+        }, this.copyDelayMs);
+      },
+      chmod: (p, mode, cb) => cb(this.files.has(p) ? null : ENOENT),
+      fsync: (p, datasync, fd, cb) => cb(null),
+      flush: (p, fd, cb) => cb(null),
+      release: (p, fd, cb) => {
+        this.fds.delete(fd);
+        cb(null);
+      }
+    };
+  }
+}
+
+// Test state
+let fuse = null;
+let fsImpl = null;
+let testsPassed = 0;
+let testsFailed = 0;
+
+// Cleanup function
+async function cleanup() {
+  try {
+    await execAsync(`fusermount3 -uz "${MOUNT_POINT}" 2>/dev/null || fusermount -uz "${MOUNT_POINT}" 2>/dev/null || true`);
+    await new Promise(resolve => setTimeout(resolve, 500));
+  } catch (e) {
+    // Ignore
+  }
+
+  try {
+    await execAsync(`rm -rf "${TMP_DIR}" 2>/dev/null || true`);
+  } catch (e) {
+    // Ignore
+  }
+}
+
+// Test assertion
+function assert(condition, message) {
+  if (!condition) {
+    throw new Error(`Assertion failed: ${message}`);
+  }
+}
+
+async function test(name, fn) {
+  try {
+    await fn();
+    console.log(`✓ ${name}`);
+    testsPassed++;
+  } catch (err) {
+    console.error(`✗ ${name}`);
+    console.error(`  ${err.message}`);
+    testsFailed++;
+  }
+}
+
+function show(buffer) {
+  return JSON.stringify(buffer.toString('latin1'));
+}
+
+// Main test suite
+async function runTests() {
+  console.log('Starting FUSE3 Writeback Operations Tests...\n');
+
+  try {
+    await cleanup();
+    fs.mkdirSync(MOUNT_POINT, { recursive: true });
+
+    fsImpl = new InMemoryFileSystem();
+    fuse = new Fuse(MOUNT_POINT, fsImpl.handlers(), { writeback: true });
+    await new Promise((resolve, reject) => fuse.mount(err => (err ? reject(err) : resolve())));
+    await new Promise(resolve => setTimeout(resolve, 200));
+
+    // Asynchronous fs only: the event loop has to keep serving the mount
+
+    await test('a second handle reads writes that are not committed yet', async () => {
+      fsImpl.add('shared.txt', OLD_CONTENT);
+      const filePath = path.join(MOUNT_POINT, 'shared.txt');
+      const writer = await fs.promises.open(filePath, 'r+');
+      const reader = await fs.promises.open(filePath, 'r');
+      const expected = Buffer.from('hello' + OLD_CONTENT.slice(5));
+      try {
+        await writer.write(Buffer.from('hello'), 0, 5, 0);
+        assert(fsImpl.content('shared.txt').equals(Buffer.from(OLD_CONTENT)),
+               `JS has ${show(fsImpl.content('shared.txt'))} before any commit`);
+
+        const buffer = Buffer.alloc(64);
+        const { bytesRead } = await reader.read(buffer, 0, buffer.length, 0);
+        assert(buffer.subarray(0, bytesRead).equals(expected),
+               `reader got ${show(buffer.subarray(0, bytesRead))}`);
+      } finally {
+        // The reader's close may commit, but only through the writer's descriptor
+        await reader.close();
+        await writer.close();
+      }
+
+      assert(fsImpl.content('shared.txt').equals(expected), `JS has ${show(fsImpl.content('shared.txt'))}`);
+      const writes = fsImpl.writes.filter(w => w.path === '/shared.txt');
+      assert(writes.length > 0, 'nothing was committed');
+    });
+
+    await test('buffered writes are committed on close', async () => {
+      fsImpl.add('close.txt', OLD_CONTENT);
+      const filePath = path.join(MOUNT_POINT, 'close.txt');
+      const data = Buffer.from('committed on close, past the old end of the file\n');
+
+      const handle = await fs.promises.open(filePath, 'r+');
+      try {
+        await handle.write(data, 0, data.length, 0);
+        assert(fsImpl.content('close.txt').equals(Buffer.from(OLD_CONTENT)),
+               `JS has ${show(fsImpl.content('close.txt'))} before close`);
+        const stat = await handle.stat();
+        assert(stat.size === data.length, `size ${stat.size} before close, expected ${data.length}`);
+      } finally {
+        await handle.close();
+      }
+
+      assert(fsImpl.content('close.txt').equals(data), `JS has ${show(fsImpl.content('close.txt'))} after close`);
+      const stat = await fs.promises.stat(filePath);
+      assert(stat.size === data.length, `size ${stat.size} after close, expected ${data.length}`);
+    });
+
+    await test('a failed commit keeps the data and is retried', async () => {
+      fsImpl.add('retry.txt', OLD_CONTENT);
+      const filePath = path.join(MOUNT_POINT, 'retry.txt');
+      const expected = Buffer.from('retry' + OLD_CONTENT.slice(5));
+
+      const handle = await fs.promises.open(filePath, 'r+');
+      try {
+        await handle.write(Buffer.from('retry'), 0, 5, 0);
+
+        fsImpl.failWrites = 1;
+        let failure = null;
+        try {
+          await handle.sync();
+        } catch (err) {
+          failure = err;
+        }
+        assert(failure && failure.code === 'EIO', `first fsync gave ${failure ? failure.code : 'no error'}, expected EIO`);
+        assert(fsImpl.content('retry.txt').equals(Buffer.from(OLD_CONTENT)),
+               `JS has ${show(fsImpl.content('retry.txt'))} after the failed commit`);
+
+        // The data is still buffered and still visible
+        const buffer = Buffer.alloc(64);
+        const { bytesRead } = await handle.read(buffer, 0, buffer.length, 0);
+        assert(buffer.subarray(0, bytesRead).equals(expected), `read ${show(buffer.subarray(0, bytesRead))}`);
+
+        await handle.sync();
+        assert(fsImpl.content('retry.txt').equals(expected),
+               `JS has ${show(fsImpl.content('retry.txt'))} after the retry`);
+      } finally {
+        fsImpl.failWrites = 0;
+        await handle.close();
+      }
+    });
+
+    await test('cp inside the mount copies through copyRange', async () => {
+      const source = Buffer.alloc(COPY_SIZE);
+      for (let i = 0; i < source.length; i++) {
+        source[i] = i % 251;
+      }
+      fsImpl.add('source.bin', source);
+      fsImpl.copyCalls = 0;
+
+      await execAsync(`cp "${path.join(MOUNT_POINT, 'source.bin')}" "${path.join(MOUNT_POINT, 'copy.bin')}"`);
+
+      assert(fsImpl.copyCalls > 0, 'cp did not use copy_file_range (needs coreutils 9 or later)');
+      assert(fsImpl.content('copy.bin').equals(source), 'JS copy differs from the source');
+      const content = await fs.promises.readFile(path.join(MOUNT_POINT, 'copy.bin'));
+      assert(content.equals(source), 'copy read through the mount differs from the source');
+      const stat = await fs.promises.stat(path.join(MOUNT_POINT, 'copy.bin'));
+      assert(stat.size === COPY_SIZE, `size ${stat.size}, expected ${COPY_SIZE}`);
+    });
+
+    await test('stat of a file while it is being copied never lags the copy', async () => {
+      const destPath = path.join(MOUNT_POINT, 'slow-copy.bin');
+      fsImpl.copyDelayMs = 50;
+      let done = false;
+      const copy = execAsync(`cp "${path.join(MOUNT_POINT, 'source.bin')}" "${destPath}"`)
+        .finally(() => { done = true; });
+
+      try {
+        let checked = 0;
+        while (!done) {
+          const dest = fsImpl.files.get('/slow-copy.bin');
+          const copied = dest ? dest.content.length : 0;
+          try {
+            const stat = await fs.promises.stat(destPath);
+            assert(stat.size >= copied, `stat gave size ${stat.size} after ${copied} bytes were copied`);
+            assert(stat.size <= COPY_SIZE, `stat gave size ${stat.size}, larger than the source`);
+            checked++;
+          } catch (err) {
+            if (err.code !== 'ENOENT') {
+              throw err;
+            }
+          }
+          await new Promise(resolve => setTimeout(resolve, 10));
+        }
+        await copy;
+        assert(checked > 0, 'the copy finished before it could be observed');
+      } finally {
+        fsImpl.copyDelayMs = 0;
+        await copy.catch(() => {});
+      }
+
+      const stat = await fs.promises.stat(destPath);
+      assert(stat.size === COPY_SIZE, `size ${stat.size} after the copy, expected ${COPY_SIZE}`);
+    });
+
+    // Summary
+    console.log(`\n${'='.repeat(50)}`);
+    console.log(`Tests passed: ${testsPassed}`);
+    console.log(`Tests failed: ${testsFailed}`);
+    console.log(`Total: ${testsPassed + testsFailed}`);
+    console.log('='.repeat(50));
+
+  } finally {
+    if (fuse && fuse.mounted) {
+      await new Promise(resolve => fuse.unmount(() => resolve()));
+    }
+    await cleanup();
+  }
+
+  process.exit(testsFailed > 0 ? 1 : 0);
+}
+
+runTests();
@@ -0,0 +1,195 @@
+#!/usr/bin/env node
+
+/**
+ * Writeback Truncate Regression Test for FUSE3
+ * With options.writeback an ftruncate of an open file is kept natively until
+ * the next commit. Bytes between the smallest truncated size and the current
+ * size must read as zeros meanwhile, not as the file's old contents from JS.
+ */
+
+import fs from 'fs';
+import path from 'path';
+import { fileURLToPath } from 'url';
+import { dirname } from 'path';
+import { exec } from 'child_process';
+import { promisify } from 'util';
+import Fuse, { ENOENT } from './index.js';
+
+const execAsync = promisify(exec);
+
+const __filename = fileURLToPath(import.meta.url);
+const __dirname = dirname(__filename);
+
+const TMP_DIR = path.join(__dirname, '.tmp');
+const MOUNT_POINT = path.join(TMP_DIR, 'fuse-writeback-test');
+const OLD_CONTENT = 'OLDCONTENTS-OLDCONTENTS\n';
+
+/**
+ * One writable in-memory file, served through the plain Fuse API
+ */
+class InMemoryFile {
+  constructor(content) {
+    this.content = Buffer.from(content);
+    this.mtime = Date.now();
+  }
+
+  handlers() {
+    return {
+      getattr: (p, cb) => {
+        if (p === '/') {
+          cb(null, { mode: 0o040755, size: 0, mtime: this.mtime, atime: this.mtime, ctime: this.mtime });
+        } else if (p === '/data.txt') {
+          cb(null, { mode: 0o100644, size: this.content.length, mtime: this.mtime, atime: this.mtime, ctime: this.mtime });
+        } else {
+          cb(ENOENT);
+        }
+      },
+      readdir: (p, cb) => cb(p === '/' ? null : ENOENT, ['data.txt']),
+      open: (p, flags, cb) => cb(p === '/data.txt' ? null : ENOENT, 1),
+      read: (p, fd, buffer, length, offset, cb) => {
+        const end = Math.min(this.content.length, offset + length);
+        const bytesRead = Math.max(0, end - offset);
+        this.content.copy(buffer, 0, offset, offset + bytesRead);
+        cb(null, bytesRead);
+      },
+      write: (p, fd, buffer, length, offset, cb) => {
+        const end = offset + length;
+        if (end > this.content.length) {
+          this.content = Buffer.concat([this.content, Buffer.alloc(end - this.content.length)]);
+        }
+        buffer.copy(this.content, offset, 0, length);
+        cb(null, length);
+      },
+      truncate: (p, size, cb) => {
+        const resized = Buffer.alloc(size);
+        this.content.copy(resized, 0, 0, Math.min(size, this.content.length));
+        this.content = resized;
+        cb(null);
+      },
+      flush: (p, fd, cb) => cb(null),
+      release: (p, fd, cb) => cb(null)
+    };
+  }
+}
+
+// Test state
+let fuse = null;
+let file = null;
+let testsPassed = 0;
+let testsFailed = 0;
+
+// Cleanup function
+async function cleanup() {
+  try {
+    await execAsync(`fusermount3 -uz "${MOUNT_POINT}" 2>/dev/null || fusermount -uz "${MOUNT_POINT}" 2>/dev/null || true`);
+    await new Promise(resolve => setTimeout(resolve, 500));
+  } catch (e) {
+    // Ignore
+  }
+
+  try {
+    await execAsync(`rm -rf "${TMP_DIR}" 2>/dev/null || true`);
+  } catch (e) {
+    // Ignore
+  }
+}
+
+// Test assertion
+function assert(condition, message) {
+  if (!condition) {
+    throw new Error(`Assertion failed: ${message}`);
+  }
+}
+
+async function test(name, fn) {
+  try {
+    await fn();
+    console.log(`✓ ${name}`);
+    testsPassed++;
+  } catch (err) {
+    console.error(`✗ ${name}`);
+    console.error(`  ${err.message}`);
+    testsFailed++;
+  }
+}
+
+const EXPECTED = Buffer.concat([Buffer.from('abc'), Buffer.alloc(7)]);
+
+// Main test suite
+async function runTests() {
+  console.log('Starting FUSE3 Writeback Truncate Tests...\n');
+
+  try {
+    await cleanup();
+    fs.mkdirSync(MOUNT_POINT, { recursive: true });
+
+    file = new InMemoryFile(OLD_CONTENT);
+    fuse = new Fuse(MOUNT_POINT, file.handlers(), { writeback: true });
+    await new Promise((resolve, reject) => fuse.mount(err => (err ? reject(err) : resolve())));
+    await new Promise(resolve => setTimeout(resolve, 200));
+
+    // Asynchronous fs only: the event loop has to keep serving the mount
+    const filePath = path.join(MOUNT_POINT, 'data.txt');
+
+    await test('ftruncate(0), write, ftruncate(10) reads zeros past the write', async () => {
+      const handle = await fs.promises.open(filePath, 'r+');
+      try {
+        await handle.truncate(0);
+        await handle.write(Buffer.from('abc'), 0, 3, 0);
+        await handle.truncate(10);
+
+        const buffer = Buffer.alloc(32, 0xff);
+        const { bytesRead } = await handle.read(buffer, 0, buffer.length, 0);
+        assert(bytesRead === 10, `read ${bytesRead} bytes, expected 10`);
+        assert(buffer.subarray(0, 10).equals(EXPECTED),
+               `read ${JSON.stringify(buffer.subarray(0, 10).toString('latin1'))} before commit`);
+
+        const stat = await handle.stat();
+        assert(stat.size === 10, `size ${stat.size}, expected 10`);
+      } finally {
+        await handle.close();
+      }
+    });
+
+    await test('the committed file matches what was read before the commit', async () => {
+      assert(file.content.equals(EXPECTED), `JS has ${JSON.stringify(file.content.toString('latin1'))}`);
+
+      const content = await fs.promises.readFile(filePath);
+      assert(content.equals(EXPECTED), `read ${JSON.stringify(content.toString('latin1'))} after commit`);
+    });
+
+    await test('a truncate that only grows also reads zeros', async () => {
+      file.content = Buffer.from(OLD_CONTENT);
+      const handle = await fs.promises.open(filePath, 'r+');
+      try {
+        await handle.truncate(4);
+        await handle.truncate(12);
+
+        const buffer = Buffer.alloc(12, 0xff);
+        const { bytesRead } = await handle.read(buffer, 0, buffer.length, 0);
+        const expected = Buffer.concat([Buffer.from(OLD_CONTENT.slice(0, 4)), Buffer.alloc(8)]);
+        assert(bytesRead === 12, `read ${bytesRead} bytes, expected 12`);
+        assert(buffer.equals(expected), `read ${JSON.stringify(buffer.toString('latin1'))}`);
+      } finally {
+        await handle.close();
+      }
+    });
+
+    // Summary
+    console.log(`\n${'='.repeat(50)}`);
+    console.log(`Tests passed: ${testsPassed}`);
+    console.log(`Tests failed: ${testsFailed}`);
+    console.log(`Total: ${testsPassed + testsFailed}`);
+    console.log('='.repeat(50));
+
+  } finally {
+    if (fuse && fuse.mounted) {
+      await new Promise(resolve => fuse.unmount(() => resolve()));
+    }
+    await cleanup();
+  }
+
+  process.exit(testsFailed > 0 ? 1 : 0);
+}
+
+runTests();
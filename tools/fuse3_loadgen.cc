@@ -0,0 +1,594 @@
+// fuse3_loadgen: multi-threaded load generator for benchmarking a mount.
+//
+// Issues one kind of request from N threads against a synthetic tree of a
+// known shape (see bench/synthetic-tree.js) and prints one JSON object with
+// throughput and latency percentiles.
+//
+//   fuse3_loadgen -w workload [-t threads] [-d seconds] [-D depth] [-F fanout]
+//                 [-f files] [-b block] [-S size] [-s seed] mountpoint
+//
+// Tree: a directory at level L < depth holds subdirectories d0..d<fanout-1>;
+// every directory holds files f0..f<files-1>. Write workloads ignore the
+// shape and create files in a directory of their own per thread, w<thread>.
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../fuse3_stats.h"
+
+struct Config {
+    std::string workload;
+    std::string root;
+    int threads = 1;
+    double seconds = 5;
+    int depth = 2;
+    int fanout = 10;
+    int files = 100;
+    size_t block = 0;  // Bytes per read or write; 0 for the workload's default
+    uint64_t fileSize = 1ULL << 30;  // Bytes per file for stream
+    unsigned seed = 1;
+};
+
+// What one thread did
+struct ThreadResult {
+    Histogram latency;
+    uint64_t ops = 0;
+    uint64_t entries = 0;  // Directory entries seen (listing workloads)
+    uint64_t bytes = 0;    // Data read or written (data workloads)
+    uint64_t errors = 0;
+    Histogram commit;      // fsync/close/rename that make writes durable (write workloads)
+};
+
+struct Worker {
+    const Config *config;
+    std::mt19937_64 random;
+    ThreadResult *result;
+    int index;
+
+    uint64_t Pick(uint64_t n) {
+        return std::uniform_int_distribution<uint64_t>(0, n - 1)(random);
+    }
+
+    // Any directory of the tree, each equally likely
+    std::string RandomDir() {
+        uint64_t total = 0;
+        uint64_t perLevel = 1;
+        for (int level = 0; level <= config->depth; level++) {
+            total += perLevel;
+            perLevel *= static_cast<uint64_t>(config->fanout);
+        }
+
+        uint64_t index = Pick(total);
+        int level = 0;
+        perLevel = 1;
+        while (index >= perLevel) {
+            index -= perLevel;
+            perLevel *= static_cast<uint64_t>(config->fanout);
+            level++;
+        }
+
+        std::string path = config->root;
+        for (int i = 0; i < level; i++) {
+            path += "/d" + std::to_string(Pick(static_cast<uint64_t>(config->fanout)));
+        }
+        return path;
+    }
+
+    std::string RandomFile() {
+        return RandomDir() + "/f" + std::to_string(Pick(static_cast<uint64_t>(config->files)));
+    }
+
+    // Directory for this thread's files, created on first use
+    std::string WriteDir() {
+        std::string dir = config->root + "/w" + std::to_string(index);
+        mkdir(dir.c_str(), 0755);
+        return dir;
+    }
+
+    void Record(uint64_t startNs, bool ok) {
+        result->latency.Record(MonotonicNs() - startNs);
+        result->ops++;
+        if (!ok) {
+            result->errors++;
+        }
+    }
+
+    // readdir a whole directory; lstat every entry too for ls -l
+    bool List(const std::string& dir, bool statEntries, std::vector<std::string> *subdirs = nullptr) {
+        DIR *handle = opendir(dir.c_str());
+        if (!handle) {
+            return false;
+        }
+
+        bool ok = true;
+        struct dirent *entry;
+        while ((entry = readdir(handle)) != nullptr) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+            result->entries++;
+
+            std::string path = dir + "/" + entry->d_name;
+            bool isDir = entry->d_type == DT_DIR;
+            if (statEntries || entry->d_type == DT_UNKNOWN) {
+                struct stat st;
+                if (lstat(path.c_str(), &st) != 0) {
+                    ok = false;
+                    continue;
+                }
+                isDir = S_ISDIR(st.st_mode);
+            }
+            if (subdirs && isDir) {
+                subdirs->push_back(path);
+            }
+        }
+        closedir(handle);
+        return ok;
+    }
+};
+
+typedef void (*WorkloadFn)(Worker *worker, uint64_t deadlineNs);
+
+static void RunStat(Worker *worker, uint64_t deadlineNs) {
+    while (MonotonicNs() < deadlineNs) {
+        std::string path = worker->RandomFile();
+        struct stat st;
+        uint64_t start = MonotonicNs();
+        worker->Record(start, stat(path.c_str(), &st) == 0);
+    }
+}
+
+static void RunReaddir(Worker *worker, uint64_t deadlineNs) {
+    while (MonotonicNs() < deadlineNs) {
+        std::string dir = worker->RandomDir();
+        uint64_t start = MonotonicNs();
+        worker->Record(start, worker->List(dir, false));
+    }
+}
+
+static void RunListLong(Worker *worker, uint64_t deadlineNs) {
+    while (MonotonicNs() < deadlineNs) {
+        std::string dir = worker->RandomDir();
+        uint64_t start = MonotonicNs();
+        worker->Record(start, worker->List(dir, true));
+    }
+}
+
+// Directories still to be walked by find, shared by all threads
+struct FindQueue {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::string> pending;
+    int busy = 0;
+};
+
+static FindQueue g_find;
+
+// One pass over the whole tree like find(1); an op is one directory
+static void Find(Worker *worker, uint64_t deadlineNs, bool statEntries) {
+    for (;;) {
+        std::string dir;
+        {
+            std::unique_lock<std::mutex> lock(g_find.mutex);
+            g_find.changed.wait(lock, [] { return !g_find.pending.empty() || g_find.busy == 0; });
+            if (g_find.pending.empty() || MonotonicNs() >= deadlineNs) {
+                g_find.pending.clear();
+                g_find.changed.notify_all();
+                return;
+            }
+            dir = g_find.pending.back();
+            g_find.pending.pop_back();
+            g_find.busy++;
+        }
+
+        std::vector<std::string> subdirs;
+        uint64_t start = MonotonicNs();
+        worker->Record(start, worker->List(dir, statEntries, &subdirs));
+
+        std::lock_guard<std::mutex> lock(g_find.mutex);
+        g_find.pending.insert(g_find.pending.end(), subdirs.begin(), subdirs.end());
+        g_find.busy--;
+        g_find.changed.notify_all();
+    }
+}
+
+static void RunFind(Worker *worker, uint64_t deadlineNs) {
+    Find(worker, deadlineNs, false);
+}
+
+// find -ls: every entry is looked up, so the mount sees each one
+static void RunFindLong(Worker *worker, uint64_t deadlineNs) {
+    Find(worker, deadlineNs, true);
+}
+
+// Whole files front to back in blocks; an op is one read
+static void RunSequentialRead(Worker *worker, uint64_t deadlineNs) {
+    std::vector<char> buffer(worker->config->block);
+    while (MonotonicNs() < deadlineNs) {
+        int fd = open(worker->RandomFile().c_str(), O_RDONLY);
+        if (fd < 0) {
+            worker->Record(MonotonicNs(), false);
+            continue;
+        }
+        for (;;) {
+            uint64_t start = MonotonicNs();
+            ssize_t n = read(fd, buffer.data(), buffer.size());
+            if (n == 0) {
+                break;  // End of file
+            }
+            worker->Record(start, n > 0);
+            if (n < 0 || MonotonicNs() >= deadlineNs) {
+                break;
+            }
+            worker->result->bytes += static_cast<uint64_t>(n);
+        }
+        close(fd);
+    }
+}
+
+// Block-aligned preads at random offsets of one open file per thread
+static void RunRandomRead(Worker *worker, uint64_t deadlineNs) {
+    size_t block = worker->config->block;
+    std::vector<char> buffer(block);
+    int fd = open(worker->RandomFile().c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < block) {
+        worker->Record(MonotonicNs(), false);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+
+    uint64_t blocks = static_cast<uint64_t>(st.st_size) / block;
+    while (MonotonicNs() < deadlineNs) {
+        off_t offset = static_cast<off_t>(worker->Pick(blocks) * block);
+        uint64_t start = MonotonicNs();
+        ssize_t n = pread(fd, buffer.data(), block, offset);
+        worker->Record(start, n == static_cast<ssize_t>(block));
+        if (n > 0) {
+            worker->result->bytes += static_cast<uint64_t>(n);
+        }
+    }
+    close(fd);
+}
+
+// cat of a random file: open, read to the end, close
+static void RunSmallFiles(Worker *worker, uint64_t deadlineNs) {
+    std::vector<char> buffer(worker->config->block);
+    while (MonotonicNs() < deadlineNs) {
+        std::string path = worker->RandomFile();
+        uint64_t start = MonotonicNs();
+        int fd = open(path.c_str(), O_RDONLY);
+        bool ok = fd >= 0;
+        ssize_t n = 0;
+        while (ok && (n = read(fd, buffer.data(), buffer.size())) > 0) {
+            worker->result->bytes += static_cast<uint64_t>(n);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        worker->Record(start, ok && n == 0);
+    }
+}
+
+// Map a random file and touch every page; an op is one file
+static void RunMmap(Worker *worker, uint64_t deadlineNs) {
+    long pageSize = sysconf(_SC_PAGESIZE);
+    while (MonotonicNs() < deadlineNs) {
+        std::string path = worker->RandomFile();
+        uint64_t start = MonotonicNs();
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+            worker->Record(start, false);
+            if (fd >= 0) {
+                close(fd);
+            }
+            continue;
+        }
+
+        size_t size = static_cast<size_t>(st.st_size);
+        void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            worker->Record(start, false);
+            continue;
+        }
+
+        volatile unsigned char sum = 0;
+        const unsigned char *bytes = static_cast<const unsigned char*>(map);
+        for (size_t offset = 0; offset < size; offset += static_cast<size_t>(pageSize)) {
+            sum = static_cast<unsigned char>(sum + bytes[offset]);
+        }
+        munmap(map, size);
+        worker->result->bytes += size;
+        worker->Record(start, true);
+    }
+}
+
+// Write one buffer fully; false on error
+static bool WriteAll(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Time a step that makes data durable
+static bool Commit(Worker *worker, bool ok, uint64_t startNs) {
+    worker->result->commit.Record(MonotonicNs() - startNs);
+    return ok;
+}
+
+// Small appends to one file per thread, like a log; an op is one write
+static void RunAppend(Worker *worker, uint64_t deadlineNs) {
+    std::vector<char> buffer(worker->config->block, 'a');
+    std::string path = worker->WriteDir() + "/append.log";
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_TRUNC, 0644);
+    if (fd < 0) {
+        worker->Record(MonotonicNs(), false);
+        return;
+    }
+    while (MonotonicNs() < deadlineNs) {
+        uint64_t start = MonotonicNs();
+        bool ok = WriteAll(fd, buffer.data(), buffer.size());
+        worker->Record(start, ok);
+        if (ok) {
+            worker->result->bytes += buffer.size();
+        }
+    }
+    uint64_t start = MonotonicNs();
+    Commit(worker, close(fd) == 0, start);
+}
+
+// Large files written front to back and closed, like cp; an op is one write
+static void RunStream(Worker *worker, uint64_t deadlineNs) {
+    std::vector<char> buffer(worker->config->block, 's');
+    std::string dir = worker->WriteDir();
+    for (uint64_t file = 0; MonotonicNs() < deadlineNs; file++) {
+        std::string path = dir + "/stream" + std::to_string(file);
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            worker->Record(MonotonicNs(), false);
+            continue;
+        }
+        for (uint64_t written = 0; written < worker->config->fileSize && MonotonicNs() < deadlineNs; ) {
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(buffer.size(), worker->config->fileSize - written));
+            uint64_t start = MonotonicNs();
+            bool ok = WriteAll(fd, buffer.data(), chunk);
+            worker->Record(start, ok);
+            if (!ok) {
+                break;
+            }
+            written += chunk;
+            worker->result->bytes += chunk;
+        }
+        uint64_t start = MonotonicNs();
+        Commit(worker, close(fd) == 0, start);
+        unlink(path.c_str());
+    }
+}
+
+// The system calls tar makes extracting many small files into nested
+// directories: create, write, set mode and times, close. An op is one file.
+static void RunUntar(Worker *worker, uint64_t deadlineNs) {
+    std::vector<char> buffer(worker->config->block, 't');
+    std::string root = worker->WriteDir();
+    std::string dir;
+    for (uint64_t file = 0; MonotonicNs() < deadlineNs; file++) {
+        uint64_t start = MonotonicNs();
+        if (file % 100 == 0) {
+            dir = root + "/x" + std::to_string(file / 100);
+            mkdir(dir.c_str(), 0755);
+        }
+
+        std::string path = dir + "/file" + std::to_string(file);
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600);
+        bool ok = fd >= 0;
+        if (ok) {
+            ok = WriteAll(fd, buffer.data(), buffer.size());
+            ok = fchmod(fd, 0644) == 0 && ok;
+            struct timespec times[2] = { { 1000000000, 0 }, { 1000000000, 0 } };
+            ok = futimens(fd, times) == 0 && ok;
+            uint64_t closeStart = MonotonicNs();
+            ok = Commit(worker, close(fd) == 0, closeStart) && ok;
+        }
+        worker->Record(start, ok);
+        if (ok) {
+            worker->result->bytes += buffer.size();
+        }
+    }
+}
+
+// How git and editors replace a file safely: write a temporary, fsync it,
+// close and rename it over the target. An op is one whole sequence.
+static void RunFsyncRename(Worker *worker, uint64_t deadlineNs) {
+    std::vector<char> buffer(worker->config->block, 'g');
+    std::string dir = worker->WriteDir();
+    for (uint64_t file = 0; MonotonicNs() < deadlineNs; file++) {
+        std::string target = dir + "/object" + std::to_string(file % 64);
+        std::string temp = target + ".tmp";
+        uint64_t start = MonotonicNs();
+        int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        bool ok = fd >= 0;
+        if (ok) {
+            ok = WriteAll(fd, buffer.data(), buffer.size());
+            uint64_t commitStart = MonotonicNs();
+            ok = fsync(fd) == 0 && ok;
+            ok = close(fd) == 0 && ok;
+            ok = rename(temp.c_str(), target.c_str()) == 0 && ok;
+            Commit(worker, ok, commitStart);
+        }
+        worker->Record(start, ok);
+        if (ok) {
+            worker->result->bytes += buffer.size();
+        }
+    }
+}
+
+struct Workload {
+    const char *name;
+    WorkloadFn run;
+    const char *unit;  // What one op is
+    size_t block;      // Default -b
+};
+
+static const Workload kWorkloads[] = {
+    { "stat", RunStat, "stat of a random file", 0 },
+    { "readdir", RunReaddir, "listing of a random directory", 0 },
+    { "lsl", RunListLong, "listing plus lstat of every entry (ls -l)", 0 },
+    { "find", RunFind, "directory visited in one walk of the tree", 0 },
+    { "findls", RunFindLong, "directory visited in one walk of the tree, with lstat of every entry", 0 },
+    { "seqread", RunSequentialRead, "read of one block, files read front to back", 1 << 20 },
+    { "randread", RunRandomRead, "pread of one block at a random aligned offset", 4096 },
+    { "smallfiles", RunSmallFiles, "open, read to the end and close of a random file", 64 << 10 },
+    { "mmap", RunMmap, "mmap of a random file with every page touched", 0 },
+    { "append", RunAppend, "append of one block to a per-thread log", 4096 },
+    { "stream", RunStream, "write of one block, files written front to back", 1 << 20 },
+    { "untar", RunUntar, "file extracted: create, write, fchmod, futimens, close", 8192 },
+    { "fsyncrename", RunFsyncRename, "write, fsync, close and rename of a temporary file", 16384 },
+};
+
+static void PrintLatency(const char *name, const HistogramSnapshot& latency) {
+    printf("\"%s\":{\"count\":%llu,\"mean\":%.1f,\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f}",
+           name, static_cast<unsigned long long>(latency.count), latency.MeanUs(), latency.PercentileUs(0.5),
+           latency.PercentileUs(0.9), latency.PercentileUs(0.99), latency.PercentileUs(0.999),
+           static_cast<double>(latency.maxNs) / 1000.0);
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s -w workload [-t threads] [-d seconds] [-D depth] [-F fanout] [-f files] [-s seed] mountpoint\n"
+            "  -w  one of:", program);
+    for (const Workload& workload : kWorkloads) {
+        fprintf(stderr, " %s", workload.name);
+    }
+    fprintf(stderr,
+            "\n  -t  threads (default 1)\n"
+            "  -d  seconds to run (default 5; find and findls stop early once the walk is done)\n"
+            "  -D, -F, -f  tree depth, subdirectories and files per directory (default 2, 10, 100)\n"
+            "  -b  bytes per read or write (default: 1 MiB seqread/stream, 4 KiB randread/append,\n"
+            "      64 KiB smallfiles, 8 KiB untar, 16 KiB fsyncrename)\n"
+            "  -S  file size for stream (default 1 GiB)\n"
+            "  -s  random seed (default 1)\n");
+}
+
+int main(int argc, char **argv) {
+    Config config;
+    int option;
+    while ((option = getopt(argc, argv, "w:t:d:D:F:f:b:S:s:h")) != -1) {
+        switch (option) {
+            case 'w': config.workload = optarg; break;
+            case 't': config.threads = atoi(optarg); break;
+            case 'd': config.seconds = atof(optarg); break;
+            case 'D': config.depth = atoi(optarg); break;
+            case 'F': config.fanout = atoi(optarg); break;
+            case 'f': config.files = atoi(optarg); break;
+            case 'b': config.block = static_cast<size_t>(strtoull(optarg, nullptr, 10)); break;
+            case 'S': config.fileSize = strtoull(optarg, nullptr, 10); break;
+            case 's': config.seed = static_cast<unsigned>(strtoul(optarg, nullptr, 10)); break;
+            default: Usage(argv[0]); return option == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc - 1 || config.threads < 1 || config.seconds <= 0 || config.depth < 0 ||
+        config.fanout < 1 || config.files < 1) {
+        Usage(argv[0]);
+        return 2;
+    }
+    config.root = argv[optind];
+
+    const Workload *workload = nullptr;
+    for (const Workload& candidate : kWorkloads) {
+        if (config.workload == candidate.name) {
+            workload = &candidate;
+        }
+    }
+    if (!workload) {
+        Usage(argv[0]);
+        return 2;
+    }
+    if (config.block == 0) {
+        config.block = workload->block;
+    }
+    g_find.pending.push_back(config.root);
+
+    std::unique_ptr<ThreadResult[]> results(new ThreadResult[config.threads]);
+    std::vector<std::thread> threads;
+    uint64_t startNs = MonotonicNs();
+    uint64_t deadlineNs = startNs + static_cast<uint64_t>(config.seconds * 1e9);
+    for (int i = 0; i < config.threads; i++) {
+        threads.emplace_back([&config, &results, workload, deadlineNs, i]() {
+            Worker worker = { &config, std::mt19937_64(config.seed + static_cast<unsigned>(i)), &results[i], i };
+            workload->run(&worker, deadlineNs);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double elapsed = static_cast<double>(MonotonicNs() - startNs) / 1e9;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double cpu = static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+                 static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+
+    HistogramSnapshot latency;
+    HistogramSnapshot commit;
+    uint64_t ops = 0;
+    uint64_t entries = 0;
+    uint64_t bytes = 0;
+    uint64_t errors = 0;
+    for (int i = 0; i < config.threads; i++) {
+        results[i].latency.AddTo(&latency);
+        results[i].commit.AddTo(&commit);
+        ops += results[i].ops;
+        entries += results[i].entries;
+        bytes += results[i].bytes;
+        errors += results[i].errors;
+    }
+
+    printf("{\"workload\":\"%s\",\"unit\":\"%s\",\"threads\":%d,\"seconds\":%.3f,"
+           "\"ops\":%llu,\"opsPerSec\":%.1f,\"entries\":%llu,\"entriesPerSec\":%.1f,\"errors\":%llu,"
+           "\"block\":%zu,\"bytes\":%llu,\"mbPerSec\":%.1f,\"cpuSeconds\":%.3f,",
+           workload->name, workload->unit, config.threads, elapsed,
+           static_cast<unsigned long long>(ops), static_cast<double>(ops) / elapsed,
+           static_cast<unsigned long long>(entries), static_cast<double>(entries) / elapsed,
+           static_cast<unsigned long long>(errors),
+           config.block, static_cast<unsigned long long>(bytes), static_cast<double>(bytes) / 1e6 / elapsed, cpu);
+    printf("\"threadOps\":[");
+    for (int i = 0; i < config.threads; i++) {
+        printf("%s%llu", i == 0 ? "" : ",", static_cast<unsigned long long>(results[i].ops));
+    }
+    printf("],");
+    PrintLatency("latencyUs", latency);
+    if (commit.count > 0) {
+        printf(",");
+        PrintLatency("commitUs", commit);
+    }
+    printf("}\n");
+    return errors > 0 && ops == errors ? 1 : 0;
+}
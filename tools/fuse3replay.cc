@@ -0,0 +1,374 @@
+// fuse3replay: re-issue a recorded request stream against a mount.
+//
+// Reads a file written by startRecording() and replays every request as the
+// matching system call under the mount point, at the original pace or
+// faster. Requests of one process always go to the same worker thread, so
+// each process sees its own requests in the recorded order.
+//
+//   fuse3replay [-s speed] [-t threads] recording mountpoint
+//   fuse3replay -l recording            (print the records)
+//
+// Prints one JSON object comparing replayed and recorded latency per op.
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../fuse3_record.h"
+#include "../fuse3_stats.h"
+
+struct Request {
+    RecordEntry entry;
+    std::string path;
+    std::string path2;
+};
+
+struct WorkerResult {
+    Histogram latency[kOpCount];
+    Histogram recorded[kOpCount];
+    Histogram late;          // How far behind schedule requests were issued
+    uint64_t errors[kOpCount] = {};
+    uint64_t mismatches = 0; // Succeeded where the recording failed, or the other way round
+    uint64_t skipped = 0;    // No system call to replay it with
+    uint64_t replayed = 0;
+};
+
+static bool ReadRecording(const char *file, RecordFileHeader *header, std::vector<Request> *requests) {
+    FILE *in = fopen(file, "rb");
+    if (!in) {
+        fprintf(stderr, "%s: %s\n", file, strerror(errno));
+        return false;
+    }
+    if (fread(header, sizeof(*header), 1, in) != 1 || memcmp(header->magic, kRecordMagic, sizeof(kRecordMagic)) != 0) {
+        fprintf(stderr, "%s: not a fuse3 recording\n", file);
+        fclose(in);
+        return false;
+    }
+    if (header->version != kRecordVersion) {
+        fprintf(stderr, "%s: recording version %u, this tool reads version %u\n", file, header->version,
+                kRecordVersion);
+        fclose(in);
+        return false;
+    }
+
+    Request request;
+    while (fread(&request.entry, sizeof(request.entry), 1, in) == 1) {
+        request.path.resize(request.entry.pathLength);
+        request.path2.resize(request.entry.path2Length);
+        if (fread(&request.path[0], 1, request.path.size(), in) != request.path.size() ||
+            fread(&request.path2[0], 1, request.path2.size(), in) != request.path2.size()) {
+            fprintf(stderr, "%s: truncated after %zu records\n", file, requests->size());
+            break;
+        }
+        requests->push_back(request);
+    }
+    fclose(in);
+    return true;
+}
+
+// One worker: its share of the requests, in recorded order
+class Replayer {
+public:
+    Replayer(const std::string& root, double speed, uint64_t startNs, WorkerResult *result)
+        : root_(root), speed_(speed), startNs_(startNs), result_(result) {}
+
+    ~Replayer() {
+        for (auto& entry : fds_) {
+            for (int fd : entry.second) {
+                close(fd);
+            }
+        }
+    }
+
+    void Run(const std::vector<const Request*>& requests) {
+        for (const Request *request : requests) {
+            Wait(request->entry.startNs);
+            Replay(*request);
+        }
+    }
+
+private:
+    void Wait(uint64_t recordedNs) {
+        if (speed_ <= 0) {
+            return;
+        }
+        uint64_t due = startNs_ + static_cast<uint64_t>(static_cast<double>(recordedNs) / speed_);
+        uint64_t now = MonotonicNs();
+        if (now < due) {
+            struct timespec pause = { static_cast<time_t>((due - now) / 1000000000ULL),
+                                      static_cast<long>((due - now) % 1000000000ULL) };
+            nanosleep(&pause, nullptr);
+        } else {
+            result_->late.Record(now - due);
+        }
+    }
+
+    // A handle the recording opened, or one opened now when recording
+    // started after the file was opened
+    int Handle(const std::string& path) {
+        std::vector<int>& open = fds_[path];
+        if (open.empty()) {
+            int fd = ::open(path.c_str(), O_RDWR);
+            if (fd < 0) {
+                fd = ::open(path.c_str(), O_RDONLY);
+            }
+            if (fd < 0) {
+                return -1;
+            }
+            open.push_back(fd);
+        }
+        return open.back();
+    }
+
+    void Push(const std::string& path, int fd) {
+        if (fd >= 0) {
+            fds_[path].push_back(fd);
+        }
+    }
+
+    int Release(const std::string& path) {
+        std::vector<int>& open = fds_[path];
+        if (open.empty()) {
+            return 0;
+        }
+        int result = close(open.back());
+        open.pop_back();
+        return result;
+    }
+
+    // The request's system call; -1 with errno set on failure, -2 if it has none
+    int Issue(const Request& request, std::vector<char> *buffer) {
+        const RecordEntry& entry = request.entry;
+        std::string path = root_ + request.path;
+        std::string path2 = root_ + request.path2;
+        if (entry.size > buffer->size()) {
+            buffer->resize(entry.size, 'r');
+        }
+
+        switch (static_cast<FuseOp>(entry.op)) {
+            case kOpGetattr: {
+                struct stat st;
+                return lstat(path.c_str(), &st);
+            }
+            case kOpReaddir: {
+                DIR *dir = opendir(path.c_str());
+                if (!dir) {
+                    return -1;
+                }
+                while (readdir(dir) != nullptr) {
+                }
+                return closedir(dir);
+            }
+            case kOpOpen: {
+                int fd = open(path.c_str(), static_cast<int>(entry.flags) & ~(O_CREAT | O_EXCL | O_TRUNC));
+                Push(path, fd);
+                return fd < 0 ? -1 : 0;
+            }
+            case kOpCreate: {
+                int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, entry.flags & 07777);
+                Push(path, fd);
+                return fd < 0 ? -1 : 0;
+            }
+            case kOpRead: {
+                int fd = Handle(path);
+                return fd < 0 ? -1 : static_cast<int>(pread(fd, buffer->data(), entry.size, static_cast<off_t>(entry.offset)) < 0 ? -1 : 0);
+            }
+            case kOpWrite:
+            case kOpWriteBuf: {
+                int fd = Handle(path);
+                return fd < 0 ? -1 : static_cast<int>(pwrite(fd, buffer->data(), entry.size, static_cast<off_t>(entry.offset)) < 0 ? -1 : 0);
+            }
+            case kOpRelease:
+                return Release(path);
+            case kOpFsync: {
+                int fd = Handle(path);
+                return fd < 0 ? -1 : fsync(fd);
+            }
+            case kOpUnlink:
+                return unlink(path.c_str());
+            case kOpMkdir:
+                return mkdir(path.c_str(), entry.flags & 07777);
+            case kOpRmdir:
+                return rmdir(path.c_str());
+            case kOpRename:
+                return rename(path.c_str(), path2.c_str());
+            case kOpChmod:
+                return chmod(path.c_str(), entry.flags & 07777);
+            case kOpTruncate:
+                return truncate(path.c_str(), static_cast<off_t>(entry.offset));
+            case kOpUtimens:
+                return utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+            case kOpAccess:
+                return access(path.c_str(), static_cast<int>(entry.flags));
+            case kOpStatfs: {
+                struct statvfs st;
+                return statvfs(path.c_str(), &st);
+            }
+            default:
+                // flush happens on close; chown needs privileges the replayer should not assume;
+                // copy_file_range needs both handles
+                return -2;
+        }
+    }
+
+    void Replay(const Request& request) {
+        FuseOp op = static_cast<FuseOp>(request.entry.op);
+        if (op >= kOpCount) {
+            result_->skipped++;
+            return;
+        }
+
+        uint64_t start = MonotonicNs();
+        int result = Issue(request, &buffer_);
+        if (result == -2) {
+            result_->skipped++;
+            return;
+        }
+
+        result_->latency[op].Record(MonotonicNs() - start);
+        result_->recorded[op].Record(static_cast<uint64_t>(request.entry.durationUs) * 1000);
+        result_->replayed++;
+        if (result < 0) {
+            result_->errors[op]++;
+        }
+        if ((result < 0) != (request.entry.result < 0)) {
+            result_->mismatches++;
+        }
+    }
+
+    std::string root_;
+    double speed_;
+    uint64_t startNs_;
+    WorkerResult *result_;
+    std::map<std::string, std::vector<int>> fds_;
+    std::vector<char> buffer_;
+};
+
+static void List(const RecordFileHeader& header, const std::vector<Request>& requests) {
+    printf("# %zu requests%s\n", requests.size(), header.flags & kRecordHashedPaths ? ", hashed paths" : "");
+    printf("# ms op pid result path [path2] offset size flags durationUs\n");
+    for (const Request& request : requests) {
+        const RecordEntry& entry = request.entry;
+        printf("%.3f %s %u %d %s%s%s %llu %u %#o %u\n", static_cast<double>(entry.startNs) / 1e6,
+               OpName(static_cast<FuseOp>(entry.op)), entry.pid, entry.result, request.path.c_str(),
+               request.path2.empty() ? "" : " ", request.path2.c_str(),
+               static_cast<unsigned long long>(entry.offset), entry.size, entry.flags, entry.durationUs);
+    }
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [-s speed] [-t threads] recording mountpoint\n"
+            "       %s -l recording\n"
+            "  -s  1 replays at the recorded pace (default), 10 ten times faster, 0 as fast as possible\n"
+            "  -t  worker threads (default 8); each process's requests stay on one worker\n"
+            "  -l  print the records instead of replaying them\n",
+            program, program);
+}
+
+int main(int argc, char **argv) {
+    double speed = 1;
+    int threads = 8;
+    bool list = false;
+
+    int option;
+    while ((option = getopt(argc, argv, "s:t:lh")) != -1) {
+        switch (option) {
+            case 's': speed = atof(optarg); break;
+            case 't': threads = atoi(optarg); break;
+            case 'l': list = true; break;
+            default: Usage(argv[0]); return option == 'h' ? 0 : 2;
+        }
+    }
+    if (argc - optind != (list ? 1 : 2) || threads < 1 || speed < 0) {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    RecordFileHeader header;
+    std::vector<Request> requests;
+    if (!ReadRecording(argv[optind], &header, &requests)) {
+        return 1;
+    }
+    if (list) {
+        List(header, requests);
+        return 0;
+    }
+
+    std::string root = argv[optind + 1];
+    while (root.size() > 1 && root.back() == '/') {
+        root.pop_back();
+    }
+
+    std::vector<std::vector<const Request*>> shares(threads);
+    for (const Request& request : requests) {
+        shares[request.entry.pid % static_cast<uint32_t>(threads)].push_back(&request);
+    }
+
+    std::unique_ptr<WorkerResult[]> results(new WorkerResult[threads]);
+    std::vector<std::thread> workers;
+    uint64_t startNs = MonotonicNs();
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back([&, i]() {
+            Replayer replayer(root, speed, startNs, &results[i]);
+            replayer.Run(shares[i]);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double elapsed = static_cast<double>(MonotonicNs() - startNs) / 1e9;
+
+    HistogramSnapshot late;
+    uint64_t replayed = 0;
+    uint64_t skipped = 0;
+    uint64_t mismatches = 0;
+    for (int i = 0; i < threads; i++) {
+        results[i].late.AddTo(&late);
+        replayed += results[i].replayed;
+        skipped += results[i].skipped;
+        mismatches += results[i].mismatches;
+    }
+
+    printf("{\"records\":%zu,\"replayed\":%llu,\"skipped\":%llu,\"mismatches\":%llu,\"seconds\":%.3f,\"speed\":%g,"
+           "\"hashedPaths\":%s,\"lateUs\":{\"count\":%llu,\"p50\":%.1f,\"p99\":%.1f,\"max\":%.1f},\"ops\":{",
+           requests.size(), static_cast<unsigned long long>(replayed), static_cast<unsigned long long>(skipped),
+           static_cast<unsigned long long>(mismatches), elapsed, speed,
+           header.flags & kRecordHashedPaths ? "true" : "false", static_cast<unsigned long long>(late.count),
+           late.PercentileUs(0.5), late.PercentileUs(0.99), static_cast<double>(late.maxNs) / 1000.0);
+
+    bool first = true;
+    for (int op = 0; op < kOpCount; op++) {
+        HistogramSnapshot latency;
+        HistogramSnapshot recorded;
+        uint64_t errors = 0;
+        for (int i = 0; i < threads; i++) {
+            results[i].latency[op].AddTo(&latency);
+            results[i].recorded[op].AddTo(&recorded);
+            errors += results[i].errors[op];
+        }
+        if (latency.count == 0) {
+            continue;
+        }
+        printf("%s\"%s\":{\"count\":%llu,\"errors\":%llu,\"p50Us\":%.1f,\"p99Us\":%.1f,"
+               "\"recordedP50Us\":%.1f,\"recordedP99Us\":%.1f}",
+               first ? "" : ",", OpName(static_cast<FuseOp>(op)), static_cast<unsigned long long>(latency.count),
+               static_cast<unsigned long long>(errors), latency.PercentileUs(0.5), latency.PercentileUs(0.99),
+               recorded.PercentileUs(0.5), recorded.PercentileUs(0.99));
+        first = false;
+    }
+    printf("}}\n");
+    return 0;
+}
@@ -0,0 +1,347 @@
+// fuse3top: live view of running fuse3_napi mounts, like top for the bridge.
+//
+// Reads the control directory each mount serves natively (controlDir mount
+// option), so it keeps working while a mount's JS event loop is stuck.
+//
+//   fuse3top [-d seconds] [-n iterations] [-c name] [mountpoint...]
+//
+// Without mount points, every fuse.fuse3_napi mount in /proc/self/mounts is shown.
+
+#include <ctype.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+typedef std::map<std::string, std::string> KeyValues;
+typedef std::vector<std::pair<uint64_t, uint64_t>> Buckets;  // (upper bound ns, count)
+
+static const int kTopRows = 5;
+
+// One reading of a mount's control files
+struct Sample {
+    bool ok = false;
+    double time = 0;
+    KeyValues stats;
+    KeyValues queues;
+    KeyValues hotPaths;
+    std::map<std::string, Buckets> histograms;
+};
+
+struct Mount {
+    std::string path;
+    Sample previous;
+};
+
+static double Now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+// "key value" lines; the value is the rest of the line
+static bool ReadKeyValues(const std::string& path, KeyValues *out) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t space = line.find(' ');
+        if (space != std::string::npos) {
+            (*out)[line.substr(0, space)] = line.substr(space + 1);
+        }
+    }
+    return true;
+}
+
+static uint64_t Number(const KeyValues& values, const std::string& key) {
+    auto it = values.find(key);
+    return it != values.end() ? strtoull(it->second.c_str(), nullptr, 10) : 0;
+}
+
+// Growth of a counter between samples; a reset (resetStats) starts over from 0
+static uint64_t Delta(const KeyValues& now, const KeyValues& before, const std::string& key) {
+    uint64_t current = Number(now, key);
+    uint64_t earlier = Number(before, key);
+    return current >= earlier ? current - earlier : current;
+}
+
+static Buckets ParseBuckets(const std::string& text) {
+    Buckets buckets;
+    std::istringstream in(text);
+    std::string pair;
+    while (in >> pair) {
+        size_t colon = pair.find(':');
+        if (colon != std::string::npos) {
+            buckets.emplace_back(strtoull(pair.c_str(), nullptr, 10), strtoull(pair.c_str() + colon + 1, nullptr, 10));
+        }
+    }
+    return buckets;
+}
+
+static Sample ReadSample(const std::string& controlPath) {
+    Sample sample;
+    sample.time = Now();
+    sample.ok = ReadKeyValues(controlPath + "/stats", &sample.stats);
+    if (!sample.ok) {
+        return sample;
+    }
+    ReadKeyValues(controlPath + "/queues", &sample.queues);
+    ReadKeyValues(controlPath + "/hotpaths", &sample.hotPaths);
+
+    KeyValues histograms;
+    ReadKeyValues(controlPath + "/histograms", &histograms);
+    for (const auto& entry : histograms) {
+        sample.histograms[entry.first] = ParseBuckets(entry.second);
+    }
+    return sample;
+}
+
+// Buckets recorded since the previous sample
+static Buckets Subtract(const Buckets& now, const Buckets& before) {
+    std::map<uint64_t, uint64_t> earlier(before.begin(), before.end());
+    Buckets delta;
+    for (const auto& bucket : now) {
+        uint64_t count = bucket.second - std::min(bucket.second, earlier[bucket.first]);
+        if (count > 0) {
+            delta.emplace_back(bucket.first, count);
+        }
+    }
+    return delta;
+}
+
+// Upper bound of the bucket holding quantile q, in microseconds
+static double PercentileUs(const Buckets& buckets, double q) {
+    uint64_t total = 0;
+    for (const auto& bucket : buckets) {
+        total += bucket.second;
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(ceil(q * static_cast<double>(total))));
+    uint64_t seen = 0;
+    for (const auto& bucket : buckets) {
+        seen += bucket.second;
+        if (seen >= target) {
+            return static_cast<double>(bucket.first) / 1000.0;
+        }
+    }
+    return static_cast<double>(buckets.back().first) / 1000.0;
+}
+
+// Mount points in /proc/mounts escape space, tab, newline and backslash as octal
+static std::string UnescapeMountPath(const std::string& path) {
+    std::string out;
+    for (size_t i = 0; i < path.size(); i++) {
+        if (path[i] == '\\' && i + 3 < path.size() && isdigit(static_cast<unsigned char>(path[i + 1]))) {
+            out += static_cast<char>(strtol(path.substr(i + 1, 3).c_str(), nullptr, 8));
+            i += 3;
+        } else {
+            out += path[i];
+        }
+    }
+    return out;
+}
+
+static std::vector<std::string> FindMounts() {
+    std::vector<std::string> mounts;
+    std::ifstream file("/proc/self/mounts");
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        std::string device;
+        std::string mountPoint;
+        std::string type;
+        if (in >> device >> mountPoint >> type && type == "fuse.fuse3_napi") {
+            mounts.push_back(UnescapeMountPath(mountPoint));
+        }
+    }
+    return mounts;
+}
+
+static std::string ProcessName(const std::string& pid) {
+    std::ifstream file("/proc/" + pid + "/comm");
+    std::string name;
+    if (!std::getline(file, name)) {
+        return "?";
+    }
+    return name;
+}
+
+static std::string HitRate(const Sample& now, const Sample& before, const char *kind) {
+    std::string prefix = std::string("cache.") + kind + ".";
+    uint64_t hits = Delta(now.stats, before.stats, prefix + "hits");
+    uint64_t misses = Delta(now.stats, before.stats, prefix + "misses");
+    if (hits + misses == 0) {
+        return "-";
+    }
+    char text[16];
+    snprintf(text, sizeof(text), "%.1f%%", 100.0 * static_cast<double>(hits) / static_cast<double>(hits + misses));
+    return text;
+}
+
+// Histogram series recorded since the previous sample
+static Buckets Interval(const Sample& now, const Sample& before, const std::string& series) {
+    auto current = now.histograms.find(series);
+    if (current == now.histograms.end()) {
+        return Buckets();
+    }
+    auto previous = before.histograms.find(series);
+    return previous != before.histograms.end() ? Subtract(current->second, previous->second) : current->second;
+}
+
+static void PrintMount(const Mount& mount, const Sample& now, const Sample& before) {
+    double seconds = before.ok ? now.time - before.time : 0;
+    printf("%s  in flight %llu  waiting for JS %llu  queued %llu  attr cache %s  data cache %s\n",
+           mount.path.c_str(),
+           static_cast<unsigned long long>(Number(now.queues, "requests.inflight")),
+           static_cast<unsigned long long>(Number(now.queues, "requests.waitingForJs")),
+           static_cast<unsigned long long>(Number(now.queues, "requests.queued")),
+           HitRate(now, before, "attr").c_str(), HitRate(now, before, "data").c_str());
+
+    Buckets lag = Interval(now, before, "eventLoopLag");
+    auto degraded = now.stats.find("eventLoopLag.degraded");
+    printf("event loop lag  p50 %.1fus  p99 %.1fus  now %sus%s\n", PercentileUs(lag, 0.5), PercentileUs(lag, 0.99),
+           now.stats.count("eventLoopLag.currentUs") ? now.stats.at("eventLoopLag.currentUs").c_str() : "-",
+           degraded != now.stats.end() && degraded->second == "true" ? "  DEGRADED (serving stale attributes)" : "");
+
+    // Rates and percentiles over the last interval; the first screen covers everything since mount
+    printf("%-16s %10s %8s %9s %10s %10s %10s %10s\n", before.ok ? "OP" : "OP (total)",
+           before.ok ? "REQ/s" : "REQ", before.ok ? "ERR/s" : "ERR", before.ok ? "MB/s" : "MB",
+           "P50us", "P90us", "P99us", "P999us");
+    for (const auto& entry : now.stats) {
+        const std::string& key = entry.first;
+        if (key.compare(0, 4, "ops.") != 0 || key.size() < 10 || key.compare(key.size() - 6, 6, ".count") != 0) {
+            continue;
+        }
+        std::string op = key.substr(4, key.size() - 10);
+        if (op.find('.') != std::string::npos) {
+            continue;  // A stage's count
+        }
+
+        std::string prefix = "ops." + op + ".";
+        double count = static_cast<double>(Delta(now.stats, before.stats, prefix + "count"));
+        double errors = static_cast<double>(Delta(now.stats, before.stats, prefix + "errors"));
+        double bytes = static_cast<double>(Delta(now.stats, before.stats, prefix + "bytes"));
+        if (count == 0) {
+            continue;
+        }
+        if (seconds > 0) {
+            count /= seconds;
+            errors /= seconds;
+            bytes /= seconds;
+        }
+
+        Buckets latency = Interval(now, before, prefix + "latency");
+
+        printf("%-16s %10.1f %8.1f %9.2f %10.1f %10.1f %10.1f %10.1f\n", op.c_str(), count, errors, bytes / 1e6,
+               PercentileUs(latency, 0.5), PercentileUs(latency, 0.9), PercentileUs(latency, 0.99),
+               PercentileUs(latency, 0.999));
+    }
+
+    // Hot lists are cumulative since mount (or resetHotPaths)
+    printf("\n%-48s %s\n", "TOP PATHS (requests)", "TOP PROCESSES (requests)");
+    for (int rank = 1; rank <= kTopRows; rank++) {
+        std::string pathPrefix = "paths.byCount." + std::to_string(rank) + ".";
+        std::string pidPrefix = "pids.byCount." + std::to_string(rank) + ".";
+        auto path = now.hotPaths.find(pathPrefix + "path");
+        auto pid = now.hotPaths.find(pidPrefix + "pid");
+        if (path == now.hotPaths.end() && pid == now.hotPaths.end()) {
+            break;
+        }
+
+        char left[64] = "";
+        if (path != now.hotPaths.end()) {
+            snprintf(left, sizeof(left), "%10llu %.36s",
+                     static_cast<unsigned long long>(Number(now.hotPaths, pathPrefix + "count")), path->second.c_str());
+        }
+        printf("%-48s", left);
+        if (pid != now.hotPaths.end()) {
+            printf(" %10llu %7s %s", static_cast<unsigned long long>(Number(now.hotPaths, pidPrefix + "count")),
+                   pid->second.c_str(), ProcessName(pid->second).c_str());
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [-d seconds] [-n iterations] [-c name] [mountpoint...]\n"
+            "  -d  seconds between updates (default 1)\n"
+            "  -n  stop after this many updates (default: run until interrupted)\n"
+            "  -c  control directory name (default .fuse3)\n",
+            program);
+}
+
+int main(int argc, char **argv) {
+    double interval = 1.0;
+    long iterations = -1;
+    std::string controlDir = ".fuse3";
+
+    int option;
+    while ((option = getopt(argc, argv, "d:n:c:h")) != -1) {
+        switch (option) {
+            case 'd': interval = atof(optarg); break;
+            case 'n': iterations = atol(optarg); break;
+            case 'c': controlDir = optarg; break;
+            default: Usage(argv[0]); return option == 'h' ? 0 : 2;
+        }
+    }
+    if (interval <= 0) {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Mount> mounts;
+    std::vector<std::string> paths;
+    for (int i = optind; i < argc; i++) {
+        paths.push_back(argv[i]);
+    }
+    if (paths.empty()) {
+        paths = FindMounts();
+    }
+    if (paths.empty()) {
+        fprintf(stderr, "%s: no fuse3_napi mounts found\n", argv[0]);
+        return 1;
+    }
+    for (const std::string& path : paths) {
+        mounts.push_back({path, Sample()});
+    }
+
+    bool terminal = isatty(STDOUT_FILENO);
+    for (long round = 0; iterations < 0 || round < iterations; round++) {
+        if (round > 0) {
+            usleep(static_cast<useconds_t>(interval * 1e6));
+        }
+        if (terminal) {
+            printf("\033[H\033[2J");
+        }
+
+        for (Mount& mount : mounts) {
+            Sample sample = ReadSample(mount.path + "/" + controlDir);
+            if (!sample.ok) {
+                printf("%s  no control directory (mount with controlDir: true)\n\n", mount.path.c_str());
+                continue;
+            }
+            PrintMount(mount, sample, mount.previous);
+            mount.previous = std::move(sample);
+        }
+        fflush(stdout);
+    }
+    return 0;
+}